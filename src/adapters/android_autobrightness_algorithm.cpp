@@ -18,6 +18,7 @@
 
 #include "android_autobrightness_algorithm.h"
 #include "brightness_params.h"
+#include "chrono.h"
 #include "device_config.h"
 #include "event_loop.h"
 #include "event_loop_handler_registration.h"
@@ -38,7 +39,14 @@ auto const null_handler = [](auto){};
 auto constexpr smoothing_factor_slow = 2000.0;
 auto constexpr smoothing_factor_fast = 200.0;
 auto constexpr hysteresis_factor = 0.1;
+auto constexpr min_hysteresis = 2.0;
 auto constexpr debounce_delay = std::chrono::seconds{4};
+// Light values up to this old when starting are assumed to still hold,
+// until the light sensor reports otherwise
+auto constexpr warm_start_max_light_age = std::chrono::seconds{60};
+// Covers the light levels of most indoor environments with a 32KiB table,
+// brighter light levels are interpolated directly
+auto constexpr brightness_spline_lookup_table_size = 4096u;
 
 std::vector<int> parse_int_array(std::string const& str)
 {
@@ -80,7 +88,10 @@ try
         points.push_back({static_cast<double>(*l_iter), static_cast<double>(*b_iter)});
     }
 
-    return std::make_unique<repowerd::MonotoneSpline>(points);
+    auto spline = std::make_unique<repowerd::MonotoneSpline>(points);
+    spline->build_lookup_table(brightness_spline_lookup_table_size);
+
+    return spline;
 }
 catch (...)
 {
@@ -93,6 +104,11 @@ double get_max_brightness(repowerd::DeviceConfig const& device_config)
     return brightness_params.max_value;
 }
 
+double hysteresis_for(double light)
+{
+    return std::max(light * hysteresis_factor, min_hysteresis);
+}
+
 double exponential_smoothing(
     double old_average, double new_value, double smoothing_factor)
 {
@@ -103,12 +119,21 @@ double exponential_smoothing(
 
 repowerd::AndroidAutobrightnessAlgorithm::AndroidAutobrightnessAlgorithm(
     DeviceConfig const& device_config,
+    std::shared_ptr<Chrono> const& chrono,
     std::shared_ptr<Log> const& log)
     : brightness_spline{create_brightness_spline(device_config)},
       max_brightness{get_max_brightness(device_config)},
+      chrono{chrono},
       log{log},
+      autobrightness_handler{null_handler},
+      light_event_rate_handler{null_handler},
       started{false},
-      debouncing_seqnum{0}
+      recent_light{0.0},
+      debouncing_seqnum{0},
+      light_event_rate{LightEventRate::normal},
+      processed_light_values{0},
+      debounce_timers{0},
+      fired_debounce_timers{0}
 {
     reset();
 }
@@ -130,8 +155,28 @@ void repowerd::AndroidAutobrightnessAlgorithm::new_light_value(double light)
 
     auto const is_first_light_value = !have_previous_light_values();
 
-    log->log(log_tag, "process_new_light_value(%.2f), is_first_light_value=%d",
-             light, is_first_light_value);
+    ++processed_light_values;
+
+    if (is_first_light_value && warm_started)
+    {
+        warm_started = false;
+        update_averages(light);
+
+        // Only change the brightness we started with if it's clearly off
+        if (fabs(fast_average - applied_light) >= hysteresis_for(applied_light))
+        {
+            notify_brightness(brightness_spline->interpolate(fast_average));
+            applied_light = fast_average;
+        }
+
+        return;
+    }
+
+    if (light_event_rate == LightEventRate::low &&
+        fabs(light - fast_average) >= hysteresis_for(fast_average))
+    {
+        set_light_event_rate(LightEventRate::normal);
+    }
 
     update_averages(light);
 
@@ -152,6 +197,18 @@ void repowerd::AndroidAutobrightnessAlgorithm::start()
     {
         reset();
         started = true;
+
+        if (recent_light_tp != std::chrono::steady_clock::time_point{} &&
+            chrono->steady_now() - recent_light_tp <= warm_start_max_light_age)
+        {
+            log->log(log_tag, "start(), warm start with recent light %.2f", recent_light);
+
+            warm_started = true;
+            fast_average = recent_light;
+            slow_average = recent_light;
+            applied_light = recent_light;
+            notify_brightness(brightness_spline->interpolate(recent_light));
+        }
     }
 }
 
@@ -173,6 +230,30 @@ repowerd::HandlerRegistration repowerd::AndroidAutobrightnessAlgorithm::register
         [this]{ this->autobrightness_handler = null_handler; }};
 }
 
+repowerd::HandlerRegistration repowerd::AndroidAutobrightnessAlgorithm::register_light_event_rate_handler(
+    LightEventRateHandler const& handler)
+{
+    return EventLoopHandlerRegistration{
+        *event_loop,
+        [this, &handler]{ this->light_event_rate_handler = handler; },
+        [this]{ this->light_event_rate_handler = null_handler; }};
+}
+
+uint64_t repowerd::AndroidAutobrightnessAlgorithm::num_processed_light_values() const
+{
+    return processed_light_values;
+}
+
+uint64_t repowerd::AndroidAutobrightnessAlgorithm::num_debounce_timers() const
+{
+    return debounce_timers;
+}
+
+uint64_t repowerd::AndroidAutobrightnessAlgorithm::num_fired_debounce_timers() const
+{
+    return fired_debounce_timers;
+}
+
 void repowerd::AndroidAutobrightnessAlgorithm::reset()
 {
     last_light = 0.0;
@@ -180,8 +261,9 @@ void repowerd::AndroidAutobrightnessAlgorithm::reset()
     applied_light = 0.0;
     fast_average = 0.0;
     slow_average = 0.0;
-    debouncing = false;
-    ++debouncing_seqnum;
+    warm_started = false;
+    cancel_debounce();
+    set_light_event_rate(LightEventRate::normal);
 }
 
 bool repowerd::AndroidAutobrightnessAlgorithm::have_previous_light_values()
@@ -191,7 +273,7 @@ bool repowerd::AndroidAutobrightnessAlgorithm::have_previous_light_values()
 
 void repowerd::AndroidAutobrightnessAlgorithm::update_averages(double light)
 {
-    auto const now = std::chrono::steady_clock::now();
+    auto const now = chrono->steady_now();
 
     if (!have_previous_light_values())
     {
@@ -213,6 +295,8 @@ void repowerd::AndroidAutobrightnessAlgorithm::update_averages(double light)
 
     last_light_tp = now;
     last_light = light;
+    recent_light = fast_average;
+    recent_light_tp = now;
 }
 
 void repowerd::AndroidAutobrightnessAlgorithm::schedule_debounce()
@@ -222,51 +306,97 @@ void repowerd::AndroidAutobrightnessAlgorithm::schedule_debounce()
 
     debouncing = true;
     ++debouncing_seqnum;
+    ++debounce_timers;
 
     log->log(log_tag, "schedule_debounce(), seqnum=%d", debouncing_seqnum);
 
-    event_loop->schedule_in(
+    event_loop->schedule_with_cancellation_in(
         debounce_delay,
         [this, expected_debouncing_seqnum=debouncing_seqnum]
         {
-            if (debouncing_seqnum != expected_debouncing_seqnum)
-            {
-                log->log(log_tag, "debounce() ignored, expected_seqnum=%d, actual_seqnum=%d",
-                         expected_debouncing_seqnum, debouncing_seqnum);
-                return;
-            }
-
-            auto constexpr min_hysteresis = 2.0;
-
-            debouncing = false;
-            update_averages(last_light);
-
-            auto const hysteresis = std::max(applied_light * hysteresis_factor, min_hysteresis);
-            auto const slow_delta = slow_average - applied_light;
-            auto const fast_delta = fast_average - applied_light;
-            log->log(log_tag,
-                     "debounce(), seqnum=%d, applied_light=%.2f, hysteresis=%.2f, "
-                     "slow_average=%.2f, fast_average=%.2f, slow_delta=%.2f, "
-                     "fast_delta=%.2f",
-                     expected_debouncing_seqnum, applied_light, hysteresis, slow_average,
-                     fast_average, slow_delta, fast_delta);
-
-            if ((slow_delta >= hysteresis && fast_delta >= hysteresis) ||
-                (-slow_delta >= hysteresis && -fast_delta >= hysteresis))
-            {
-                log->log(log_tag, "debounce(), apply light %.2f", fast_average);
-                notify_brightness(brightness_spline->interpolate(fast_average));
-                applied_light = fast_average;
-            }
-
-            auto const hysteresis_last_light =
-                std::max(last_light * hysteresis_factor, min_hysteresis);
-
-            if (fabs(fast_average - last_light) >= hysteresis_last_light)
-                schedule_debounce();
+            debounce(expected_debouncing_seqnum);
+        },
+        [this, expected_debouncing_seqnum=debouncing_seqnum]
+        (EventLoopCancellation const& cancellation)
+        {
+            // The debounce may have been cancelled or superseded before
+            // its cancellation became available
+            if (debouncing && debouncing_seqnum == expected_debouncing_seqnum)
+                debounce_cancellation = cancellation;
+            else
+                cancellation();
         });
 }
 
+void repowerd::AndroidAutobrightnessAlgorithm::cancel_debounce()
+{
+    debouncing = false;
+    ++debouncing_seqnum;
+
+    if (debounce_cancellation)
+    {
+        debounce_cancellation();
+        debounce_cancellation = {};
+    }
+}
+
+void repowerd::AndroidAutobrightnessAlgorithm::debounce(int expected_debouncing_seqnum)
+{
+    if (debouncing_seqnum != expected_debouncing_seqnum)
+    {
+        log->log(log_tag, "debounce() ignored, expected_seqnum=%d, actual_seqnum=%d",
+                 expected_debouncing_seqnum, debouncing_seqnum);
+        return;
+    }
+
+    ++fired_debounce_timers;
+
+    // Releases the resources of the fired timer
+    cancel_debounce();
+    update_averages(last_light);
+
+    auto const hysteresis = hysteresis_for(applied_light);
+    auto const slow_delta = slow_average - applied_light;
+    auto const fast_delta = fast_average - applied_light;
+    log->log(log_tag,
+             "debounce(), seqnum=%d, applied_light=%.2f, hysteresis=%.2f, "
+             "slow_average=%.2f, fast_average=%.2f, slow_delta=%.2f, "
+             "fast_delta=%.2f",
+             expected_debouncing_seqnum, applied_light, hysteresis, slow_average,
+             fast_average, slow_delta, fast_delta);
+
+    if ((slow_delta >= hysteresis && fast_delta >= hysteresis) ||
+        (-slow_delta >= hysteresis && -fast_delta >= hysteresis))
+    {
+        log->log(log_tag, "debounce(), apply light %.2f", fast_average);
+        notify_brightness(brightness_spline->interpolate(fast_average));
+        applied_light = fast_average;
+    }
+
+    if (fabs(fast_average - last_light) >= hysteresis_for(last_light))
+    {
+        schedule_debounce();
+    }
+    else if (fabs(fast_average - slow_average) < hysteresis_for(applied_light))
+    {
+        // The averages have converged, so until the light changes
+        // substantially, readings are only needed infrequently
+        set_light_event_rate(LightEventRate::low);
+    }
+}
+
+void repowerd::AndroidAutobrightnessAlgorithm::set_light_event_rate(LightEventRate rate)
+{
+    if (rate == light_event_rate)
+        return;
+
+    log->log(log_tag, "set_light_event_rate(%s)",
+             rate == LightEventRate::low ? "low" : "normal");
+
+    light_event_rate = rate;
+    light_event_rate_handler(rate);
+}
+
 void repowerd::AndroidAutobrightnessAlgorithm::notify_brightness(double brightness)
 {
     return autobrightness_handler(brightness / max_brightness);
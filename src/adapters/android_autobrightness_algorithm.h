@@ -19,12 +19,15 @@
 #pragma once
 
 #include "autobrightness_algorithm.h"
+#include "event_loop.h"
 
+#include <atomic>
 #include <chrono>
 #include <memory>
 
 namespace repowerd
 {
+class Chrono;
 class DeviceConfig;
 class Log;
 class MonotoneSpline;
@@ -34,6 +37,7 @@ class AndroidAutobrightnessAlgorithm : public AutobrightnessAlgorithm
 public:
     AndroidAutobrightnessAlgorithm(
         DeviceConfig const& device_config,
+        std::shared_ptr<Chrono> const& chrono,
         std::shared_ptr<Log> const& log);
 
     ~AndroidAutobrightnessAlgorithm();
@@ -46,21 +50,36 @@ public:
 
     HandlerRegistration register_autobrightness_handler(
         AutobrightnessHandler const& handler) override;
+    HandlerRegistration register_light_event_rate_handler(
+        LightEventRateHandler const& handler) override;
+
+    uint64_t num_processed_light_values() const;
+    uint64_t num_debounce_timers() const;
+    uint64_t num_fired_debounce_timers() const;
 
 private:
     void reset();
     bool have_previous_light_values();
     void update_averages(double light);
     void schedule_debounce();
+    void cancel_debounce();
+    void debounce(int expected_debouncing_seqnum);
+    void set_light_event_rate(LightEventRate rate);
     void notify_brightness(double brightness);
 
     EventLoop* event_loop;
     std::unique_ptr<MonotoneSpline> const brightness_spline;
     double const max_brightness;
+    std::shared_ptr<Chrono> const chrono;
     std::shared_ptr<Log> const log;
     AutobrightnessHandler autobrightness_handler;
+    LightEventRateHandler light_event_rate_handler;
 
     bool started;
+    // The latest light value, kept across stop() for warm starts
+    double recent_light;
+    std::chrono::steady_clock::time_point recent_light_tp;
+    bool warm_started;
     std::chrono::steady_clock::time_point last_light_tp;
     double last_light;
     double applied_light;
@@ -68,6 +87,11 @@ private:
     double slow_average;
     bool debouncing;
     int debouncing_seqnum;
+    EventLoopCancellation debounce_cancellation;
+    LightEventRate light_event_rate;
+    std::atomic<uint64_t> processed_light_values;
+    std::atomic<uint64_t> debounce_timers;
+    std::atomic<uint64_t> fired_debounce_timers;
 };
 
 }
@@ -175,7 +175,8 @@ void repowerd::AndroidDeviceConfig::xml_start_element(
     std::string const& element_name,
     std::unordered_map<std::string,std::string> const& attribs)
 {
-    if (element_name != "integer" && element_name != "integer-array" && element_name != "bool")
+    if (element_name != "integer" && element_name != "integer-array" &&
+        element_name != "bool" && element_name != "string")
         return;
 
     auto iter = attribs.find("name");
@@ -193,7 +194,8 @@ void repowerd::AndroidDeviceConfig::xml_start_element(
 void repowerd::AndroidDeviceConfig::xml_end_element(
     std::string const& element_name)
 {
-    if (element_name != "integer" && element_name != "integer-array" && element_name != "bool")
+    if (element_name != "integer" && element_name != "integer-array" &&
+        element_name != "bool" && element_name != "string")
         return;
 
     last_config_name = "";
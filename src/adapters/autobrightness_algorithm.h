@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include "light_sensor.h"
 #include "src/core/handler_registration.h"
 
 #include <functional>
@@ -26,6 +27,7 @@ namespace repowerd
 {
 
 using AutobrightnessHandler = std::function<void(double brightness)>;
+using LightEventRateHandler = std::function<void(LightEventRate rate)>;
 
 class EventLoop;
 
@@ -42,6 +44,9 @@ public:
 
     virtual HandlerRegistration register_autobrightness_handler(
         AutobrightnessHandler const& handler) = 0;
+    // Called with the light event rate the algorithm currently needs
+    virtual HandlerRegistration register_light_event_rate_handler(
+        LightEventRateHandler const& handler) = 0;
 
 protected:
     AutobrightnessAlgorithm() = default;
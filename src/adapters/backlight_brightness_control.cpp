@@ -24,9 +24,12 @@
 #include "device_quirks.h"
 #include "event_loop_handler_registration.h"
 #include "light_sensor.h"
+#include "suspend_pipeline.h"
+#include "wake_pipeline.h"
 
 #include "src/core/log.h"
 
+#include <algorithm>
 #include <cmath>
 #include <chrono>
 #include <string>
@@ -53,6 +56,59 @@ double dim_brightness_percent(repowerd::DeviceConfig const& device_config)
     return static_cast<double>(brightness_params.dim_value) / brightness_params.max_value;
 }
 
+repowerd::BrightnessTransitionCurve brightness_transition_curve(
+    repowerd::DeviceConfig const& device_config)
+{
+    auto const brightness_params = repowerd::BrightnessParams::from_device_config(device_config);
+    return brightness_params.transition_curve;
+}
+
+std::chrono::steady_clock::duration brightness_transition_frame_time(
+    repowerd::DeviceConfig const& device_config)
+{
+    auto const brightness_params = repowerd::BrightnessParams::from_device_config(device_config);
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(1s) /
+           brightness_params.transition_frame_rate;
+}
+
+double const transition_gamma = 2.2;
+// The ratio of the highest to the lowest luminance for the log curve
+double const log_luminance_range = 100.0;
+
+double to_perceptual(repowerd::BrightnessTransitionCurve curve, double brightness)
+{
+    switch (curve)
+    {
+    case repowerd::BrightnessTransitionCurve::gamma:
+        return std::pow(brightness, 1.0 / transition_gamma);
+    case repowerd::BrightnessTransitionCurve::log:
+        return std::log1p(log_luminance_range * brightness) /
+               std::log1p(log_luminance_range);
+    default:
+        return brightness;
+    }
+}
+
+double from_perceptual(repowerd::BrightnessTransitionCurve curve, double perceptual)
+{
+    switch (curve)
+    {
+    case repowerd::BrightnessTransitionCurve::gamma:
+        return std::pow(perceptual, transition_gamma);
+    case repowerd::BrightnessTransitionCurve::log:
+        return std::expm1(perceptual * std::log1p(log_luminance_range)) /
+               log_luminance_range;
+    default:
+        return perceptual;
+    }
+}
+
+// Smoothstep, easing in and out of the transition
+double ease(double t)
+{
+    return t * t * (3.0 - 2.0 * t);
+}
+
 }
 
 repowerd::BacklightBrightnessControl::BacklightBrightnessControl(
@@ -60,24 +116,44 @@ repowerd::BacklightBrightnessControl::BacklightBrightnessControl(
     std::shared_ptr<LightSensor> const& light_sensor,
     std::shared_ptr<AutobrightnessAlgorithm> const& autobrightness_algorithm,
     std::shared_ptr<Chrono> const& chrono,
+    std::shared_ptr<WakePipeline> const& wake_pipeline,
+    std::shared_ptr<SuspendPipeline> const& suspend_pipeline,
     std::shared_ptr<Log> const& log,
     DeviceConfig const& device_config,
-    DeviceQuirks const& quirks)
+    DeviceQuirks const& quirks,
+    std::shared_ptr<EventLoopTimeSource> const& event_loop_time_source,
+    std::shared_ptr<EventLoopExecutor> const& event_loop_executor)
     : backlight{backlight},
       light_sensor{light_sensor},
       autobrightness_algorithm{autobrightness_algorithm},
       chrono{chrono},
+      wake_pipeline{wake_pipeline},
+      suspend_pipeline{suspend_pipeline},
       log{log},
       normal_before_display_on_autobrightness{
           quirks.normal_before_display_on_autobrightness()},
       ab_supported{autobrightness_algorithm->init(event_loop)},
-      event_loop{"Backlight"},
+      transition_curve{brightness_transition_curve(device_config)},
+      transition_frame_time{brightness_transition_frame_time(device_config)},
+      event_loop{"Backlight", event_loop_executor, event_loop_time_source},
       brightness_handler{null_handler},
       dim_brightness{dim_brightness_percent(device_config)},
       normal_brightness{normal_brightness_percent(device_config)},
       user_normal_brightness{normal_brightness},
       active_brightness_type{ActiveBrightnessType::off},
-      ab_active{false}
+      ab_active{false},
+      ab_brightness_pending{false},
+      ramp_waits_for_panel{false},
+      ramp_wait_sequence{0},
+      transition_in_progress{false},
+      transition_start_brightness{0.0},
+      transition_from_brightness{0.0},
+      transition_current_brightness{0.0},
+      transition_target_brightness{0.0},
+      transition_frame_index{0},
+      transition_num_frames{0},
+      transition_step_time{0},
+      transition_frame_sequence{0}
 {
     if (ab_supported)
     {
@@ -90,23 +166,64 @@ repowerd::BacklightBrightnessControl::BacklightBrightnessControl(
 
                     normal_brightness = brightness;
 
-                    if (active_brightness_type == ActiveBrightnessType::normal)
+                    // A ramp waiting for the panel picks up the new value
+                    // when it starts
+                    if (active_brightness_type == ActiveBrightnessType::normal &&
+                        !ramp_waits_for_panel)
                     {
                         transition_to_brightness_value(normal_brightness, TransitionSpeed::slow);
                     }
+                    else if (active_brightness_type == ActiveBrightnessType::off)
+                    {
+                        ab_brightness_pending = true;
+                    }
                 }
             });
 
-        light_handler_registration = light_sensor->register_light_handler(
+        light_event_rate_handler_registration =
+            autobrightness_algorithm->register_light_event_rate_handler(
+                [this] (LightEventRate rate)
+                {
+                    this->light_sensor->set_light_event_rate(rate);
+                });
+
+        light_handler_registration = light_sensor->register_direct_light_handler(
+            event_loop,
             [this] (double light)
             {
-                event_loop.enqueue(
-                    [this, light]
-                    {
-                        this->autobrightness_algorithm->new_light_value(light);
-                    });
+                this->autobrightness_algorithm->new_light_value(light);
             });
     }
+
+    panel_on_handler_registration = wake_pipeline->register_stage_handler(
+        WakeStage::panel_on,
+        [this]
+        {
+            event_loop.post(
+                [this]
+                {
+                    if (ramp_waits_for_panel)
+                    {
+                        ramp_waits_for_panel = false;
+                        start_normal_brightness_ramp();
+                    }
+                });
+        });
+}
+
+repowerd::BacklightBrightnessControl::~BacklightBrightnessControl()
+{
+    panel_on_handler_registration = HandlerRegistration{};
+
+    // Invalidate any pending transition frame and deferred ramp, since the
+    // members they use are destroyed before the event loop is stopped
+    event_loop.enqueue(
+        [this]
+        {
+            ramp_waits_for_panel = false;
+            ++transition_frame_sequence;
+            transition_in_progress = false;
+        }).get();
 }
 
 void repowerd::BacklightBrightnessControl::disable_autobrightness()
@@ -164,6 +281,7 @@ void repowerd::BacklightBrightnessControl::set_dim_brightness()
             if (should_transition)
                 transition_to_brightness_value(dim_brightness, TransitionSpeed::normal);
 
+            ramp_waits_for_panel = false;
             active_brightness_type = ActiveBrightnessType::dim;
         }).get();
 }
@@ -173,19 +291,35 @@ void repowerd::BacklightBrightnessControl::set_normal_brightness()
     event_loop.enqueue(
         [this]
         { 
-            if (ab_active && active_brightness_type == ActiveBrightnessType::off)
+            auto const from_off = active_brightness_type == ActiveBrightnessType::off;
+            auto should_transition = true;
+
+            if (ab_active && from_off)
             {
-                if (normal_before_display_on_autobrightness)
-                    transition_to_brightness_value(normal_brightness, TransitionSpeed::normal);
+                // The algorithm may provide a brightness value as it starts,
+                // based on a recent light value, in which case we can go
+                // straight to it instead of waiting for the light sensor
+                ab_brightness_pending = false;
                 autobrightness_algorithm->start();
+                should_transition =
+                    ab_brightness_pending || normal_before_display_on_autobrightness;
+                ab_brightness_pending = false;
                 light_sensor->enable_light_events();
             }
-            else
-            {
-                transition_to_brightness_value(normal_brightness, TransitionSpeed::normal);
-            }
 
             active_brightness_type = ActiveBrightnessType::normal;
+
+            if (!should_transition)
+                return;
+
+            // Turning on the panel is in progress on another thread, and
+            // ramping up the backlight before the panel is on is wasted
+            if (from_off && wake_pipeline->is_stage_pending(WakeStage::panel_on))
+                wait_for_panel_before_ramp();
+            else if (from_off)
+                start_normal_brightness_ramp();
+            else
+                transition_to_brightness_value(normal_brightness, TransitionSpeed::normal);
         }).get();
 }
 
@@ -209,7 +343,11 @@ void repowerd::BacklightBrightnessControl::set_off_brightness()
     event_loop.enqueue(
         [this]
         { 
+            ramp_waits_for_panel = false;
+            suspend_pipeline->start_stage(SuspendStage::backlight_off);
             transition_to_brightness_value(0, TransitionSpeed::normal);
+            if (!transition_in_progress)
+                suspend_pipeline->complete_stage(SuspendStage::backlight_off);
             active_brightness_type = ActiveBrightnessType::off;
             autobrightness_algorithm->stop();
             light_sensor->disable_light_events();
@@ -226,57 +364,172 @@ repowerd::BacklightBrightnessControl::register_brightness_handler(
         [this] { brightness_handler = null_handler; });
 }
 
+void repowerd::BacklightBrightnessControl::start_normal_brightness_ramp()
+{
+    transition_to_brightness_value(normal_brightness, TransitionSpeed::normal);
+    wake_pipeline->complete_stage(WakeStage::backlight_ramp_started);
+}
+
+void repowerd::BacklightBrightnessControl::wait_for_panel_before_ramp()
+{
+    ramp_waits_for_panel = true;
+
+    auto const sequence = ++ramp_wait_sequence;
+
+    event_loop.schedule_in(
+        wake_pipeline->time_until_stage_deadline(),
+        [this, sequence]
+        {
+            if (ramp_waits_for_panel && sequence == ramp_wait_sequence)
+            {
+                log->log(log_tag, "Panel is not on by the deadline, ramping up anyway");
+                ramp_waits_for_panel = false;
+                start_normal_brightness_ramp();
+            }
+        });
+}
+
 void repowerd::BacklightBrightnessControl::transition_to_brightness_value(
     double brightness, TransitionSpeed transition_speed)
 {
     auto const step = 0.01;
-    auto const backlight_brightness = get_brightness_value();
-    auto const starting_brightness =
-        backlight_brightness == Backlight::unknown_brightness ?
-        brightness - step : backlight_brightness;
-    auto const num_steps = std::ceil(std::fabs(starting_brightness - brightness) / step);
-    auto const step_time = (transition_speed == TransitionSpeed::slow ||
-                            starting_brightness == 0.0
-                            || brightness == 0.0) ?
-                            100000us / num_steps : 1000us;
-
-    if (starting_brightness != brightness)
+
+    double starting_brightness;
+
+    if (transition_in_progress)
+    {
+        if (brightness == transition_target_brightness)
+            return;
+
+        // Retarget the transition in flight from wherever it has reached
+        starting_brightness = transition_current_brightness;
+    }
+    else
     {
-        log->log(log_tag, "Transitioning brightness %.2f => %.2f in %.2f steps %.2fus each",
-                 starting_brightness, brightness, num_steps, step_time.count());
+        auto const backlight_brightness = get_brightness_value();
+        starting_brightness =
+            backlight_brightness == Backlight::unknown_brightness ?
+            brightness - step : backlight_brightness;
+
+        if (starting_brightness == brightness)
+            return;
+    }
+
+    auto num_steps = std::max(
+        std::ceil(std::fabs(starting_brightness - brightness) / step), 1.0);
+    std::chrono::duration<double,std::micro> step_time =
+        (transition_speed == TransitionSpeed::slow ||
+         starting_brightness == 0.0 ||
+         brightness == 0.0) ?
+        100000us / num_steps : 1000us;
+
+    if (transition_curve != BrightnessTransitionCurve::linear)
+    {
+        // Perceptual transitions take as long as linear ones, but write
+        // the backlight once per frame at the configured frame rate
+        num_steps = std::max(std::round(step_time * num_steps / transition_frame_time), 1.0);
+        step_time = transition_frame_time;
+        transition_from_brightness = starting_brightness;
+        transition_frame_index = 0;
+        transition_num_frames = num_steps;
     }
 
-    auto current_brightness = starting_brightness;
+    log->log(log_tag, "Transitioning brightness %.2f => %.2f in %.2f steps %.2fus each",
+             starting_brightness, brightness, num_steps, step_time.count());
+
+    transition_current_brightness = starting_brightness;
+    transition_target_brightness = brightness;
+    transition_step_time =
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(step_time);
 
-    if (current_brightness < brightness)
+    if (!transition_in_progress)
     {
-        while (current_brightness < brightness)
+        transition_in_progress = true;
+        transition_start_brightness = starting_brightness;
+        transition_frame_time_point = chrono->steady_now();
+        transition_frame();
+    }
+}
+
+void repowerd::BacklightBrightnessControl::schedule_transition_frame()
+{
+    transition_frame_time_point += transition_step_time;
+
+    // Frames that run late are caught up by shortening the following
+    // delays, but a frame never waits for more than one step time
+    auto const delay = std::max(
+        std::min(transition_step_time,
+                 transition_frame_time_point - chrono->steady_now()),
+        std::chrono::steady_clock::duration::zero());
+    auto const delay_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        delay + 500us);
+
+    auto const sequence = ++transition_frame_sequence;
+
+    event_loop.schedule_in(
+        delay_ms,
+        [this, sequence]
         {
-            current_brightness += step;
-            if (current_brightness > brightness) current_brightness = brightness;
-            set_brightness_value(current_brightness);
-            chrono->sleep_for(std::chrono::duration_cast<std::chrono::nanoseconds>(step_time));
-        }
+            if (sequence == transition_frame_sequence)
+                transition_frame();
+        });
+}
+
+void repowerd::BacklightBrightnessControl::transition_frame()
+{
+    auto const step = 0.01;
+
+    // The transition is complete one step time after the final value
+    // has been written
+    if (transition_current_brightness == transition_target_brightness)
+    {
+        transition_in_progress = false;
+
+        log->log(log_tag, "Transitioning brightness %.2f => %.2f done",
+                 transition_start_brightness, transition_current_brightness);
+
+        // A fade out retargeted to another brightness hasn't turned the
+        // backlight off
+        if (transition_target_brightness == 0.0)
+            suspend_pipeline->complete_stage(SuspendStage::backlight_off);
+
+        brightness_handler(transition_target_brightness);
+        return;
     }
-    else if (current_brightness > brightness)
+
+    if (transition_curve != BrightnessTransitionCurve::linear)
     {
-        while (current_brightness > brightness)
+        ++transition_frame_index;
+
+        if (transition_frame_index >= transition_num_frames)
         {
-            current_brightness -= step;
-            if (current_brightness < brightness) current_brightness = brightness;
-            set_brightness_value(current_brightness);
-            chrono->sleep_for(std::chrono::duration_cast<std::chrono::nanoseconds>(step_time));
+            transition_current_brightness = transition_target_brightness;
+        }
+        else
+        {
+            auto const from = to_perceptual(transition_curve, transition_from_brightness);
+            auto const to = to_perceptual(transition_curve, transition_target_brightness);
+            auto const progress =
+                ease(static_cast<double>(transition_frame_index) / transition_num_frames);
+            transition_current_brightness =
+                from_perceptual(transition_curve, from + (to - from) * progress);
         }
     }
-
-    if (starting_brightness != brightness)
+    else if (transition_current_brightness < transition_target_brightness)
     {
-        log->log(log_tag, "Transitioning brightness %.2f => %.2f done",
-                 starting_brightness, current_brightness);
+        transition_current_brightness += step;
+        if (transition_current_brightness > transition_target_brightness)
+            transition_current_brightness = transition_target_brightness;
+    }
+    else
+    {
+        transition_current_brightness -= step;
+        if (transition_current_brightness < transition_target_brightness)
+            transition_current_brightness = transition_target_brightness;
     }
 
-    if (starting_brightness != brightness)
-        brightness_handler(brightness);
+    set_brightness_value(transition_current_brightness);
+    schedule_transition_frame();
 }
 
 void repowerd::BacklightBrightnessControl::set_brightness_value(double brightness)
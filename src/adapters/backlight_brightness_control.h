@@ -20,8 +20,10 @@
 
 #include "src/core/brightness_control.h"
 #include "brightness_notification.h"
+#include "brightness_params.h"
 #include "event_loop.h"
 
+#include <chrono>
 #include <memory>
 
 namespace repowerd
@@ -34,6 +36,8 @@ class DeviceConfig;
 class DeviceQuirks;
 class LightSensor;
 class Log;
+class SuspendPipeline;
+class WakePipeline;
 
 class BacklightBrightnessControl : public BrightnessControl, public BrightnessNotification
 {
@@ -43,9 +47,14 @@ public:
         std::shared_ptr<LightSensor> const& light_sensor,
         std::shared_ptr<AutobrightnessAlgorithm> const& autobrightness_algorithm,
         std::shared_ptr<Chrono> const& chrono,
+        std::shared_ptr<WakePipeline> const& wake_pipeline,
+        std::shared_ptr<SuspendPipeline> const& suspend_pipeline,
         std::shared_ptr<Log> const& log,
         DeviceConfig const& device_config,
-        DeviceQuirks const& device_quirks);
+        DeviceQuirks const& device_quirks,
+        std::shared_ptr<EventLoopTimeSource> const& event_loop_time_source,
+        std::shared_ptr<EventLoopExecutor> const& event_loop_executor);
+    ~BacklightBrightnessControl();
 
     void disable_autobrightness() override;
     void enable_autobrightness() override;
@@ -61,6 +70,10 @@ private:
     enum class ActiveBrightnessType {normal, dim, off};
     enum class TransitionSpeed {normal, slow};
     void transition_to_brightness_value(double brightness, TransitionSpeed transition_speed);
+    void start_normal_brightness_ramp();
+    void wait_for_panel_before_ramp();
+    void schedule_transition_frame();
+    void transition_frame();
     void set_brightness_value(double brightness);
     double get_brightness_value();
 
@@ -68,13 +81,19 @@ private:
     std::shared_ptr<LightSensor> const light_sensor;
     std::shared_ptr<AutobrightnessAlgorithm> const autobrightness_algorithm;
     std::shared_ptr<Chrono> const chrono;
+    std::shared_ptr<WakePipeline> const wake_pipeline;
+    std::shared_ptr<SuspendPipeline> const suspend_pipeline;
     std::shared_ptr<Log> const log;
     bool const normal_before_display_on_autobrightness;
     bool const ab_supported;
+    BrightnessTransitionCurve const transition_curve;
+    std::chrono::steady_clock::duration const transition_frame_time;
 
     EventLoop event_loop;
     HandlerRegistration light_handler_registration;
     HandlerRegistration ab_handler_registration;
+    HandlerRegistration light_event_rate_handler_registration;
+    HandlerRegistration panel_on_handler_registration;
     BrightnessHandler brightness_handler;
 
     double dim_brightness;
@@ -82,6 +101,27 @@ private:
     double user_normal_brightness;
     ActiveBrightnessType active_brightness_type;
     bool ab_active;
+    bool ab_brightness_pending;
+    // Whether the ramp up from off brightness waits for the panel to be
+    // on, which it does at most until the wake stages reach their deadline
+    bool ramp_waits_for_panel;
+    uint64_t ramp_wait_sequence;
+
+    // State of the brightness transition, which advances one step per
+    // frame, with frames driven by timers on the event loop. Linear
+    // transitions step by a fixed amount of brightness, perceptual ones
+    // interpolate from transition_from_brightness over a fixed number
+    // of frames.
+    bool transition_in_progress;
+    double transition_start_brightness;
+    double transition_from_brightness;
+    double transition_current_brightness;
+    double transition_target_brightness;
+    int transition_frame_index;
+    int transition_num_frames;
+    std::chrono::steady_clock::duration transition_step_time;
+    std::chrono::steady_clock::time_point transition_frame_time_point;
+    uint64_t transition_frame_sequence;
 };
 
 }
@@ -26,6 +26,16 @@ int string_to_int(std::string const& value, int default_value)
     catch (...) { return default_value; }
 }
 
+repowerd::BrightnessTransitionCurve string_to_transition_curve(std::string const& value)
+{
+    if (value == "gamma")
+        return repowerd::BrightnessTransitionCurve::gamma;
+    else if (value == "log")
+        return repowerd::BrightnessTransitionCurve::log;
+    else
+        return repowerd::BrightnessTransitionCurve::linear;
+}
+
 repowerd::BrightnessParams repowerd::BrightnessParams::from_device_config(
     DeviceConfig const& device_config)
 {
@@ -34,6 +44,8 @@ repowerd::BrightnessParams repowerd::BrightnessParams::from_device_config(
     auto max_str = device_config.get("screenBrightnessSettingMaximum", "255");
     auto default_str = device_config.get("screenBrightnessSettingDefault", "102");
     auto ab_str = device_config.get("automatic_brightness_available", "false");
+    auto curve_str = device_config.get("screenBrightnessTransitionCurve", "linear");
+    auto frame_rate_str = device_config.get("screenBrightnessTransitionFrameRate", "60");
 
     BrightnessParams params;
     params.dim_value = string_to_int(dim_str, 10);
@@ -41,6 +53,10 @@ repowerd::BrightnessParams repowerd::BrightnessParams::from_device_config(
     params.max_value = string_to_int(max_str, 255);
     params.default_value = string_to_int(default_str, 102);
     params.autobrightness_supported = (ab_str == "true");
+    params.transition_curve = string_to_transition_curve(curve_str);
+    params.transition_frame_rate = string_to_int(frame_rate_str, 60);
+    if (params.transition_frame_rate <= 0)
+        params.transition_frame_rate = 60;
 
     return params;
 }
@@ -23,6 +23,8 @@ namespace repowerd
 
 class DeviceConfig;
 
+enum class BrightnessTransitionCurve { linear, gamma, log };
+
 struct BrightnessParams
 {
     static BrightnessParams from_device_config(DeviceConfig const&);
@@ -32,6 +34,8 @@ struct BrightnessParams
     int max_value;
     int default_value;
     bool autobrightness_supported;
+    BrightnessTransitionCurve transition_curve;
+    int transition_frame_rate;
 };
 
 }
@@ -29,6 +29,7 @@ public:
     virtual ~Chrono() = default;
 
     virtual void sleep_for(std::chrono::nanoseconds t) = 0;
+    virtual std::chrono::steady_clock::time_point steady_now() = 0;
 
 protected:
     Chrono() = default;
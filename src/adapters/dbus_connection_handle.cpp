@@ -21,11 +21,14 @@
 
 #include <stdexcept>
 
-repowerd::DBusConnectionHandle::DBusConnectionHandle(std::string const& address)
+namespace
+{
+
+GDBusConnection* connect_to_address(std::string const& address)
 {
     repowerd::ScopedGError error;
 
-    connection = g_dbus_connection_new_for_address_sync(
+    auto const connection = g_dbus_connection_new_for_address_sync(
         address.c_str(),
         GDBusConnectionFlags(
             G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION |
@@ -40,11 +43,32 @@ repowerd::DBusConnectionHandle::DBusConnectionHandle(std::string const& address)
             "Failed to connect to DBus bus with address '" +
                 address + "': " + error.message_str());
     }
+
+    return connection;
+}
+
+}
+
+repowerd::DBusConnectionHandle::DBusConnectionHandle(
+    std::string const& address,
+    std::shared_ptr<DBusRegistrationBatch> const& registration_batch)
+    : connection{connect_to_address(address)},
+      batch{registration_batch}
+{
+}
+
+repowerd::DBusConnectionHandle::DBusConnectionHandle(
+    std::shared_ptr<DBusConnectionHandle> const& shared)
+    : shared{shared},
+      connection{*shared},
+      batch{shared->registration_batch()}
+{
 }
 
 repowerd::DBusConnectionHandle::~DBusConnectionHandle()
 {
-    g_dbus_connection_close_sync(connection, nullptr, nullptr);
+    if (!shared)
+        g_dbus_connection_close_sync(connection, nullptr, nullptr);
 }
 
 void repowerd::DBusConnectionHandle::request_name(char const* name) const
@@ -89,6 +113,12 @@ void repowerd::DBusConnectionHandle::request_name(char const* name) const
     }
 }
 
+std::shared_ptr<repowerd::DBusRegistrationBatch>
+repowerd::DBusConnectionHandle::registration_batch() const
+{
+    return batch;
+}
+
 repowerd::DBusConnectionHandle::operator GDBusConnection*() const
 {
     return connection;
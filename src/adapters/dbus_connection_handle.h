@@ -20,26 +20,43 @@
 
 #include <gio/gio.h>
 
+#include <memory>
 #include <string>
 
 namespace repowerd
 {
 
+class DBusRegistrationBatch;
+
 class DBusConnectionHandle
 {
 public:
-    DBusConnectionHandle(std::string const& address);
+    // Opens a connection of its own, which is closed along with the handle.
+    // Handler registrations on the connection are deferred to the
+    // registration batch, if any, while it is active.
+    DBusConnectionHandle(
+        std::string const& address,
+        std::shared_ptr<DBusRegistrationBatch> const& registration_batch = nullptr);
+    // Uses the connection (and registration batch) of the shared handle,
+    // which stays open for as long as any handle uses it. Handlers are
+    // still dispatched in the thread default main context at the time of
+    // their registration, so each adapter keeps its own dispatch context.
+    DBusConnectionHandle(std::shared_ptr<DBusConnectionHandle> const& shared);
     ~DBusConnectionHandle();
 
     void request_name(char const* name) const;
 
+    std::shared_ptr<DBusRegistrationBatch> registration_batch() const;
+
     operator GDBusConnection*() const;
 
 private:
     DBusConnectionHandle(DBusConnectionHandle const&) = delete;
     DBusConnectionHandle& operator=(DBusConnectionHandle const&) = delete;
 
-    GDBusConnection* connection;
+    std::shared_ptr<DBusConnectionHandle> const shared;
+    GDBusConnection* const connection;
+    std::shared_ptr<DBusRegistrationBatch> const batch;
 };
 
 }
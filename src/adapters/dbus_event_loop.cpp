@@ -20,6 +20,10 @@
 #include "event_loop_handler_registration.h"
 #include "scoped_g_error.h"
 
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+
 namespace
 {
 
@@ -49,10 +53,74 @@ void repowerd_g_dbus_connection_wait_for_requests(GDBusConnection* connection)
     g_variant_unref(result);
 }
 
+void wait_for_requests_or_add_to_batch(repowerd::DBusConnectionHandle const& connection)
+{
+    auto const batch = connection.registration_batch();
+
+    if (!batch || !batch->add_pending_requests(connection))
+        repowerd_g_dbus_connection_wait_for_requests(connection);
+}
+
+}
+
+repowerd::DBusRegistrationBatch::DBusRegistrationBatch()
+    : active{false}
+{
+}
+
+repowerd::DBusRegistrationBatch::~DBusRegistrationBatch()
+{
+    finish();
+}
+
+void repowerd::DBusRegistrationBatch::start()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    if (active)
+        throw std::logic_error{"The DBus registration batch is already active"};
+
+    active = true;
+}
+
+void repowerd::DBusRegistrationBatch::finish()
+{
+    std::vector<GDBusConnection*> connections;
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        if (!active) return;
+
+        active = false;
+        connections.swap(pending_connections);
+    }
+
+    for (auto const connection : connections)
+    {
+        repowerd_g_dbus_connection_wait_for_requests(connection);
+        g_object_unref(connection);
+    }
+}
+
+bool repowerd::DBusRegistrationBatch::add_pending_requests(GDBusConnection* connection)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    if (!active) return false;
+
+    if (std::find(pending_connections.begin(), pending_connections.end(), connection) ==
+        pending_connections.end())
+    {
+        pending_connections.push_back(
+            static_cast<GDBusConnection*>(g_object_ref(connection)));
+    }
+
+    return true;
 }
 
 repowerd::HandlerRegistration repowerd::DBusEventLoop::register_object_handler(
-    GDBusConnection* dbus_connection,
+    DBusConnectionHandle const& dbus_connection_handle,
     char const* dbus_path,
     char const* introspection_xml,
     DBusEventLoopMethodCallHandler const& handler)
@@ -77,6 +145,7 @@ repowerd::HandlerRegistration repowerd::DBusEventLoop::register_object_handler(
         DBusEventLoopMethodCallHandler const handler;
     };
 
+    GDBusConnection* const dbus_connection = dbus_connection_handle;
     unsigned int registration_id = 0;
     auto done = enqueue(
         [&]
@@ -114,8 +183,8 @@ repowerd::HandlerRegistration repowerd::DBusEventLoop::register_object_handler(
 
     // g_dbus_connection_register_object() is not synchronous, so wait for
     // the registration (really a DBus AddMatch request) to be processed
-    // by the server
-    repowerd_g_dbus_connection_wait_for_requests(dbus_connection);
+    // by the server, or let the active batch do so
+    wait_for_requests_or_add_to_batch(dbus_connection_handle);
 
     return EventLoopHandlerRegistration(
         *this,
@@ -129,7 +198,7 @@ repowerd::HandlerRegistration repowerd::DBusEventLoop::register_object_handler(
 
 
 repowerd::HandlerRegistration repowerd::DBusEventLoop::register_signal_handler(
-    GDBusConnection* dbus_connection,
+    DBusConnectionHandle const& dbus_connection_handle,
     char const* dbus_sender,
     char const* dbus_interface,
     char const* dbus_member,
@@ -155,6 +224,7 @@ repowerd::HandlerRegistration repowerd::DBusEventLoop::register_signal_handler(
         DBusEventLoopSignalHandler const handler;
     };
 
+    GDBusConnection* const dbus_connection = dbus_connection_handle;
     unsigned int registration_id = 0;
     auto done = enqueue(
         [&]
@@ -176,8 +246,10 @@ repowerd::HandlerRegistration repowerd::DBusEventLoop::register_signal_handler(
 
     // g_dbus_connection_signal_subscribe() is not synchronous, so wait for
     // the subscription (really a DBus AddMatch request) to be processed
-    // by the server
-    repowerd_g_dbus_connection_wait_for_requests(dbus_connection);
+    // by the server, or let the active batch do so. Requests on a connection
+    // are processed in order, so any later call on the same connection
+    // still sees the subscription in effect.
+    wait_for_requests_or_add_to_batch(dbus_connection_handle);
 
     return EventLoopHandlerRegistration(
         *this,
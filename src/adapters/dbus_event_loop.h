@@ -18,11 +18,15 @@
 
 #pragma once
 
+#include "dbus_connection_handle.h"
 #include "event_loop.h"
 #include "src/core/handler_registration.h"
 
 #include <gio/gio.h>
 
+#include <mutex>
+#include <vector>
+
 namespace repowerd
 {
 
@@ -47,19 +51,47 @@ using DBusEventLoopSignalHandler =
             char const* signal_name,
             GVariant* parameters)>;
 
+// While a batch is active, DBusEventLoop handler registrations on the
+// connections that use it don't wait for the dbus daemon to process each
+// registration request. Instead, the batch waits once per connection when
+// finished (or destroyed), so that startup pays for a single round trip per
+// connection instead of one per registration. A batch can be started again
+// after it has finished.
+class DBusRegistrationBatch
+{
+public:
+    DBusRegistrationBatch();
+    ~DBusRegistrationBatch();
+
+    void start();
+    void finish();
+
+    // Returns false if the batch is not active, in which case the caller
+    // needs to wait for its requests itself
+    bool add_pending_requests(GDBusConnection* connection);
+
+private:
+    DBusRegistrationBatch(DBusRegistrationBatch const&) = delete;
+    DBusRegistrationBatch& operator=(DBusRegistrationBatch const&) = delete;
+
+    std::mutex mutex;
+    bool active;
+    std::vector<GDBusConnection*> pending_connections;
+};
+
 class DBusEventLoop : public EventLoop
 {
 public:
     using EventLoop::EventLoop;
 
     repowerd::HandlerRegistration register_object_handler(
-        GDBusConnection* dbus_connection,
+        DBusConnectionHandle const& dbus_connection,
         char const* dbus_path,
         char const* introspection_xml,
         DBusEventLoopMethodCallHandler const& handler);
 
     repowerd::HandlerRegistration register_signal_handler(
-        GDBusConnection* dbus_connection,
+        DBusConnectionHandle const& dbus_connection,
         char const* dbus_sender,
         char const* dbus_interface,
         char const* dbus_member,
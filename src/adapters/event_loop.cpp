@@ -17,6 +17,10 @@
  */
 
 #include "event_loop.h"
+#include "event_loop_executor.h"
+#include "event_loop_time_source.h"
+
+#include <stdexcept>
 
 #include <glib-unix.h>
 #include <pthread.h>
@@ -81,22 +85,69 @@ struct GSourceFdContext
     std::function<void()> const callback;
 };
 
+gboolean dispatch_callback_queue_source(
+    GSource* source, GSourceFunc callback, gpointer user_data)
+{
+    // Clear the ready time before the queued callbacks are taken, so that
+    // any callbacks queued after that make the source ready again
+    g_source_set_ready_time(source, -1);
+    return callback(user_data);
+}
+
+GSourceFuncs callback_queue_source_funcs{
+    nullptr, nullptr, &dispatch_callback_queue_source, nullptr, nullptr, nullptr};
+
 }
 
 repowerd::EventLoop::EventLoop(std::string const& name)
-    : main_context{g_main_context_new()},
-      main_loop{g_main_loop_new(main_context, FALSE)}
+    : EventLoop{name, nullptr}
 {
-    loop_thread = std::thread{
-        [this]
-        {
-            g_main_context_push_thread_default(main_context);
-            g_main_loop_run(main_loop);
-        }};
+}
+
+repowerd::EventLoop::EventLoop(
+    std::string const& name,
+    std::shared_ptr<EventLoopExecutor> const& executor)
+    : EventLoop{name, executor, nullptr}
+{
+}
 
-    set_thread_name(loop_thread, name);
+repowerd::EventLoop::EventLoop(
+    std::string const& name,
+    std::shared_ptr<EventLoopExecutor> const& executor,
+    std::shared_ptr<EventLoopTimeSource> const& time_source)
+    : executor{executor},
+      main_context{g_main_context_new()},
+      main_loop{nullptr},
+      callback_queue_source{g_source_new(&callback_queue_source_funcs, sizeof(GSource))},
+      time_source{time_source}
+{
+    g_source_set_priority(callback_queue_source, G_PRIORITY_DEFAULT_IDLE);
+    g_source_set_callback(
+        callback_queue_source, &EventLoop::static_run_queued_callbacks, this, nullptr);
+    g_source_attach(callback_queue_source, main_context);
+
+    if (executor)
+    {
+        executor->attach(main_context);
+    }
+    else
+    {
+        main_loop = g_main_loop_new(main_context, FALSE);
+
+        loop_thread = std::thread{
+            [this]
+            {
+                g_main_context_push_thread_default(main_context);
+                g_main_loop_run(main_loop);
+            }};
+
+        set_thread_name(loop_thread, name);
+    }
 
     enqueue([]{}).wait();
+
+    if (time_source)
+        time_source->attach(*this);
 }
 
 repowerd::EventLoop::~EventLoop()
@@ -106,6 +157,10 @@ repowerd::EventLoop::~EventLoop()
 
 void repowerd::EventLoop::stop()
 {
+    if (time_source)
+        time_source->detach(*this);
+    if (executor && main_context)
+        executor->detach(main_context);
     if (main_loop)
         g_main_loop_quit(main_loop);
     if (loop_thread.joinable())
@@ -115,6 +170,12 @@ void repowerd::EventLoop::stop()
         g_main_loop_unref(main_loop);
         main_loop = nullptr;
     }
+    if (callback_queue_source)
+    {
+        g_source_destroy(callback_queue_source);
+        g_source_unref(callback_queue_source);
+        callback_queue_source = nullptr;
+    }
     if (main_context)
     {
         g_main_context_unref(main_context);
@@ -124,26 +185,47 @@ void repowerd::EventLoop::stop()
 
 std::future<void> repowerd::EventLoop::enqueue(std::function<void()> const& callback)
 {
-    auto const gsource = g_idle_source_new();
-    auto const ctx = new GSourceContext{callback};
-    g_source_set_callback(
-            gsource,
-            reinterpret_cast<GSourceFunc>(&GSourceContext::static_call),
-            ctx,
-            reinterpret_cast<GDestroyNotify>(&GSourceContext::static_destroy));
+    // When called from a callback of another EventLoop that shares the
+    // executor thread of this EventLoop, waiting for the callback would block
+    // the only thread that can run it. Dispatching this EventLoop's context
+    // in place would run its callbacks re-entrantly, breaking their
+    // serialization, so this is an error instead, raised before anything is
+    // queued. Such callers need to use post(), or the EventLoops need to run
+    // on different threads.
+    if (executor &&
+        g_main_context_is_owner(main_context) &&
+        g_main_context_get_thread_default() != main_context)
+    {
+        throw std::logic_error{
+            "Waiting for an EventLoop callback from the thread "
+            "that dispatches the EventLoop would deadlock"};
+    }
 
-    auto future = ctx->done.get_future();
+    QueuedCallback queued_callback{callback, std::make_unique<std::promise<void>>()};
+    auto future = queued_callback.done->get_future();
 
-    g_source_attach(gsource, main_context);
-    g_source_unref(gsource);
+    queue_callback(std::move(queued_callback));
 
     return future;
 }
 
+void repowerd::EventLoop::post(std::function<void()> const& callback)
+{
+    queue_callback({callback, nullptr});
+}
+
 std::future<void> repowerd::EventLoop::schedule_in(
     std::chrono::milliseconds timeout,
     std::function<void()> const& callback)
 {
+    if (time_source)
+    {
+        auto const ctx = std::make_shared<GSourceContext>(callback);
+        time_source->schedule_in(
+            *this, timeout, [ctx] { GSourceContext::static_call(ctx.get()); });
+        return ctx->done.get_future();
+    }
+
     auto const gsource = g_timeout_source_new(timeout.count());
     auto const ctx = new GSourceContext{callback};
     g_source_set_callback(
@@ -165,6 +247,20 @@ void repowerd::EventLoop::schedule_with_cancellation_in(
     std::function<void()> const& callback,
     std::function<void(EventLoopCancellation const&)> const& cancellation_ready)
 {
+    if (time_source)
+    {
+        auto const source = time_source;
+        auto const timeout_id = source->schedule_in(*this, timeout, callback);
+
+        post(
+            [source, timeout_id, cancellation_ready]
+            {
+                cancellation_ready([source, timeout_id] { source->cancel(timeout_id); });
+            });
+
+        return;
+    }
+
     auto const gsource = g_timeout_source_new(timeout.count());
     auto const ctx = new GSourceContext{callback};
     g_source_set_callback(
@@ -180,7 +276,7 @@ void repowerd::EventLoop::schedule_with_cancellation_in(
             g_source_unref(gsource);
         };
 
-    enqueue(
+    post(
         [cancellation, cancellation_ready]
         {
             cancellation_ready(cancellation);
@@ -203,3 +299,52 @@ void repowerd::EventLoop::watch_fd(
     g_source_attach(gsource, main_context);
     g_source_unref(gsource);
 }
+
+void repowerd::EventLoop::queue_callback(QueuedCallback&& queued_callback)
+{
+    if (!callback_queue_source)
+        return;
+
+    bool was_empty;
+
+    {
+        std::lock_guard<std::mutex> lock{queued_callbacks_mutex};
+        was_empty = queued_callbacks.empty();
+        queued_callbacks.push_back(std::move(queued_callback));
+    }
+
+    // Only the first pending callback needs to wake up the loop
+    if (was_empty)
+        g_source_set_ready_time(callback_queue_source, 0);
+}
+
+gboolean repowerd::EventLoop::static_run_queued_callbacks(gpointer event_loop)
+{
+    static_cast<EventLoop*>(event_loop)->run_queued_callbacks();
+    return G_SOURCE_CONTINUE;
+}
+
+void repowerd::EventLoop::run_queued_callbacks()
+{
+    {
+        std::lock_guard<std::mutex> lock{queued_callbacks_mutex};
+        std::swap(running_callbacks, queued_callbacks);
+    }
+
+    for (auto& queued_callback : running_callbacks)
+    {
+        try
+        {
+            queued_callback.callback();
+            if (queued_callback.done)
+                queued_callback.done->set_value();
+        }
+        catch (...)
+        {
+            if (queued_callback.done)
+                queued_callback.done->set_exception(std::current_exception());
+        }
+    }
+
+    running_callbacks.clear();
+}
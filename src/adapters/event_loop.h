@@ -21,24 +21,46 @@
 #include <thread>
 #include <functional>
 #include <future>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include <glib.h>
 
 namespace repowerd
 {
 
+class EventLoopExecutor;
+class EventLoopTimeSource;
+
 using EventLoopCancellation = std::function<void()>;
 
 class EventLoop
 {
 public:
+    // Runs on a dedicated thread
     EventLoop(std::string const& name);
+    // Runs on the executor, or on a dedicated thread if the executor is null
+    EventLoop(
+        std::string const& name,
+        std::shared_ptr<EventLoopExecutor> const& executor);
+    // Timeouts are driven by the time source, or by the real time if the
+    // time source is null
+    EventLoop(
+        std::string const& name,
+        std::shared_ptr<EventLoopExecutor> const& executor,
+        std::shared_ptr<EventLoopTimeSource> const& time_source);
     ~EventLoop();
 
     void stop();
 
+    // Can't be called from a callback of another EventLoop that runs on the
+    // same executor thread, since the returned future could never become
+    // ready (throws std::logic_error without queuing the callback)
     std::future<void> enqueue(std::function<void()> const& callback);
+    // Like enqueue(), for callers that never wait for the callback
+    void post(std::function<void()> const& callback);
     std::future<void> schedule_in(
         std::chrono::milliseconds, std::function<void()> const& callback);
 
@@ -50,9 +72,30 @@ public:
     void watch_fd(int fd, std::function<void()> const& callback);
 
 protected:
+    std::shared_ptr<EventLoopExecutor> executor;
     std::thread loop_thread;
     GMainContext* main_context;
     GMainLoop* main_loop;
+
+private:
+    struct QueuedCallback
+    {
+        std::function<void()> callback;
+        std::unique_ptr<std::promise<void>> done;
+    };
+
+    void queue_callback(QueuedCallback&& queued_callback);
+    static gboolean static_run_queued_callbacks(gpointer event_loop);
+    void run_queued_callbacks();
+
+    // All enqueued and posted callbacks go through a single source, which
+    // runs every pending callback in one dispatch
+    GSource* callback_queue_source;
+    std::mutex queued_callbacks_mutex;
+    std::vector<QueuedCallback> queued_callbacks;
+    std::vector<QueuedCallback> running_callbacks;
+
+    std::shared_ptr<EventLoopTimeSource> const time_source;
 };
 
 }
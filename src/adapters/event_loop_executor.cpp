@@ -0,0 +1,297 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "event_loop_executor.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <stdexcept>
+#include <thread>
+
+#include <pthread.h>
+
+namespace
+{
+
+void set_thread_name(std::thread& thread, std::string const& name)
+{
+    static size_t const max_name_len = 15;
+    auto const proper_name = name.substr(0, max_name_len);
+
+    pthread_setname_np(thread.native_handle(), proper_name.c_str());
+}
+
+struct ContextPollState
+{
+    GMainContext* context;
+    gint max_priority;
+    size_t fds_offset;
+    gint num_fds;
+};
+
+}
+
+class repowerd::EventLoopExecutor::Worker
+{
+public:
+    Worker(std::string const& name);
+    ~Worker();
+
+    void attach(GMainContext* main_context);
+    void detach(GMainContext* main_context);
+    size_t num_contexts();
+
+private:
+    void run();
+    bool is_attached(GMainContext* main_context);
+    void iterate(std::vector<GMainContext*> const& snapshot);
+
+    // The control context has no sources, it just provides a wakeup fd that
+    // is polled along with the fds of the attached contexts
+    GMainContext* const control_context;
+
+    std::mutex mutex;
+    std::condition_variable iteration_done;
+    std::vector<GMainContext*> contexts;
+    uint64_t completed_iterations;
+    bool running;
+
+    std::vector<ContextPollState> poll_states;
+    std::vector<GPollFD> poll_fds;
+
+    std::thread thread;
+};
+
+repowerd::EventLoopExecutor::Worker::Worker(std::string const& name)
+    : control_context{g_main_context_new()},
+      completed_iterations{0},
+      running{true}
+{
+    thread = std::thread{[this] { run(); }};
+    set_thread_name(thread, name);
+}
+
+repowerd::EventLoopExecutor::Worker::~Worker()
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        running = false;
+    }
+
+    g_main_context_wakeup(control_context);
+    thread.join();
+
+    for (auto const context : contexts)
+        g_main_context_unref(context);
+    g_main_context_unref(control_context);
+}
+
+void repowerd::EventLoopExecutor::Worker::attach(GMainContext* main_context)
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        contexts.push_back(g_main_context_ref(main_context));
+    }
+
+    g_main_context_wakeup(control_context);
+}
+
+void repowerd::EventLoopExecutor::Worker::detach(GMainContext* main_context)
+{
+    std::unique_lock<std::mutex> lock{mutex};
+
+    auto const iter = std::find(contexts.begin(), contexts.end(), main_context);
+    if (iter == contexts.end())
+        return;
+
+    contexts.erase(iter);
+    g_main_context_unref(main_context);
+
+    // The current iteration may still be using the context. When detaching
+    // from within the worker the snapshot reference keeps the context
+    // alive until the iteration is over.
+    if (std::this_thread::get_id() == thread.get_id())
+        return;
+
+    auto const target_iterations = completed_iterations + 1;
+
+    g_main_context_wakeup(control_context);
+    iteration_done.wait(
+        lock, [&] { return completed_iterations >= target_iterations; });
+}
+
+size_t repowerd::EventLoopExecutor::Worker::num_contexts()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return contexts.size();
+}
+
+bool repowerd::EventLoopExecutor::Worker::is_attached(GMainContext* main_context)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return std::find(contexts.begin(), contexts.end(), main_context) != contexts.end();
+}
+
+void repowerd::EventLoopExecutor::Worker::run()
+{
+    std::vector<GMainContext*> snapshot;
+
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            if (!running)
+                break;
+
+            snapshot.clear();
+            for (auto const context : contexts)
+                snapshot.push_back(g_main_context_ref(context));
+        }
+
+        snapshot.push_back(g_main_context_ref(control_context));
+
+        iterate(snapshot);
+
+        for (auto const context : snapshot)
+            g_main_context_unref(context);
+
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            ++completed_iterations;
+        }
+
+        iteration_done.notify_all();
+    }
+}
+
+// This is g_main_context_iteration() spread over multiple contexts
+void repowerd::EventLoopExecutor::Worker::iterate(
+    std::vector<GMainContext*> const& snapshot)
+{
+    gint timeout = -1;
+
+    poll_states.clear();
+    poll_fds.clear();
+
+    for (auto const context : snapshot)
+    {
+        if (!g_main_context_acquire(context))
+            continue;
+
+        ContextPollState state{context, 0, poll_fds.size(), 0};
+
+        if (g_main_context_prepare(context, &state.max_priority))
+            timeout = 0;
+
+        gint context_timeout = -1;
+        gint num_fds = 0;
+
+        do
+        {
+            state.num_fds = num_fds;
+            poll_fds.resize(state.fds_offset + state.num_fds);
+            num_fds = g_main_context_query(
+                context, state.max_priority, &context_timeout,
+                poll_fds.data() + state.fds_offset, state.num_fds);
+        }
+        while (num_fds > state.num_fds);
+
+        state.num_fds = num_fds;
+        poll_fds.resize(state.fds_offset + state.num_fds);
+
+        if (context_timeout >= 0 && (timeout < 0 || context_timeout < timeout))
+            timeout = context_timeout;
+
+        poll_states.push_back(state);
+    }
+
+    g_poll(poll_fds.data(), poll_fds.size(), timeout);
+
+    for (auto const& state : poll_states)
+    {
+        g_main_context_check(
+            state.context, state.max_priority,
+            poll_fds.data() + state.fds_offset, state.num_fds);
+    }
+
+    // All contexts stay acquired until every context has been dispatched,
+    // so that EventLoop::enqueue() can tell when it's called from the
+    // thread that dispatches the target context
+    for (auto const& state : poll_states)
+    {
+        // A callback may have detached a context that hasn't been
+        // dispatched yet in this iteration
+        if (state.context != control_context && !is_attached(state.context))
+            continue;
+
+        g_main_context_push_thread_default(state.context);
+        g_main_context_dispatch(state.context);
+        g_main_context_pop_thread_default(state.context);
+    }
+
+    for (auto const& state : poll_states)
+        g_main_context_release(state.context);
+}
+
+repowerd::EventLoopExecutor::EventLoopExecutor(
+    std::string const& name, size_t num_threads)
+{
+    if (num_threads == 0)
+        throw std::invalid_argument{"EventLoopExecutor needs at least one thread"};
+
+    for (size_t i = 0; i < num_threads; ++i)
+        workers.push_back(std::make_unique<Worker>(name + std::to_string(i)));
+}
+
+repowerd::EventLoopExecutor::~EventLoopExecutor() = default;
+
+void repowerd::EventLoopExecutor::attach(GMainContext* main_context)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const least_busy_worker = std::min_element(
+        workers.begin(), workers.end(),
+        [] (auto const& a, auto const& b)
+        {
+            return a->num_contexts() < b->num_contexts();
+        });
+
+    context_workers[main_context] = least_busy_worker->get();
+    (*least_busy_worker)->attach(main_context);
+}
+
+void repowerd::EventLoopExecutor::detach(GMainContext* main_context)
+{
+    Worker* worker{nullptr};
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto const iter = context_workers.find(main_context);
+        if (iter == context_workers.end())
+            return;
+        worker = iter->second;
+        context_workers.erase(iter);
+    }
+
+    worker->detach(main_context);
+}
+
+size_t repowerd::EventLoopExecutor::num_threads() const
+{
+    return workers.size();
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glib.h>
+
+namespace repowerd
+{
+
+// Runs the main contexts of many EventLoops on a fixed set of threads.
+// Each main context is only ever dispatched by a single thread, so
+// callbacks of the same EventLoop remain serialized with respect to each
+// other, and each context is pushed as the thread default while it is
+// being dispatched. Since a thread dispatches one context at a time,
+// EventLoops that block waiting for each other's callbacks must not share
+// an executor.
+class EventLoopExecutor
+{
+public:
+    EventLoopExecutor(std::string const& name, size_t num_threads);
+    ~EventLoopExecutor();
+
+    void attach(GMainContext* main_context);
+    // Once this returns the context is not being, and will not be,
+    // dispatched by the executor (unless called from an executor thread)
+    void detach(GMainContext* main_context);
+
+    size_t num_threads() const;
+
+private:
+    class Worker;
+
+    EventLoopExecutor(EventLoopExecutor const&) = delete;
+    EventLoopExecutor& operator=(EventLoopExecutor const&) = delete;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::mutex mutex;
+    std::unordered_map<GMainContext*,Worker*> context_workers;
+};
+
+}
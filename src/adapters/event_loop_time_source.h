@@ -0,0 +1,54 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+namespace repowerd
+{
+
+class EventLoop;
+
+// Drives the timeouts of the EventLoops constructed with it, in place of
+// the real time
+class EventLoopTimeSource
+{
+public:
+    virtual ~EventLoopTimeSource() = default;
+
+    virtual void attach(EventLoop& event_loop) = 0;
+    // Drops the pending timeouts of the EventLoop
+    virtual void detach(EventLoop& event_loop) = 0;
+
+    // The callback needs to run on the EventLoop
+    virtual uint64_t schedule_in(
+        EventLoop& event_loop,
+        std::chrono::milliseconds timeout,
+        std::function<void()> const& callback) = 0;
+    virtual void cancel(uint64_t timeout_id) = 0;
+
+protected:
+    EventLoopTimeSource() = default;
+    EventLoopTimeSource(EventLoopTimeSource const&) = delete;
+    EventLoopTimeSource& operator=(EventLoopTimeSource const&) = delete;
+};
+
+}
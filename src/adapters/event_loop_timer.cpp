@@ -19,24 +19,60 @@
 #include "event_loop_timer.h"
 #include "event_loop_handler_registration.h"
 
+#include <algorithm>
+#include <system_error>
+
+#include <sys/timerfd.h>
+#include <unistd.h>
+
 namespace
 {
 auto const null_handler = [](auto){};
+
+// Below this size the heap is never compacted, since cancelled entries
+// cost little and are dropped anyway when their deadline passes
+size_t const min_alarm_heap_size_for_compaction = 64;
+
+template<typename AlarmEntry>
+bool later_alarm(AlarmEntry const& a, AlarmEntry const& b)
+{
+    // Alarms with the same deadline trigger in the order they were scheduled
+    return a.deadline > b.deadline ||
+           (a.deadline == b.deadline && a.sequence > b.sequence);
+}
+
+timespec to_timespec(std::chrono::steady_clock::time_point const& tp)
+{
+    auto d = tp.time_since_epoch();
+    auto const sec = std::chrono::duration_cast<std::chrono::seconds>(d);
+
+    timespec ts;
+    ts.tv_sec = sec.count();
+    ts.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(d - sec).count();
+
+    return ts;
 }
 
-repowerd::EventLoopTimer::EventLoopTimer()
-    : event_loop{"Timer"},
+}
+
+repowerd::EventLoopTimer::EventLoopTimer(
+    std::shared_ptr<EventLoopExecutor> const& event_loop_executor)
+    : timerfd_fd{timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK)},
+      event_loop{"Timer", event_loop_executor},
       alarm_handler{null_handler},
-      next_alarm_id{1}
+      next_alarm_id{1},
+      next_alarm_sequence{0},
+      armed_deadline{Deadline::max()}
 {
+    if (timerfd_fd == -1)
+        throw std::system_error{errno, std::system_category(), "Failed to create timerfd"};
+
+    event_loop.watch_fd(timerfd_fd, [this] { handle_timerfd(); });
 }
 
 repowerd::EventLoopTimer::~EventLoopTimer()
 {
     event_loop.stop();
-
-    for (auto const& alarm : alarms)
-        alarm.second();
 }
 
 repowerd::HandlerRegistration repowerd::EventLoopTimer::register_alarm_handler(
@@ -51,32 +87,30 @@ repowerd::HandlerRegistration repowerd::EventLoopTimer::register_alarm_handler(
 repowerd::AlarmId repowerd::EventLoopTimer::schedule_alarm_in(
     std::chrono::milliseconds t)
 {
-    repowerd::AlarmId alarm_id;
+    auto const deadline = now() + t;
 
-    {
-        std::lock_guard<std::mutex> lock{alarms_mutex};
-        alarm_id = next_alarm_id++;
-    }
+    std::lock_guard<std::mutex> lock{alarms_mutex};
 
-    event_loop.schedule_with_cancellation_in(
-        t,
-        [this, alarm_id]
-        {
-            alarm_handler(alarm_id);
-            cancel_alarm_unqueued(alarm_id);
-        },
-        [this, alarm_id] (EventLoopCancellation const& cancellation)
-        {
-            std::lock_guard<std::mutex> lock{alarms_mutex};
-            alarms[alarm_id] = cancellation;
-        });
+    auto const alarm_id = next_alarm_id++;
+
+    active_alarms.insert(alarm_id);
+    alarm_heap.push_back({deadline, next_alarm_sequence++, alarm_id});
+    std::push_heap(alarm_heap.begin(), alarm_heap.end(), later_alarm<AlarmEntry>);
+
+    if (deadline < armed_deadline)
+        arm_timerfd(deadline);
 
     return alarm_id;
 }
 
 void repowerd::EventLoopTimer::cancel_alarm(AlarmId id)
 {
-    event_loop.enqueue([this,id] { cancel_alarm_unqueued(id); }).get();
+    std::lock_guard<std::mutex> lock{alarms_mutex};
+
+    // The heap entry is dropped lazily. If it's the earliest one, the
+    // timerfd may still trigger for it, and will then be rearmed.
+    if (active_alarms.erase(id))
+        compact_alarm_heap_if_needed();
 }
 
 std::chrono::steady_clock::time_point repowerd::EventLoopTimer::now()
@@ -84,14 +118,81 @@ std::chrono::steady_clock::time_point repowerd::EventLoopTimer::now()
     return std::chrono::steady_clock::now();
 }
 
-void repowerd::EventLoopTimer::cancel_alarm_unqueued(AlarmId id)
+size_t repowerd::EventLoopTimer::num_stored_alarm_entries()
 {
     std::lock_guard<std::mutex> lock{alarms_mutex};
+    return alarm_heap.size();
+}
+
+void repowerd::EventLoopTimer::handle_timerfd()
+{
+    uint64_t expirations;
+    if (read(timerfd_fd, &expirations, sizeof expirations)) {}
 
-    auto const iter = alarms.find(id);
-    if (iter != alarms.end())
     {
-        iter->second();
-        alarms.erase(iter);
+        std::lock_guard<std::mutex> lock{alarms_mutex};
+
+        auto const current_time = now();
+
+        while (!alarm_heap.empty() && alarm_heap.front().deadline <= current_time)
+        {
+            std::pop_heap(alarm_heap.begin(), alarm_heap.end(), later_alarm<AlarmEntry>);
+            auto const alarm_id = alarm_heap.back().id;
+            alarm_heap.pop_back();
+
+            if (active_alarms.erase(alarm_id))
+                triggered_alarms.push_back(alarm_id);
+        }
+
+        armed_deadline = Deadline::max();
+        arm_timerfd_for_earliest_alarm();
+    }
+
+    for (auto const alarm_id : triggered_alarms)
+        alarm_handler(alarm_id);
+
+    triggered_alarms.clear();
+}
+
+void repowerd::EventLoopTimer::arm_timerfd_for_earliest_alarm()
+{
+    while (!alarm_heap.empty() && !active_alarms.count(alarm_heap.front().id))
+    {
+        std::pop_heap(alarm_heap.begin(), alarm_heap.end(), later_alarm<AlarmEntry>);
+        alarm_heap.pop_back();
     }
+
+    if (!alarm_heap.empty())
+        arm_timerfd(alarm_heap.front().deadline);
+}
+
+void repowerd::EventLoopTimer::arm_timerfd(Deadline deadline)
+{
+    itimerspec timerfd_spec;
+    timerfd_spec.it_interval = {0, 0};
+    timerfd_spec.it_value = to_timespec(deadline);
+
+    if (timerfd_settime(timerfd_fd, TFD_TIMER_ABSTIME, &timerfd_spec, nullptr) == -1)
+        throw std::system_error{errno, std::system_category(), "Failed to arm timerfd"};
+
+    armed_deadline = deadline;
+}
+
+void repowerd::EventLoopTimer::compact_alarm_heap_if_needed()
+{
+    // Frequently rescheduled alarms would otherwise leave behind many
+    // cancelled entries until their deadlines pass
+    if (alarm_heap.size() < min_alarm_heap_size_for_compaction ||
+        alarm_heap.size() < 2 * active_alarms.size())
+    {
+        return;
+    }
+
+    alarm_heap.erase(
+        std::remove_if(
+            alarm_heap.begin(), alarm_heap.end(),
+            [this] (AlarmEntry const& entry) { return !active_alarms.count(entry.id); }),
+        alarm_heap.end());
+
+    std::make_heap(alarm_heap.begin(), alarm_heap.end(), later_alarm<AlarmEntry>);
 }
@@ -20,17 +20,23 @@
 
 #include "src/core/timer.h"
 #include "event_loop.h"
+#include "fd.h"
 
+#include <cstdint>
 #include <mutex>
-#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace repowerd
 {
 
+// Keeps all alarms in a min-heap ordered by deadline, and uses a single
+// timerfd, armed for the earliest deadline, to trigger them. Cancelled
+// alarms are removed from the heap lazily.
 class EventLoopTimer : public Timer
 {
 public:
-    EventLoopTimer();
+    EventLoopTimer(std::shared_ptr<EventLoopExecutor> const& event_loop_executor);
     ~EventLoopTimer();
 
     HandlerRegistration register_alarm_handler(AlarmHandler const& handler) override;
@@ -38,15 +44,36 @@ public:
     void cancel_alarm(AlarmId id) override;
     std::chrono::steady_clock::time_point now() override;
 
+    // For testing only
+    size_t num_stored_alarm_entries();
+
 private:
-    void cancel_alarm_unqueued(AlarmId id);
+    using Deadline = std::chrono::steady_clock::time_point;
+
+    struct AlarmEntry
+    {
+        Deadline deadline;
+        uint64_t sequence;
+        AlarmId id;
+    };
 
+    void handle_timerfd();
+    void arm_timerfd_for_earliest_alarm();
+    void arm_timerfd(Deadline deadline);
+    void compact_alarm_heap_if_needed();
+
+    Fd timerfd_fd;
     EventLoop event_loop;
     AlarmHandler alarm_handler;
 
     std::mutex alarms_mutex;
-    std::unordered_map<AlarmId,EventLoopCancellation> alarms;
+    std::vector<AlarmEntry> alarm_heap;
+    std::unordered_set<AlarmId> active_alarms;
     AlarmId next_alarm_id;
+    uint64_t next_alarm_sequence;
+    Deadline armed_deadline;
+
+    std::vector<AlarmId> triggered_alarms;
 };
 
 }
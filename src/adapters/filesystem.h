@@ -24,6 +24,8 @@
 #include <string>
 #include <vector>
 
+#include <sys/types.h>
+
 namespace repowerd
 {
 class Fd;
@@ -40,6 +42,8 @@ public:
 
     virtual Fd open(char const* pathname, int flags) const = 0;
     virtual int ioctl(int fd, unsigned long request, void* args) const = 0;
+    virtual ssize_t pread(int fd, void* buf, size_t count, off_t offset) const = 0;
+    virtual ssize_t pwrite(int fd, void const* buf, size_t count, off_t offset) const = 0;
 
 protected:
     Filesystem() = default;
@@ -0,0 +1,81 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "latest_value_mailbox.h"
+#include "event_loop.h"
+
+repowerd::LatestValueMailbox::LatestValueMailbox(
+    EventLoop& event_loop, Handler const& handler)
+    : event_loop(event_loop),
+      state{new State{handler, {0.0}, {false}, {false}, {0}}}
+{
+}
+
+repowerd::LatestValueMailbox::~LatestValueMailbox()
+{
+    state->closed = true;
+}
+
+void repowerd::LatestValueMailbox::post(double value)
+{
+    if (store(value))
+    {
+        auto const generation = state->generation.load();
+        event_loop.post([state=state, generation] { deliver(state, generation); });
+    }
+}
+
+void repowerd::LatestValueMailbox::post_in(
+    std::chrono::milliseconds delay, double value)
+{
+    if (store(value))
+    {
+        auto const generation = state->generation.load();
+        event_loop.schedule_in(
+            delay, [state=state, generation] { deliver(state, generation); });
+    }
+}
+
+void repowerd::LatestValueMailbox::flush()
+{
+    if (!state->delivery_pending)
+        return;
+
+    auto const generation = ++state->generation;
+    event_loop.post([state=state, generation] { deliver(state, generation); });
+}
+
+bool repowerd::LatestValueMailbox::store(double value)
+{
+    state->value = value;
+    return !state->delivery_pending.exchange(true);
+}
+
+void repowerd::LatestValueMailbox::deliver(
+    std::shared_ptr<State> const& state, uint64_t generation)
+{
+    if (generation != state->generation)
+        return;
+
+    // Clear the pending flag before reading the value, so that values
+    // stored after this point are guaranteed another delivery
+    state->delivery_pending = false;
+
+    if (!state->closed)
+        state->handler(state->value);
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace repowerd
+{
+
+class EventLoop;
+
+// Hands values from any thread to a handler running on an EventLoop.
+// A value that is still waiting to be handled is replaced by newer values,
+// so at most one delivery is ever queued and a slow handler can't build up
+// a backlog. Deliveries queued when the mailbox is destroyed are dropped.
+class LatestValueMailbox
+{
+public:
+    using Handler = std::function<void(double)>;
+
+    LatestValueMailbox(EventLoop& event_loop, Handler const& handler);
+    ~LatestValueMailbox();
+
+    void post(double value);
+    // Like post(), but the delivery happens after the delay, handing the
+    // latest value posted until then
+    void post_in(std::chrono::milliseconds delay, double value);
+    // Replaces a pending (possibly delayed) delivery with an immediate one
+    void flush();
+
+private:
+    struct State
+    {
+        Handler const handler;
+        std::atomic<double> value;
+        std::atomic<bool> delivery_pending;
+        std::atomic<bool> closed;
+        // Deliveries queued before the latest flush are dropped
+        std::atomic<uint64_t> generation;
+    };
+
+    bool store(double value);
+    static void deliver(std::shared_ptr<State> const& state, uint64_t generation);
+
+    EventLoop& event_loop;
+    std::shared_ptr<State> const state;
+};
+
+}
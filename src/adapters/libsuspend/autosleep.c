@@ -28,27 +28,31 @@ static const char wakeunlock_path[] = "/sys/power/wake_unlock";
 static const char mem_str[] = "mem";
 static const char off_str[] = "off";
 
+static struct sysfs_attr autosleep_attr = SYSFS_ATTR_INIT(autosleep_path);
+static struct sysfs_attr wakelock_attr = SYSFS_ATTR_INIT(wakelock_path);
+static struct sysfs_attr wakeunlock_attr = SYSFS_ATTR_INIT(wakeunlock_path);
+
 static int autosleep_enter(void)
 {
-    int ret = sysfs_write(autosleep_path, mem_str, ARRAY_SIZE(mem_str) - 1);
+    int ret = sysfs_attr_write(&autosleep_attr, mem_str, ARRAY_SIZE(mem_str) - 1);
     return ret < 0 ? ret : 0;
 }
 
 static int autosleep_exit(void)
 {
-    int ret = sysfs_write(autosleep_path, off_str, ARRAY_SIZE(off_str) - 1);
+    int ret = sysfs_attr_write(&autosleep_attr, off_str, ARRAY_SIZE(off_str) - 1);
     return ret < 0 ? ret : 0;
 }
 
 static int autosleep_acquire_wake_lock(const char *name)
 {
-    int ret = sysfs_write(wakelock_path, name, strlen(name));
+    int ret = sysfs_attr_write(&wakelock_attr, name, strlen(name));
     return ret < 0 ? ret : 0;
 }
 
 static int autosleep_release_wake_lock(const char *name)
 {
-    int ret = sysfs_write(wakeunlock_path, name, strlen(name));
+    int ret = sysfs_attr_write(&wakeunlock_attr, name, strlen(name));
     return ret < 0 ? ret : 0;
 }
 
@@ -54,6 +54,10 @@ static const char wakeunlock_path[] = "/sys/power/wake_unlock";
 static const char mem_str[] = "mem";
 static const char on_str[] = "on";
 
+static struct sysfs_attr state_attr = SYSFS_ATTR_INIT(state_path);
+static struct sysfs_attr wakelock_attr = SYSFS_ATTR_INIT(wakelock_path);
+static struct sysfs_attr wakeunlock_attr = SYSFS_ATTR_INIT(wakeunlock_path);
+
 static int wait_for_file(const char *fname)
 {
     int fd, ret;
@@ -109,7 +113,7 @@ static int earlysuspend_enter(void)
     int ret;
     int len = ARRAY_SIZE(mem_str) - 1;
    
-    ret = sysfs_write(state_path, mem_str, len);
+    ret = sysfs_attr_write(&state_attr, mem_str, len);
     if (ret == len && wait_for_fb) {
         pthread_mutex_lock(&fb_state_mutex);
         while (fb_state != FB_SLEEP)
@@ -124,7 +128,7 @@ static int earlysuspend_exit(void)
     int ret;
     int len = ARRAY_SIZE(on_str) - 1;
    
-    ret = sysfs_write(state_path, on_str, len);
+    ret = sysfs_attr_write(&state_attr, on_str, len);
     if (ret == len && wait_for_fb) {
         pthread_mutex_lock(&fb_state_mutex);
         while (fb_state != FB_AWAKE)
@@ -136,13 +140,13 @@ static int earlysuspend_exit(void)
 
 static int earlysuspend_acquire_wake_lock(const char *name)
 {
-    int ret = sysfs_write(wakelock_path, name, strlen(name));
+    int ret = sysfs_attr_write(&wakelock_attr, name, strlen(name));
     return ret < 0 ? ret : 0;
 }
 
 static int earlysuspend_release_wake_lock(const char *name)
 {
-    int ret = sysfs_write(wakeunlock_path, name, strlen(name));
+    int ret = sysfs_attr_write(&wakeunlock_attr, name, strlen(name));
     return ret < 0 ? ret : 0;
 }
 
@@ -161,8 +165,9 @@ const struct suspend_handler *earlysuspend_detect(void)
         sysfs_file_exists(state_path)) {
 
         len = ARRAY_SIZE(on_str) - 1;
-        ret = sysfs_write(state_path, on_str, len);
+        ret = sysfs_attr_write(&state_attr, on_str, len);
         if (ret != len) {
+            sysfs_attr_close(&state_attr);
             return NULL;
         }
 
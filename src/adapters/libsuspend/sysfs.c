@@ -21,6 +21,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
+#include "sysfs.h"
 
 int sysfs_file_exists(const char *path)
 {
@@ -60,3 +61,32 @@ int sysfs_write(const char *path, const void *buf, int len)
     close(fd);
     return ret;
 }
+
+int sysfs_attr_write(struct sysfs_attr *attr, const void *buf, int len)
+{
+    ssize_t ret;
+
+    if (attr->fd == -1) {
+        attr->fd = open(attr->path, O_WRONLY | O_CLOEXEC);
+        if (attr->fd == -1)
+            return -errno;
+    }
+
+    /*
+     * sysfs handles each write as a whole new value, so always write at
+     * the start of the attribute instead of relying on the file offset
+     */
+    ret = pwrite(attr->fd, buf, len, 0);
+    if (ret == -1)
+        ret = -errno;
+
+    return ret;
+}
+
+void sysfs_attr_close(struct sysfs_attr *attr)
+{
+    if (attr->fd != -1) {
+        close(attr->fd);
+        attr->fd = -1;
+    }
+}
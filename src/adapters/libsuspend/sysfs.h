@@ -19,8 +19,31 @@
 #ifndef SYSFS_H
 #define SYSFS_H
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A sysfs attribute that is written repeatedly. The descriptor is opened
+ * on the first write and kept open for the life of the backend, so that
+ * later writes don't pay for open() and close(). Writes to the same
+ * attribute must be serialized by the caller.
+ */
+struct sysfs_attr {
+    const char *path;
+    int fd;
+};
+
+#define SYSFS_ATTR_INIT(attr_path) { .path = (attr_path), .fd = -1 }
+
 int sysfs_file_exists(const char *path);
 int sysfs_read(const char *path, void *buf, int len);
 int sysfs_write(const char *path, const void *buf, int len);
+int sysfs_attr_write(struct sysfs_attr *attr, const void *buf, int len);
+void sysfs_attr_close(struct sysfs_attr *attr);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* SYSFS_H */
@@ -18,9 +18,12 @@
 
 #include "libsuspend_system_power_control.h"
 #include "libsuspend/libsuspend.h"
+#include "suspend_pipeline.h"
 
 #include "src/core/log.h"
+#include "src/core/suspend_metrics.h"
 
+#include <chrono>
 #include <stdexcept>
 
 namespace
@@ -29,9 +32,24 @@ char const* const log_tag = "LibsuspendSystemPowerControl";
 }
 
 repowerd::LibsuspendSystemPowerControl::LibsuspendSystemPowerControl(
-    std::shared_ptr<Log> const& log)
-    : log{log}
+    std::shared_ptr<Log> const& log,
+    std::shared_ptr<SuspendPipeline> const& suspend_pipeline,
+    std::shared_ptr<SuspendMetrics> const& suspend_metrics,
+    std::shared_ptr<EventLoopExecutor> const& event_loop_executor)
+    : log{log},
+      suspend_pipeline{suspend_pipeline},
+      suspend_metrics{suspend_metrics},
+      // The system may have been left in automatic suspend mode, so make
+      // sure the first disallowance exits it
+      suspend_entered{true},
+      suspend_entered_by_us{false},
+      deadline_check_scheduled{false},
+      event_loop{"Suspend", event_loop_executor}
 {
+    stage_completed_handler_registration =
+        suspend_pipeline->register_stage_completed_handler(
+            [this] { event_loop.post([this] { enter_suspend_if_torn_down(); }); });
+
     libsuspend_init(0);
 
     if (std::string{libsuspend_getname()} == "mocksuspend")
@@ -75,9 +93,9 @@ void repowerd::LibsuspendSystemPowerControl::allow_automatic_suspend(
     if (suspend_disallowances.erase(id) > 0 &&
         suspend_disallowances.empty())
     {
-        log->log(log_tag, "Preparing for suspend");
-        libsuspend_prepare_suspend();
-        libsuspend_enter_suspend();
+        suspend_decision_time = std::chrono::steady_clock::now();
+        suspend_metrics->record_suspend_decision(suspend_decision_time);
+        event_loop.post([this] { enter_suspend_if_torn_down(); });
     }
 }
 
@@ -92,13 +110,61 @@ void repowerd::LibsuspendSystemPowerControl::disallow_automatic_suspend(
 
     suspend_disallowances.insert(id);
 
-    if (could_be_suspended)
+    if (could_be_suspended && suspend_entered)
     {
         log->log(log_tag, "exiting suspend");
         libsuspend_exit_suspend();
+        suspend_entered = false;
+        // With autosleep there is no notification of the actual resume,
+        // so treat leaving automatic suspend as the resume. Only suspend
+        // entries we made are part of a suspend cycle, not an automatic
+        // suspend mode left over from before startup.
+        if (suspend_entered_by_us)
+            suspend_metrics->record_resume(std::chrono::steady_clock::now());
     }
 }
 
+void repowerd::LibsuspendSystemPowerControl::enter_suspend_if_torn_down()
+{
+    std::lock_guard<std::mutex> lock{suspend_mutex};
+
+    // Suspend may have been disallowed again or entered by an earlier check
+    if (!suspend_disallowances.empty() || suspend_entered)
+        return;
+
+    if (suspend_pipeline->has_stages_in_progress())
+    {
+        // Check again at the next deadline, in case the stages in progress
+        // don't complete by then. Stages that complete trigger their own
+        // checks.
+        if (!deadline_check_scheduled)
+        {
+            deadline_check_scheduled = true;
+            event_loop.schedule_in(
+                suspend_pipeline->time_until_next_deadline(),
+                [this]
+                {
+                    {
+                        std::lock_guard<std::mutex> lock{suspend_mutex};
+                        deadline_check_scheduled = false;
+                    }
+                    enter_suspend_if_torn_down();
+                });
+        }
+        return;
+    }
+
+    auto const waited = std::chrono::steady_clock::now() - suspend_decision_time;
+
+    log->log(log_tag, "Preparing for suspend, after waiting %.1f ms for teardown",
+             std::chrono::duration<double,std::milli>{waited}.count());
+    libsuspend_prepare_suspend();
+    libsuspend_enter_suspend();
+    suspend_entered = true;
+    suspend_entered_by_us = true;
+    suspend_metrics->record_suspend_entry(std::chrono::steady_clock::now());
+}
+
 void repowerd::LibsuspendSystemPowerControl::power_off()
 {
     log->log(log_tag, "power_off()");
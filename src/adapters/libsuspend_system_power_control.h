@@ -19,7 +19,9 @@
 #pragma once
 
 #include "src/core/system_power_control.h"
+#include "event_loop.h"
 
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <unordered_set>
@@ -27,11 +29,17 @@
 namespace repowerd
 {
 class Log;
+class SuspendMetrics;
+class SuspendPipeline;
 
 class LibsuspendSystemPowerControl : public SystemPowerControl
 {
 public:
-    LibsuspendSystemPowerControl(std::shared_ptr<Log> const& log);
+    LibsuspendSystemPowerControl(
+        std::shared_ptr<Log> const& log,
+        std::shared_ptr<SuspendPipeline> const& suspend_pipeline,
+        std::shared_ptr<SuspendMetrics> const& suspend_metrics,
+        std::shared_ptr<EventLoopExecutor> const& event_loop_executor);
 
     void start_processing() override;
     HandlerRegistration register_system_resume_handler(
@@ -51,10 +59,26 @@ public:
     void disallow_default_system_handlers() override;
 
 private:
+    void enter_suspend_if_torn_down();
+
     std::shared_ptr<Log> const log;
+    std::shared_ptr<SuspendPipeline> const suspend_pipeline;
+    std::shared_ptr<SuspendMetrics> const suspend_metrics;
 
     std::mutex suspend_mutex;
     std::unordered_set<std::string> suspend_disallowances;
+    std::chrono::steady_clock::time_point suspend_decision_time;
+    bool suspend_entered;
+    // Whether we have entered suspend ourselves, as opposed to having
+    // been left in automatic suspend mode before startup
+    bool suspend_entered_by_us;
+    bool deadline_check_scheduled;
+
+    // Waits for teardown steps to complete before entering suspend,
+    // without holding up the caller. Completed steps and step deadlines
+    // trigger checks whether suspend can be entered.
+    EventLoop event_loop;
+    HandlerRegistration stage_completed_handler_registration;
 };
 
 }
@@ -25,8 +25,14 @@
 namespace repowerd
 {
 
+class EventLoop;
+
 using LightHandler = std::function<void(double)>;
 
+// A low rate lets the sensor deliver readings less often, for when the
+// light is stable and readings are unlikely to change the brightness
+enum class LightEventRate { normal, low };
+
 class LightSensor
 {
 public:
@@ -34,9 +40,15 @@ public:
 
     virtual HandlerRegistration register_light_handler(
         LightHandler const& handler) = 0;
+    // Calls the handler directly on the given EventLoop, with only the
+    // latest light value if readings arrive faster than they are handled.
+    // Takes precedence over a handler registered with register_light_handler().
+    virtual HandlerRegistration register_direct_light_handler(
+        EventLoop& event_loop, LightHandler const& handler) = 0;
 
     virtual void enable_light_events() = 0;
     virtual void disable_light_events() = 0;
+    virtual void set_light_event_rate(LightEventRate rate) = 0;
 
 protected:
     LightSensor() = default;
@@ -19,11 +19,18 @@
 #include "logind_session_tracker.h"
 #include "android_device_quirks.h"
 #include "event_loop_handler_registration.h"
+#include "fd.h"
+#include "filesystem.h"
 #include "scoped_g_error.h"
 
 #include "src/core/log.h"
 
 #include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
 
 namespace
 {
@@ -73,21 +80,64 @@ uid_t euid_of_pid(repowerd::Filesystem& fs, pid_t pid)
     return euid;
 }
 
+// Returns the start time of a process in clock ticks since boot, or 0 if
+// it can't be determined. This is the guard against pid reuse for the
+// pid->session cache, so it runs on every lookup and is kept to a single
+// pread of /proc/<pid>/stat, parsed in place.
+unsigned long long start_time_of_pid(repowerd::Filesystem& fs, pid_t pid)
+{
+    auto const path = "/proc/" + std::to_string(pid) + "/stat";
+    auto const stat_fd = fs.open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (stat_fd < 0)
+        return 0;
+
+    // The start time is the 22nd field, well within the first 512 bytes
+    std::array<char, 512> stat;
+    auto const len = fs.pread(stat_fd, stat.data(), stat.size() - 1, 0);
+    if (len <= 0)
+        return 0;
+    stat[len] = '\0';
+
+    // The command name may contain spaces and parentheses, so start parsing
+    // after its closing parenthesis, at the third field (state)
+    char const* pos = strrchr(stat.data(), ')');
+    if (!pos)
+        return 0;
+    ++pos;
+
+    int constexpr fields_before_start_time = 19;
+
+    for (int i = 0; i < fields_before_start_time; ++i)
+    {
+        pos += strspn(pos, " ");
+        pos += strcspn(pos, " ");
+    }
+
+    char* end{nullptr};
+    auto const start_time = strtoull(pos, &end, 10);
+    if (end == pos)
+        return 0;
+
+    return start_time;
+}
+
 }
 
 repowerd::LogindSessionTracker::LogindSessionTracker(
     std::shared_ptr<Filesystem> const& filesystem,
     std::shared_ptr<Log> const& log,
     DeviceQuirks const& quirks,
-    std::string const& dbus_bus_address)
+    std::shared_ptr<DBusConnectionHandle> const& dbus_connection,
+    std::shared_ptr<EventLoopExecutor> const& event_loop_executor)
     : filesystem{filesystem},
       log{log},
       ignore_session_deactivation{quirks.ignore_session_deactivation()},
-      dbus_connection{dbus_bus_address},
-      dbus_event_loop{"Logind"},
+      dbus_connection{dbus_connection},
+      dbus_event_loop{"Logind", event_loop_executor},
       active_session_changed_handler{null_arg2_handler},
       session_removed_handler{null_arg1_handler},
-      active_session_id{invalid_session_id}
+      active_session_id{invalid_session_id},
+      pid_session_cache_counters{0, 0}
 {
 }
 
@@ -156,27 +206,45 @@ repowerd::LogindSessionTracker::register_session_removed_handler(
 
 std::string repowerd::LogindSessionTracker::session_for_pid(pid_t pid)
 {
+    auto const start_time = start_time_of_pid(*filesystem, pid);
+
+    {
+        std::lock_guard<std::mutex> lock{pid_session_cache_mutex};
+
+        auto const iter = pid_session_cache.find(pid);
+        if (start_time != 0 &&
+            iter != pid_session_cache.end() &&
+            iter->second.start_time == start_time)
+        {
+            ++pid_session_cache_counters.hits;
+            return iter->second.session_id;
+        }
+
+        ++pid_session_cache_counters.misses;
+    }
+
     std::string ret_session_id{invalid_session_id};
 
     dbus_event_loop.enqueue(
         [&]
         {
-            auto const session_path = dbus_get_session_path_by_pid(pid);
-            ret_session_id = session_id_for_path(session_path);
-            if (ret_session_id == invalid_session_id)
-            {
-                auto const& active_session_path = tracked_sessions[active_session_id].path;
-                auto const active_session_uid = dbus_get_session_uid(active_session_path);
-                auto const pid_euid = euid_of_pid(*filesystem, pid);
-
-                if (pid_euid == 0 || pid_euid == active_session_uid)
-                    ret_session_id = active_session_id;
-            }
+            ret_session_id = resolve_session_for_pid(pid);
+
+            // Without a start time we can't tell a reused pid apart
+            if (start_time != 0)
+                cache_pid_session(pid, start_time, ret_session_id);
         }).get();
 
     return ret_session_id;
 }
 
+repowerd::LogindSessionTracker::PidSessionCacheStats
+repowerd::LogindSessionTracker::pid_session_cache_stats()
+{
+    std::lock_guard<std::mutex> lock{pid_session_cache_mutex};
+    return pid_session_cache_counters;
+}
+
 void repowerd::LogindSessionTracker::handle_dbus_signal(
     GDBusConnection* /*connection*/,
     gchar const* /*sender*/,
@@ -198,7 +266,10 @@ void repowerd::LogindSessionTracker::handle_dbus_signal(
         std::string const properties_interface{properties_interface_cstr};
 
         if (properties_interface == "org.freedesktop.login1.Seat")
+        {
+            invalidate_pid_session_cache();
             handle_dbus_change_seat_properties(object_path, properties_iter);
+        }
 
         g_variant_iter_free(properties_iter);
     }
@@ -208,6 +279,7 @@ void repowerd::LogindSessionTracker::handle_dbus_signal(
 
         g_variant_get(parameters, "(&s&o)", &session_id_cstr, nullptr);
 
+        invalidate_pid_session_cache();
         remove_session(session_id_cstr);
     }
 }
@@ -476,3 +548,53 @@ uid_t repowerd::LogindSessionTracker::dbus_get_session_uid(std::string const& se
 
     return uid;
 }
+
+std::string repowerd::LogindSessionTracker::resolve_session_for_pid(pid_t pid)
+{
+    auto const session_path = dbus_get_session_path_by_pid(pid);
+    auto session_id = session_id_for_path(session_path);
+
+    if (session_id == invalid_session_id)
+    {
+        auto const& active_session_path = tracked_sessions[active_session_id].path;
+        auto const active_session_uid = dbus_get_session_uid(active_session_path);
+        auto const pid_euid = euid_of_pid(*filesystem, pid);
+
+        if (pid_euid == 0 || pid_euid == active_session_uid)
+            session_id = active_session_id;
+    }
+
+    return session_id;
+}
+
+void repowerd::LogindSessionTracker::cache_pid_session(
+    pid_t pid,
+    unsigned long long start_time,
+    std::string const& session_id)
+{
+    std::lock_guard<std::mutex> lock{pid_session_cache_mutex};
+
+    auto const iter = pid_session_cache.find(pid);
+    if (iter != pid_session_cache.end())
+    {
+        iter->second = {start_time, session_id};
+        return;
+    }
+
+    if (pid_session_cache.size() == max_pid_session_cache_entries)
+    {
+        pid_session_cache.erase(pid_session_cache_order.front());
+        pid_session_cache_order.pop_front();
+    }
+
+    pid_session_cache.emplace(pid, PidSessionCacheEntry{start_time, session_id});
+    pid_session_cache_order.push_back(pid);
+}
+
+void repowerd::LogindSessionTracker::invalidate_pid_session_cache()
+{
+    std::lock_guard<std::mutex> lock{pid_session_cache_mutex};
+
+    pid_session_cache.clear();
+    pid_session_cache_order.clear();
+}
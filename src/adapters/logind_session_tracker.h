@@ -24,7 +24,9 @@
 #include "dbus_event_loop.h"
 #include "filesystem.h"
 
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 
 #include <sys/types.h>
@@ -37,11 +39,20 @@ class DeviceQuirks;
 class LogindSessionTracker : public SessionTracker
 {
 public:
+    struct PidSessionCacheStats
+    {
+        size_t hits;
+        size_t misses;
+    };
+
+    static size_t constexpr max_pid_session_cache_entries = 64;
+
     LogindSessionTracker(
         std::shared_ptr<Filesystem> const& filesystem,
         std::shared_ptr<Log> const& log,
         DeviceQuirks const& device_quirks,
-        std::string const& dbus_bus_address);
+        std::shared_ptr<DBusConnectionHandle> const& dbus_connection,
+        std::shared_ptr<EventLoopExecutor> const& event_loop_executor);
 
     void start_processing() override;
 
@@ -52,6 +63,8 @@ public:
 
     std::string session_for_pid(pid_t pid) override;
 
+    PidSessionCacheStats pid_session_cache_stats();
+
 private:
     void handle_dbus_signal(
         GDBusConnection* connection,
@@ -73,6 +86,12 @@ private:
     std::string dbus_get_session_path_by_pid(pid_t pid);
     std::string session_id_for_path(std::string const& session_path);
     uid_t dbus_get_session_uid(std::string const& session_path);
+    std::string resolve_session_for_pid(pid_t pid);
+    void cache_pid_session(
+        pid_t pid,
+        unsigned long long start_time,
+        std::string const& session_id);
+    void invalidate_pid_session_cache();
 
     std::shared_ptr<Filesystem> const filesystem;
     std::shared_ptr<Log> const log;
@@ -93,6 +112,19 @@ private:
     };
     std::unordered_map<std::string,SessionInfo> tracked_sessions;
     std::string active_session_id;
+
+    // Resolved sessions keyed by pid, with the process start time guarding
+    // against pid reuse. Entries are only added from the event loop, where
+    // invalidation also happens, but are looked up from the calling thread.
+    struct PidSessionCacheEntry
+    {
+        unsigned long long start_time;
+        std::string session_id;
+    };
+    std::mutex pid_session_cache_mutex;
+    std::unordered_map<pid_t,PidSessionCacheEntry> pid_session_cache;
+    std::deque<pid_t> pid_session_cache_order;
+    PidSessionCacheStats pid_session_cache_counters;
 };
 
 }
@@ -21,6 +21,7 @@
 #include "event_loop_handler_registration.h"
 
 #include "src/core/log.h"
+#include "src/core/suspend_metrics.h"
 
 #include <gio/gio.h>
 #include <gio/gunixfdlist.h>
@@ -41,10 +42,13 @@ auto null_arg1_handler = [](auto){};
 
 repowerd::LogindSystemPowerControl::LogindSystemPowerControl(
     std::shared_ptr<Log> const& log,
-    std::string const& dbus_bus_address)
+    std::shared_ptr<SuspendMetrics> const& suspend_metrics,
+    std::shared_ptr<DBusConnectionHandle> const& dbus_connection,
+    std::shared_ptr<EventLoopExecutor> const& event_loop_executor)
     : log{log},
-      dbus_connection{dbus_bus_address},
-      dbus_event_loop{"SystemPower"},
+      suspend_metrics{suspend_metrics},
+      dbus_connection{dbus_connection},
+      dbus_event_loop{"SystemPower", event_loop_executor},
       system_resume_handler{null_arg_handler},
       system_allow_suspend_handler{null_arg1_handler},
       system_disallow_suspend_handler{null_arg1_handler},
@@ -133,6 +137,7 @@ void repowerd::LogindSystemPowerControl::power_off()
 
 void repowerd::LogindSystemPowerControl::suspend()
 {
+    suspend_metrics->record_suspend_decision(std::chrono::steady_clock::now());
     dbus_suspend();
 }
 
@@ -168,10 +173,19 @@ void repowerd::LogindSystemPowerControl::handle_dbus_signal(
         gboolean start{FALSE};
         g_variant_get(parameters, "(b)", &start);
 
+        auto const now = std::chrono::steady_clock::now();
+
         log->log(log_tag, "dbus_PrepareForSleep(%s)", start ? "true" : "false");
 
         if (start == FALSE)
+        {
+            suspend_metrics->record_resume(now);
             system_resume_handler();
+        }
+        else
+        {
+            suspend_metrics->record_suspend_entry(now);
+        }
     }
     else if (signal_name == "PropertiesChanged")
     {
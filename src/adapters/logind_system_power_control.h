@@ -31,13 +31,16 @@
 namespace repowerd
 {
 class Log;
+class SuspendMetrics;
 
 class LogindSystemPowerControl : public SystemPowerControl
 {
 public:
     LogindSystemPowerControl(
         std::shared_ptr<Log> const& log,
-        std::string const& dbus_bus_address);
+        std::shared_ptr<SuspendMetrics> const& suspend_metrics,
+        std::shared_ptr<DBusConnectionHandle> const& dbus_connection,
+        std::shared_ptr<EventLoopExecutor> const& event_loop_executor);
 
     void start_processing() override;
     HandlerRegistration register_system_resume_handler(
@@ -74,6 +77,7 @@ private:
     void notify_suspend_block_state();
 
     std::shared_ptr<Log> const log;
+    std::shared_ptr<SuspendMetrics> const suspend_metrics;
     DBusConnectionHandle dbus_connection;
     DBusEventLoop dbus_event_loop;
 
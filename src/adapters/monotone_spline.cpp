@@ -18,6 +18,7 @@
 
 #include "monotone_spline.h"
 #include <algorithm>
+#include <cmath>
 #include <stdexcept>
 
 namespace
@@ -117,43 +118,93 @@ std::vector<repowerd::MonotoneSpline::Point> sorted(
 
 repowerd::MonotoneSpline::MonotoneSpline(
     std::vector<Point> const& points)
-    : points{sorted(points)},
-      tangents{calculate_monotone_point_tangents(this->points)}
+    : lookup_table_start{0}
 {
+    auto const sorted_points = sorted(points);
+
+    for (auto const& point : sorted_points)
+    {
+        xs.push_back(point.x);
+        ys.push_back(point.y);
+    }
+
+    tangents = calculate_monotone_point_tangents(sorted_points);
 }
 
 double repowerd::MonotoneSpline::interpolate(double x) const
 {
-    auto const i = find_index(x);
+    auto const offset = x - lookup_table_start;
+
+    if (offset >= 0 && offset < lookup_table.size() && offset == std::floor(offset))
+        return lookup_table[static_cast<size_t>(offset)];
+
+    return interpolate_segment(find_index(x), x);
+}
+
+std::vector<double> repowerd::MonotoneSpline::interpolate(
+    std::vector<double> const& xs) const
+{
+    std::vector<double> ys;
+    ys.reserve(xs.size());
+
+    for (auto const x : xs)
+        ys.push_back(interpolate(x));
+
+    return ys;
+}
+
+void repowerd::MonotoneSpline::build_lookup_table(size_t max_entries)
+{
+    lookup_table.clear();
+
+    auto const start = std::ceil(xs.front());
+    auto const end = std::floor(xs.back());
+    if (end < start)
+        return;
 
+    auto const num_entries = static_cast<size_t>(
+        std::min(end - start + 1, static_cast<double>(max_entries)));
+
+    lookup_table_start = start;
+    lookup_table.reserve(num_entries);
+
+    for (auto i = 0u; i < num_entries; ++i)
+    {
+        auto const x = start + i;
+        lookup_table.push_back(interpolate_segment(find_index(x), x));
+    }
+}
+
+size_t repowerd::MonotoneSpline::lookup_table_size() const
+{
+    return lookup_table.size();
+}
+
+double repowerd::MonotoneSpline::interpolate_segment(int i, double x) const
+{
     if (i < 0)
-        return points.front().y;
-    if (i >= static_cast<int>(points.size() - 1))
-        return points.back().y;
+        return ys.front();
+    if (i >= static_cast<int>(xs.size() - 1))
+        return ys.back();
 
-    auto const h = points[i+1].x - points[i].x;
-    auto const t = (x - points[i].x) / h;
+    auto const h = xs[i+1] - xs[i];
+    auto const t = (x - xs[i]) / h;
     auto const h00 = t * t * (2 * t - 3) + 1;
     auto const h10 = t * (1 + t * (t - 2));
     auto const h01 = t * t * (3 - 2 * t);
     auto const h11 = t * t * (t - 1);
 
-    return h00 * points[i].y +
+    return h00 * ys[i] +
            h10 * h * tangents[i] +
-           h01 * points[i+1].y +
+           h01 * ys[i+1] +
            h11 * h * tangents[i+1];
 }
 
 int repowerd::MonotoneSpline::find_index(double x) const
 {
-    if (x < points[0].x)
-        return -1;
-
-    for (auto i = 0u; i < points.size() - 1; ++i)
-    {
-        if (x >= points[i].x && x < points[i+1].x)
-            return i;
-    }
+    // Index of the last control point with xs[i] <= x, i.e. of the segment
+    // with xs[i] <= x < xs[i+1], or -1 if x is before the first point
+    auto const iter = std::upper_bound(xs.begin(), xs.end(), x);
 
-    return points.size() - 1;
+    return static_cast<int>(iter - xs.begin()) - 1;
 }
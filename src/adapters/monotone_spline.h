@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <vector>
 
 namespace repowerd
@@ -25,6 +26,10 @@ namespace repowerd
 
 // Implemented using Monotone cubic Hermite interpolation
 // See: https://en.wikipedia.org/wiki/Monotone_cubic_interpolation
+//
+// Segments are found with a binary search over the (contiguous) x values
+// of the control points. Optionally, results for the integer x values at
+// the start of the range can be precomputed, which doesn't affect them.
 class MonotoneSpline
 {
 public:
@@ -33,12 +38,21 @@ public:
     MonotoneSpline(std::vector<Point> const& points);
 
     double interpolate(double x) const;
+    std::vector<double> interpolate(std::vector<double> const& xs) const;
+
+    void build_lookup_table(size_t max_entries);
+    size_t lookup_table_size() const;
 
 private:
     int find_index(double x) const;
+    double interpolate_segment(int i, double x) const;
 
-    std::vector<Point> points;
+    std::vector<double> xs;
+    std::vector<double> ys;
     std::vector<double> tangents;
+
+    double lookup_table_start;
+    std::vector<double> lookup_table;
 };
 
 }
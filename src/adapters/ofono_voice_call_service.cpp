@@ -115,10 +115,11 @@ bool is_call_state_active(repowerd::OfonoCallState call_state)
 
 repowerd::OfonoVoiceCallService::OfonoVoiceCallService(
     std::shared_ptr<Log> const& log,
-    std::string const& dbus_bus_address)
+    std::shared_ptr<DBusConnectionHandle> const& dbus_connection,
+    std::shared_ptr<EventLoopExecutor> const& event_loop_executor)
     : log{log},
-      dbus_connection{dbus_bus_address},
-      dbus_event_loop{"Ofono"},
+      dbus_connection{dbus_connection},
+      dbus_event_loop{"Ofono", event_loop_executor},
       active_call_handler{null_handler},
       no_active_call_handler{null_handler}
 {
@@ -206,12 +207,12 @@ repowerd::HandlerRegistration repowerd::OfonoVoiceCallService::register_no_activ
 
 void repowerd::OfonoVoiceCallService::set_low_power_mode()
 {
-    dbus_event_loop.enqueue([this] { set_fast_dormancy(true); });
+    dbus_event_loop.post([this] { set_fast_dormancy(true); });
 }
 
 void repowerd::OfonoVoiceCallService::set_normal_power_mode()
 {
-    dbus_event_loop.enqueue([this] { set_fast_dormancy(false); });
+    dbus_event_loop.post([this] { set_fast_dormancy(false); });
 }
 
 std::unordered_set<std::string> repowerd::OfonoVoiceCallService::tracked_modems()
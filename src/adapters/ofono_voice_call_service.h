@@ -48,7 +48,8 @@ class OfonoVoiceCallService : public VoiceCallService, public ModemPowerControl
 public:
     OfonoVoiceCallService(
         std::shared_ptr<Log> const& log,
-        std::string const& dbus_bus_address);
+        std::shared_ptr<DBusConnectionHandle> const& dbus_connection,
+        std::shared_ptr<EventLoopExecutor> const& event_loop_executor);
 
     void start_processing() override;
 
@@ -0,0 +1,53 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "process_status.h"
+#include "filesystem.h"
+
+#include <sstream>
+#include <string>
+
+namespace
+{
+
+size_t field_value(std::string const& line)
+{
+    std::istringstream fields{line.substr(line.find(':') + 1)};
+    size_t value{0};
+    fields >> value;
+    return value;
+}
+
+}
+
+repowerd::ProcessStatus repowerd::current_process_status(Filesystem const& fs)
+{
+    auto proc_status = fs.istream("/proc/self/status");
+    ProcessStatus status{0, 0};
+    std::string line;
+
+    while (std::getline(*proc_status, line))
+    {
+        if (line.find("Threads:") == 0)
+            status.num_threads = field_value(line);
+        else if (line.find("VmRSS:") == 0)
+            status.rss_kb = field_value(line);
+    }
+
+    return status;
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace repowerd
+{
+class Filesystem;
+
+struct ProcessStatus
+{
+    size_t num_threads;
+    size_t rss_kb;
+};
+
+// Reads the thread count and resident set size of the current process
+// from /proc/self/status. Missing fields are reported as 0.
+ProcessStatus current_process_status(Filesystem const& fs);
+
+}
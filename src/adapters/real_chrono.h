@@ -27,6 +27,7 @@ class RealChrono : public Chrono
 {
 public:
     void sleep_for(std::chrono::nanoseconds t) override;
+    std::chrono::steady_clock::time_point steady_now() override;
 };
 
 }
@@ -18,28 +18,112 @@
 
 #include "real_temporary_suspend_inhibition.h"
 
+#include "src/core/log.h"
 #include "src/core/system_power_control.h"
 
+namespace
+{
+char const* const log_tag = "RealTemporarySuspendInhibition";
+char const* const suspend_id = "RealTemporarySuspendInhibition";
+
+double to_ms(std::chrono::steady_clock::duration d)
+{
+    return std::chrono::duration<double,std::milli>{d}.count();
+}
+}
+
 repowerd::RealTemporarySuspendInhibition::RealTemporarySuspendInhibition(
-    std::shared_ptr<SystemPowerControl> const& system_power_control)
+    std::shared_ptr<SystemPowerControl> const& system_power_control,
+    std::shared_ptr<Log> const& log,
+    std::shared_ptr<EventLoopExecutor> const& event_loop_executor)
     : system_power_control{system_power_control},
-      event_loop{"TempSuspendInhibit"},
-      id{0}
+      log{log},
+      inhibited{false},
+      expiry_check_scheduled{false},
+      event_loop{"TempSuspendInhibit", event_loop_executor}
 {
 }
 
 void repowerd::RealTemporarySuspendInhibition::inhibit_suspend_for(
     std::chrono::milliseconds timeout, std::string const& name)
 {
-    auto const cur_id = id++;
-    auto const suspend_id = name + "_" + std::to_string(cur_id);
+    std::lock_guard<std::mutex> lock{inhibition_mutex};
+
+    auto const now = std::chrono::steady_clock::now();
+    auto const deadline = now + timeout;
+
+    auto& reason = inhibition_reasons[name];
+    ++reason.requests;
+    if (deadline > reason.deadline)
+        reason.deadline = deadline;
+
+    if (!inhibited)
+    {
+        log->log(log_tag, "inhibiting suspend for %lld ms (%s)",
+                 static_cast<long long>(timeout.count()), name.c_str());
+
+        system_power_control->disallow_automatic_suspend(suspend_id);
+        inhibited = true;
+        inhibition_start = now;
+        inhibition_deadline = deadline;
+    }
+    else if (deadline > inhibition_deadline)
+    {
+        inhibition_deadline = deadline;
+    }
+
+    // A pending check reschedules itself if the deadline has moved
+    if (!expiry_check_scheduled)
+        schedule_expiry_check(inhibition_deadline - now);
+}
+
+void repowerd::RealTemporarySuspendInhibition::schedule_expiry_check(
+    std::chrono::steady_clock::duration timeout)
+{
+    // Round up, so that the check doesn't run before the deadline
+    auto const timeout_ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            timeout + std::chrono::milliseconds{1} - std::chrono::nanoseconds{1});
+
+    expiry_check_scheduled = true;
+    event_loop.schedule_in(timeout_ms, [this] { check_expiry(); });
+}
+
+void repowerd::RealTemporarySuspendInhibition::check_expiry()
+{
+    std::lock_guard<std::mutex> lock{inhibition_mutex};
+
+    expiry_check_scheduled = false;
+
+    auto const now = std::chrono::steady_clock::now();
+
+    if (now < inhibition_deadline)
+    {
+        schedule_expiry_check(inhibition_deadline - now);
+        return;
+    }
+
+    log->log(log_tag, "releasing suspend inhibition held for %.1f ms, reasons: %s",
+             to_ms(now - inhibition_start), reasons_to_str().c_str());
+
+    system_power_control->allow_automatic_suspend(suspend_id);
+    inhibited = false;
+    inhibition_reasons.clear();
+}
+
+std::string repowerd::RealTemporarySuspendInhibition::reasons_to_str()
+{
+    std::string str;
 
-    system_power_control->disallow_automatic_suspend(suspend_id);
+    for (auto const& reason : inhibition_reasons)
+    {
+        if (!str.empty())
+            str += ", ";
+        str += reason.first + "(" + std::to_string(reason.second.requests) +
+               " requests, until +" +
+               std::to_string(static_cast<long long>(
+                   to_ms(reason.second.deadline - inhibition_start))) + " ms)";
+    }
 
-    event_loop.schedule_in(
-        timeout,
-        [this, suspend_id]
-        {
-            system_power_control->allow_automatic_suspend(suspend_id);
-        });
+    return str;
 }
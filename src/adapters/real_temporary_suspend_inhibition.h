@@ -21,24 +21,55 @@
 #include "temporary_suspend_inhibition.h"
 #include "event_loop.h"
 
-#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 
 namespace repowerd
 {
+class Log;
 class SystemPowerControl;
 
+// Aggregates all temporary inhibitions into a single suspend disallowance,
+// which lasts until the latest requested deadline. New requests only move
+// the deadline forward, without touching the system power control or
+// adding timers.
 class RealTemporarySuspendInhibition : public TemporarySuspendInhibition
 {
 public:
-    RealTemporarySuspendInhibition(std::shared_ptr<SystemPowerControl> const& system_power_control);
+    RealTemporarySuspendInhibition(
+        std::shared_ptr<SystemPowerControl> const& system_power_control,
+        std::shared_ptr<Log> const& log,
+        std::shared_ptr<EventLoopExecutor> const& event_loop_executor);
 
     void inhibit_suspend_for(std::chrono::milliseconds timeout, std::string const& name) override;
 
 private:
+    struct ReasonStats
+    {
+        uint64_t requests;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    void schedule_expiry_check(std::chrono::steady_clock::duration timeout);
+    void check_expiry();
+    std::string reasons_to_str();
+
     std::shared_ptr<SystemPowerControl> const system_power_control;
+    std::shared_ptr<Log> const log;
+
+    std::mutex inhibition_mutex;
+    bool inhibited;
+    bool expiry_check_scheduled;
+    std::chrono::steady_clock::time_point inhibition_start;
+    std::chrono::steady_clock::time_point inhibition_deadline;
+    // Per-reason accounting of the current inhibition, for debugging
+    std::unordered_map<std::string,ReasonStats> inhibition_reasons;
+
     EventLoop event_loop;
-    std::atomic<unsigned int> id;
 };
 
 }
@@ -20,8 +20,10 @@
 #include "event_loop_handler_registration.h"
 #include "scoped_g_error.h"
 
+#include "src/core/dispatch_metrics.h"
 #include "src/core/infinite_timeout.h"
 #include "src/core/log.h"
+#include "src/core/suspend_metrics.h"
 
 #include <stdexcept>
 
@@ -52,6 +54,19 @@ char const* const repowerd_service_introspection = R"(
     <method name='SetCriticalPowerBehavior'>
       <arg type='s' name='action' direction='in' />
     </method>
+    <method name='GetDispatchMetrics'>
+      <arg type='at' name='latency_bucket_limits_usec' direction='out' />
+      <arg type='a(statat)' name='event_latencies' direction='out' />
+      <arg type='at' name='queue_depth_bucket_limits' direction='out' />
+      <arg type='at' name='queue_depth_histogram' direction='out' />
+      <arg type='t' name='max_queue_depth' direction='out' />
+      <arg type='t' name='queue_overflows' direction='out' />
+      <arg type='t' name='coalesced_events' direction='out' />
+    </method>
+    <method name='GetSuspendMetrics'>
+      <arg type='t' name='total_cycles' direction='out' />
+      <arg type='a(ttt)' name='recent_cycles_usec' direction='out' />
+    </method>
   </interface>
 </node>)";
 
@@ -79,14 +94,26 @@ repowerd::PowerSupply power_supply_from_string(std::string const& str)
         throw std::invalid_argument{"Invalid power supply: " + str};
 }
 
+template<size_t N>
+GVariant* uint64_array_variant(std::array<uint64_t,N> const& values)
+{
+    return g_variant_new_fixed_array(
+        G_VARIANT_TYPE_UINT64, values.data(), N, sizeof(uint64_t));
+}
+
 }
 
 repowerd::RepowerdService::RepowerdService(
+    std::shared_ptr<DispatchMetrics> const& dispatch_metrics,
+    std::shared_ptr<SuspendMetrics> const& suspend_metrics,
     std::shared_ptr<Log> const& log,
-    std::string const& dbus_bus_address)
-    : log{log},
-      dbus_connection{dbus_bus_address},
-      dbus_event_loop{"RepowerdService"},
+    std::shared_ptr<DBusConnectionHandle> const& dbus_connection,
+    std::shared_ptr<EventLoopExecutor> const& event_loop_executor)
+    : dispatch_metrics{dispatch_metrics},
+      suspend_metrics{suspend_metrics},
+      log{log},
+      dbus_connection{dbus_connection},
+      dbus_event_loop{"RepowerdService", event_loop_executor},
       set_inactivity_behavior_handler{null_arg4_handler},
       set_lid_behavior_handler{null_arg3_handler},
       set_critical_power_behavior_handler{null_arg2_handler}
@@ -202,6 +229,18 @@ void repowerd::RepowerdService::dbus_method_call(
 
         g_dbus_method_invocation_return_value(invocation, NULL);
     }
+    else if (method_name == "GetDispatchMetrics")
+    {
+        auto const metrics = dbus_GetDispatchMetrics(sender);
+
+        g_dbus_method_invocation_return_value(invocation, metrics);
+    }
+    else if (method_name == "GetSuspendMetrics")
+    {
+        auto const metrics = dbus_GetSuspendMetrics(sender);
+
+        g_dbus_method_invocation_return_value(invocation, metrics);
+    }
     else
     {
         dbus_unknown_method(sender, method_name);
@@ -282,6 +321,60 @@ void repowerd::RepowerdService::dbus_SetCriticalPowerBehavior(
     set_critical_power_behavior_handler(power_action, pid);
 }
 
+GVariant* repowerd::RepowerdService::dbus_GetDispatchMetrics(
+    std::string const& sender)
+{
+    log->log(log_tag, "dbus_GetDispatchMetrics(%s)", sender.c_str());
+
+    GVariantBuilder event_latencies_builder;
+    g_variant_builder_init(&event_latencies_builder, G_VARIANT_TYPE("a(statat)"));
+
+    for (size_t i = 0; i < num_dispatch_event_kinds; ++i)
+    {
+        auto const kind = static_cast<DispatchEventKind>(i);
+        auto const latencies = dispatch_metrics->event_latencies(kind);
+
+        g_variant_builder_add(
+            &event_latencies_builder, "(st@at@at)",
+            dispatch_event_kind_name(kind),
+            latencies.count,
+            uint64_array_variant(latencies.queue_wait),
+            uint64_array_variant(latencies.handling));
+    }
+
+    return g_variant_new(
+        "(@ata(statat)@at@atttt)",
+        uint64_array_variant(DispatchMetrics::latency_bucket_limits_usec()),
+        &event_latencies_builder,
+        uint64_array_variant(DispatchMetrics::depth_bucket_limits()),
+        uint64_array_variant(dispatch_metrics->queue_depth_histogram()),
+        dispatch_metrics->max_queue_depth(),
+        dispatch_metrics->queue_overflows(),
+        dispatch_metrics->coalesced_events());
+}
+
+GVariant* repowerd::RepowerdService::dbus_GetSuspendMetrics(
+    std::string const& sender)
+{
+    log->log(log_tag, "dbus_GetSuspendMetrics(%s)", sender.c_str());
+
+    auto const total_cycles = suspend_metrics->total_cycles();
+
+    GVariantBuilder cycles_builder;
+    g_variant_builder_init(&cycles_builder, G_VARIANT_TYPE("a(ttt)"));
+
+    for (auto const& cycle : suspend_metrics->recent_cycles())
+    {
+        g_variant_builder_add(
+            &cycles_builder, "(ttt)",
+            cycle.decision_to_suspend_usec,
+            cycle.resume_to_first_event_usec,
+            cycle.resume_to_display_on_usec);
+    }
+
+    return g_variant_new("(ta(ttt))", total_cycles, &cycles_builder);
+}
+
 void repowerd::RepowerdService::dbus_unknown_method(
     std::string const& sender, std::string const& name)
 {
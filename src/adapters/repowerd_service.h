@@ -30,14 +30,19 @@
 
 namespace repowerd
 {
+class DispatchMetrics;
 class Log;
+class SuspendMetrics;
 
 class RepowerdService : public ClientSettings
 {
 public:
     RepowerdService(
+        std::shared_ptr<DispatchMetrics> const& dispatch_metrics,
+        std::shared_ptr<SuspendMetrics> const& suspend_metrics,
         std::shared_ptr<Log> const& log,
-        std::string const& dbus_bus_address);
+        std::shared_ptr<DBusConnectionHandle> const& dbus_connection,
+        std::shared_ptr<EventLoopExecutor> const& event_loop_executor);
 
     void start_processing() override;
 
@@ -75,10 +80,14 @@ private:
         std::string const& sender,
         std::string const& power_action,
         pid_t pid);
+    GVariant* dbus_GetDispatchMetrics(std::string const& sender);
+    GVariant* dbus_GetSuspendMetrics(std::string const& sender);
 
     void dbus_unknown_method(std::string const& sender, std::string const& name);
     pid_t dbus_get_invocation_sender_pid(GDBusMethodInvocation* invocation);
 
+    std::shared_ptr<DispatchMetrics> const dispatch_metrics;
+    std::shared_ptr<SuspendMetrics> const suspend_metrics;
     std::shared_ptr<Log> const log;
     DBusConnectionHandle dbus_connection;
     DBusEventLoop dbus_event_loop;
@@ -0,0 +1,140 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "simulated_clock.h"
+#include "event_loop.h"
+
+#include <algorithm>
+
+namespace
+{
+
+// Parts of repowerd treat a default constructed time_point as "never", so
+// start the simulation well clear of it
+auto const simulation_start =
+    std::chrono::steady_clock::time_point{} + std::chrono::hours{24};
+
+}
+
+repowerd::SimulatedClock::SimulatedClock()
+    : now{simulation_start},
+      next_timeout_id{1}
+{
+}
+
+void repowerd::SimulatedClock::sleep_for(std::chrono::nanoseconds t)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    now += std::chrono::duration_cast<std::chrono::steady_clock::duration>(t);
+}
+
+std::chrono::steady_clock::time_point repowerd::SimulatedClock::steady_now()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return now;
+}
+
+void repowerd::SimulatedClock::advance_to(
+    std::chrono::steady_clock::time_point time_point)
+{
+    run_pending();
+
+    while (true)
+    {
+        Timeout timeout{};
+
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+
+            auto const iter = timeouts.begin();
+            if (iter == timeouts.end() || iter->first > time_point)
+                break;
+
+            now = std::max(now, iter->first);
+            timeout = std::move(iter->second);
+            timeouts.erase(iter);
+        }
+
+        timeout.event_loop->enqueue(timeout.callback).wait();
+        run_pending();
+    }
+
+    std::lock_guard<std::mutex> lock{mutex};
+    now = std::max(now, time_point);
+}
+
+void repowerd::SimulatedClock::run_pending()
+{
+    std::vector<EventLoop*> event_loops_snapshot;
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        event_loops_snapshot = event_loops;
+    }
+
+    for (auto const event_loop : event_loops_snapshot)
+        event_loop->enqueue([]{}).wait();
+}
+
+void repowerd::SimulatedClock::attach(EventLoop& event_loop)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    event_loops.push_back(&event_loop);
+}
+
+void repowerd::SimulatedClock::detach(EventLoop& event_loop)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    event_loops.erase(
+        std::remove(event_loops.begin(), event_loops.end(), &event_loop),
+        event_loops.end());
+
+    for (auto iter = timeouts.begin(); iter != timeouts.end();)
+    {
+        if (iter->second.event_loop == &event_loop)
+            iter = timeouts.erase(iter);
+        else
+            ++iter;
+    }
+}
+
+uint64_t repowerd::SimulatedClock::schedule_in(
+    EventLoop& event_loop,
+    std::chrono::milliseconds timeout,
+    std::function<void()> const& callback)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const id = next_timeout_id++;
+    timeouts.emplace(now + timeout, Timeout{id, &event_loop, callback});
+
+    return id;
+}
+
+void repowerd::SimulatedClock::cancel(uint64_t timeout_id)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const iter = std::find_if(
+        timeouts.begin(), timeouts.end(),
+        [timeout_id] (auto const& entry) { return entry.second.id == timeout_id; });
+
+    if (iter != timeouts.end())
+        timeouts.erase(iter);
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#pragma once
+
+#include "chrono.h"
+#include "event_loop_time_source.h"
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace repowerd
+{
+
+class EventLoop;
+
+// A clock that only advances when told to, for running simulations faster
+// than real time. The timeouts of the EventLoops constructed with a
+// SimulatedClock as their time source are driven by it instead of by the
+// real time.
+//
+// advance_to() and run_pending() wait for EventLoop callbacks, so they must
+// only be called from the thread driving the simulation.
+class SimulatedClock : public Chrono, public EventLoopTimeSource
+{
+public:
+    SimulatedClock();
+
+    // Advances the time, but doesn't run any timeouts
+    void sleep_for(std::chrono::nanoseconds t) override;
+    std::chrono::steady_clock::time_point steady_now() override;
+
+    // Runs all timeouts due up to and including time_point in order, each
+    // at its own due time, and waits for the attached EventLoops to
+    // process the callbacks queued as a result
+    void advance_to(std::chrono::steady_clock::time_point time_point);
+    // Waits for the attached EventLoops to process their queued callbacks
+    void run_pending();
+
+    void attach(EventLoop& event_loop) override;
+    void detach(EventLoop& event_loop) override;
+
+    uint64_t schedule_in(
+        EventLoop& event_loop,
+        std::chrono::milliseconds timeout,
+        std::function<void()> const& callback) override;
+    void cancel(uint64_t timeout_id) override;
+
+private:
+    struct Timeout
+    {
+        uint64_t id;
+        EventLoop* event_loop;
+        std::function<void()> callback;
+    };
+
+    std::mutex mutex;
+    std::chrono::steady_clock::time_point now;
+    std::multimap<std::chrono::steady_clock::time_point,Timeout> timeouts;
+    std::vector<EventLoop*> event_loops;
+    uint64_t next_timeout_id;
+};
+
+}
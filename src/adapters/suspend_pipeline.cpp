@@ -0,0 +1,192 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "suspend_pipeline.h"
+#include "chrono.h"
+
+#include "src/core/log.h"
+
+#include <algorithm>
+
+namespace
+{
+
+char const* const log_tag = "SuspendPipeline";
+
+size_t index_of(repowerd::SuspendStage stage)
+{
+    return static_cast<size_t>(stage);
+}
+
+double to_ms(std::chrono::steady_clock::duration d)
+{
+    return std::chrono::duration<double,std::milli>{d}.count();
+}
+
+// Rounds up, so that a deadline has been reached once the time has passed
+std::chrono::milliseconds to_ms_rounded_up(std::chrono::steady_clock::duration d)
+{
+    if (d <= std::chrono::steady_clock::duration::zero())
+        return std::chrono::milliseconds::zero();
+
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        d + std::chrono::milliseconds{1} - std::chrono::steady_clock::duration{1});
+}
+
+}
+
+char const* repowerd::suspend_stage_name(SuspendStage stage)
+{
+    switch (stage)
+    {
+    case SuspendStage::backlight_off: return "backlight_off";
+    case SuspendStage::panel_off: return "panel_off";
+    case SuspendStage::interactive_mode_disabled: return "interactive_mode_disabled";
+    }
+
+    return "unknown";
+}
+
+repowerd::SuspendPipeline::SuspendPipeline(
+    std::shared_ptr<Chrono> const& chrono,
+    std::shared_ptr<Log> const& log,
+    std::chrono::milliseconds stage_deadline)
+    : chrono{chrono},
+      log{log},
+      stage_deadline{stage_deadline},
+      next_handler_id{1}
+{
+    stages.fill({false, {}});
+}
+
+void repowerd::SuspendPipeline::start_stage(SuspendStage stage)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    stages[index_of(stage)] = {true, chrono->steady_now()};
+}
+
+void repowerd::SuspendPipeline::complete_stage(SuspendStage stage)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto& state = stages[index_of(stage)];
+    if (!state.in_progress)
+        return;
+
+    state.in_progress = false;
+
+    auto const duration = chrono->steady_now() - state.start;
+    if (duration > stage_deadline)
+    {
+        log->log(log_tag, "%s completed late, after %.1f ms",
+                 suspend_stage_name(stage), to_ms(duration));
+    }
+
+    for (auto const& id_and_handler : stage_completed_handlers)
+        id_and_handler.second();
+}
+
+bool repowerd::SuspendPipeline::has_stages_in_progress()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const now = chrono->steady_now();
+    auto in_progress = false;
+
+    for (size_t i = 0; i < stages.size(); ++i)
+    {
+        auto& state = stages[i];
+        if (!state.in_progress)
+            continue;
+
+        if (now >= state.start + stage_deadline)
+        {
+            // Stop waiting for this stage in later suspend entries too
+            state.in_progress = false;
+
+            log->log(log_tag, "%s missed its deadline, not waiting for it",
+                     suspend_stage_name(static_cast<SuspendStage>(i)));
+        }
+        else
+        {
+            in_progress = true;
+        }
+    }
+
+    return in_progress;
+}
+
+std::chrono::milliseconds repowerd::SuspendPipeline::time_until_next_deadline()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const now = chrono->steady_now();
+    auto time_until = std::chrono::steady_clock::duration::max();
+
+    for (auto const& state : stages)
+    {
+        if (state.in_progress)
+            time_until = std::min(time_until, state.start + stage_deadline - now);
+    }
+
+    if (time_until == std::chrono::steady_clock::duration::max())
+        return std::chrono::milliseconds::zero();
+
+    return to_ms_rounded_up(time_until);
+}
+
+bool repowerd::SuspendPipeline::is_stage_in_progress(SuspendStage stage)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const& state = stages[index_of(stage)];
+
+    return state.in_progress &&
+           chrono->steady_now() < state.start + stage_deadline;
+}
+
+std::chrono::milliseconds repowerd::SuspendPipeline::time_until_deadline(
+    SuspendStage stage)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const& state = stages[index_of(stage)];
+    if (!state.in_progress)
+        return std::chrono::milliseconds::zero();
+
+    return to_ms_rounded_up(
+        state.start + stage_deadline - chrono->steady_now());
+}
+
+repowerd::HandlerRegistration
+repowerd::SuspendPipeline::register_stage_completed_handler(
+    StageCompletedHandler const& handler)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const id = next_handler_id++;
+    stage_completed_handlers.emplace(id, handler);
+
+    return HandlerRegistration{
+        [this, id]
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            stage_completed_handlers.erase(id);
+        }};
+}
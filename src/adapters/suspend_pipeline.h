@@ -0,0 +1,103 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#pragma once
+
+#include "src/core/handler_registration.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace repowerd
+{
+
+class Chrono;
+class Log;
+
+enum class SuspendStage
+{
+    backlight_off,
+    panel_off,
+    interactive_mode_disabled
+};
+
+size_t constexpr num_suspend_stages =
+    static_cast<size_t>(SuspendStage::interactive_mode_disabled) + 1;
+
+char const* suspend_stage_name(SuspendStage stage);
+
+// Tracks the steps of tearing down the system before suspending, which the
+// adapters run concurrently on their own threads, so that entering suspend
+// needs to wait only for the steps still in progress. Each step gets a
+// deadline, after which suspend entry stops waiting for it.
+class SuspendPipeline
+{
+public:
+    using StageCompletedHandler = std::function<void()>;
+
+    SuspendPipeline(
+        std::shared_ptr<Chrono> const& chrono,
+        std::shared_ptr<Log> const& log,
+        std::chrono::milliseconds stage_deadline);
+
+    void start_stage(SuspendStage stage);
+    void complete_stage(SuspendStage stage);
+
+    // Whether any started stage is still in progress. Stages that reach
+    // their deadline stop counting as in progress, and are logged.
+    bool has_stages_in_progress();
+    // How long until the earliest deadline of the stages in progress
+    std::chrono::milliseconds time_until_next_deadline();
+    // Whether the stage has started, and has neither completed nor reached
+    // its deadline
+    bool is_stage_in_progress(SuspendStage stage);
+    // How long until the stage reaches its deadline, zero if it's not in
+    // progress
+    std::chrono::milliseconds time_until_deadline(SuspendStage stage);
+
+    // Handlers are called on the thread that completes the stage, and
+    // must not call back into the pipeline
+    HandlerRegistration register_stage_completed_handler(
+        StageCompletedHandler const& handler);
+
+private:
+    SuspendPipeline(SuspendPipeline const&) = delete;
+    SuspendPipeline& operator=(SuspendPipeline const&) = delete;
+
+    struct StageState
+    {
+        bool in_progress;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    std::shared_ptr<Chrono> const chrono;
+    std::shared_ptr<Log> const log;
+    std::chrono::milliseconds const stage_deadline;
+
+    std::mutex mutex;
+    std::array<StageState,num_suspend_stages> stages;
+    std::unordered_map<int,StageCompletedHandler> stage_completed_handlers;
+    int next_handler_id;
+};
+
+}
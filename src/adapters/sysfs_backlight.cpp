@@ -24,10 +24,14 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
 #include <stdexcept>
 #include <vector>
 
+#include <fcntl.h>
+
 namespace
 {
 char const* const log_tag = "SysfsBacklight";
@@ -98,6 +102,16 @@ int determine_max_brightness(
     return max_brightness;
 }
 
+repowerd::Fd open_brightness_file(
+    repowerd::Filesystem& filesystem, repowerd::Path const& brightness_file)
+{
+    auto fd = filesystem.open(
+        std::string{brightness_file}.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0)
+        throw std::runtime_error("Couldn't open sysfs backlight brightness file");
+    return fd;
+}
+
 }
 
 repowerd::SysfsBacklight::SysfsBacklight(
@@ -107,7 +121,12 @@ repowerd::SysfsBacklight::SysfsBacklight(
       sysfs_backlight_dir{determine_sysfs_backlight_dir(*filesystem)},
       sysfs_brightness_file{sysfs_backlight_dir/"brightness"},
       max_brightness{determine_max_brightness(*filesystem, sysfs_backlight_dir)},
-      last_set_brightness{-1.0}
+      sysfs_brightness_fd{open_brightness_file(*filesystem, sysfs_brightness_file)},
+      last_set_brightness{-1.0},
+      last_written_brightness{-1},
+      io_buffer{},
+      issued_writes{0},
+      elided_writes{0}
 {
     log->log(log_tag, "Using backlight %s",
              std::string{sysfs_backlight_dir}.c_str());
@@ -115,17 +134,37 @@ repowerd::SysfsBacklight::SysfsBacklight(
 
 void repowerd::SysfsBacklight::set_brightness(double value)
 {
-    auto ostream = filesystem->ostream(sysfs_brightness_file);
-    *ostream << absolute_brightness_for(value);
-    ostream->flush();
+    auto const abs_brightness = absolute_brightness_for(value);
     last_set_brightness = value;
+
+    // Panels with a small max_brightness map many relative brightness
+    // values to the same absolute value, so many transition steps don't
+    // need to touch the hardware at all
+    if (abs_brightness == last_written_brightness)
+    {
+        ++elided_writes;
+        return;
+    }
+
+    auto const len = snprintf(io_buffer.data(), io_buffer.size(), "%d", abs_brightness);
+
+    ++issued_writes;
+    if (filesystem->pwrite(sysfs_brightness_fd, io_buffer.data(), len, 0) == len)
+        last_written_brightness = abs_brightness;
+    else
+        last_written_brightness = -1;
 }
 
 double repowerd::SysfsBacklight::get_brightness()
 {
-    auto istream = filesystem->istream(sysfs_brightness_file);
-    int abs_brightness = 0;
-    *istream >> abs_brightness;
+    auto const len = filesystem->pread(
+        sysfs_brightness_fd, io_buffer.data(), io_buffer.size() - 1, 0);
+    io_buffer[len > 0 ? len : 0] = '\0';
+    int const abs_brightness = std::atoi(io_buffer.data());
+
+    // Someone else may have changed the brightness, in which case the
+    // next write must not be elided
+    last_written_brightness = len > 0 ? abs_brightness : -1;
 
     if (absolute_brightness_for(last_set_brightness) == abs_brightness)
         return last_set_brightness;
@@ -133,6 +172,16 @@ double repowerd::SysfsBacklight::get_brightness()
         return static_cast<double>(abs_brightness) / max_brightness;
 }
 
+uint64_t repowerd::SysfsBacklight::num_issued_writes() const
+{
+    return issued_writes;
+}
+
+uint64_t repowerd::SysfsBacklight::num_elided_writes() const
+{
+    return elided_writes;
+}
+
 int repowerd::SysfsBacklight::absolute_brightness_for(double rel_brightness)
 {
     return static_cast<int>(round(rel_brightness * max_brightness));
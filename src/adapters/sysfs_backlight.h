@@ -20,8 +20,12 @@
 
 #include "backlight.h"
 
+#include "fd.h"
 #include "path.h"
 
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -40,6 +44,11 @@ public:
     void set_brightness(double) override;
     double get_brightness() override;
 
+    // Writes to the brightness file, and writes skipped because the
+    // absolute brightness value was already written
+    uint64_t num_issued_writes() const;
+    uint64_t num_elided_writes() const;
+
 private:
     int absolute_brightness_for(double relative_brightness);
 
@@ -47,7 +56,12 @@ private:
     Path const sysfs_backlight_dir;
     Path const sysfs_brightness_file;
     int const max_brightness;
+    Fd const sysfs_brightness_fd;
     double last_set_brightness;
+    int last_written_brightness;
+    std::array<char,16> io_buffer;
+    std::atomic<uint64_t> issued_writes;
+    std::atomic<uint64_t> elided_writes;
 };
 
 }
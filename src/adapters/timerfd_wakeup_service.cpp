@@ -45,11 +45,13 @@ timespec to_timespec(std::chrono::system_clock::time_point const& tp)
 
 }
 
-repowerd::TimerfdWakeupService::TimerfdWakeupService(std::shared_ptr<Log> const& log)
+repowerd::TimerfdWakeupService::TimerfdWakeupService(
+    std::shared_ptr<Log> const& log,
+    std::shared_ptr<EventLoopExecutor> const& event_loop_executor)
     : timerfd_fd{timerfd_create(CLOCK_REALTIME_ALARM, TFD_CLOEXEC)},
       cookie_pool{1},
       wakeup_handler{null_handler},
-      event_loop{"Wakeup"}
+      event_loop{"Wakeup", event_loop_executor}
 {
     if (timerfd_fd == -1) {
         log->log(log_tag, "Failed to create timerfd with CLOCK_REALTIME_ALARM, trying CLOCK_REALTIME PLEASE note this will not wake up the device from suspend!");
@@ -32,7 +32,9 @@ class Log;
 class TimerfdWakeupService : public WakeupService
 {
 public:
-    TimerfdWakeupService(std::shared_ptr<Log> const& log);
+    TimerfdWakeupService(
+        std::shared_ptr<Log> const& log,
+        std::shared_ptr<EventLoopExecutor> const& event_loop_executor);
 
     std::string schedule_wakeup_at(std::chrono::system_clock::time_point tp) override;
     void cancel_wakeup(std::string const& cookie) override;
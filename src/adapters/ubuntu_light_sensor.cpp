@@ -18,19 +18,30 @@
 
 #include "ubuntu_light_sensor.h"
 #include "event_loop_handler_registration.h"
+#include "latest_value_mailbox.h"
 
 #include <stdexcept>
 
 namespace
 {
 auto const null_handler = [](double){};
+// The low rate is a sensor event period in ns. The normal rate is the
+// device default, which the platform applies when the sensor is enabled.
+uint32_t const low_rate_event_period_ns = 2000000000;
+// At a low rate, readings are also batched in case the sensor doesn't
+// honor the requested period, delivering only the latest one per period
+auto const low_rate_batch_period = std::chrono::milliseconds{2000};
 }
 
-repowerd::UbuntuLightSensor::UbuntuLightSensor()
+repowerd::UbuntuLightSensor::UbuntuLightSensor(
+    std::shared_ptr<EventLoopExecutor> const& event_loop_executor)
     : sensor{ua_sensors_light_new()},
-      event_loop{"Light"},
+      event_loop{"Light", event_loop_executor},
       handler{null_handler},
-      enabled{false}
+      enabled{false},
+      rate{LightEventRate::normal},
+      batch_flush_scheduled{false},
+      batched_light_value{0.0}
 {
     if (!sensor)
         throw std::runtime_error("Failed to allocate light sensor");
@@ -38,6 +49,8 @@ repowerd::UbuntuLightSensor::UbuntuLightSensor()
     ua_sensors_light_set_reading_cb(sensor, static_sensor_reading_callback, this);
 }
 
+repowerd::UbuntuLightSensor::~UbuntuLightSensor() = default;
+
 repowerd::HandlerRegistration repowerd::UbuntuLightSensor::register_light_handler(
     LightHandler const& handler)
 {
@@ -47,6 +60,29 @@ repowerd::HandlerRegistration repowerd::UbuntuLightSensor::register_light_handle
         [this]{ this->handler = null_handler; }};
 }
 
+repowerd::HandlerRegistration repowerd::UbuntuLightSensor::register_direct_light_handler(
+    EventLoop& direct_event_loop, LightHandler const& handler)
+{
+    return EventLoopHandlerRegistration{
+        direct_event_loop,
+        [this, &direct_event_loop, &handler]
+        {
+            std::lock_guard<std::mutex> lock{direct_mailbox_mutex};
+            direct_mailbox = std::make_unique<LatestValueMailbox>(
+                direct_event_loop,
+                [this, handler] (double light_value)
+                {
+                    if (enabled)
+                        handler(light_value);
+                });
+        },
+        [this]
+        {
+            std::lock_guard<std::mutex> lock{direct_mailbox_mutex};
+            direct_mailbox.reset();
+        }};
+}
+
 void repowerd::UbuntuLightSensor::enable_light_events()
 {
     event_loop.enqueue(
@@ -56,6 +92,9 @@ void repowerd::UbuntuLightSensor::enable_light_events()
             {
                 ua_sensors_light_enable(sensor);
                 enabled = true;
+
+                if (rate == LightEventRate::low)
+                    ua_sensors_light_set_event_rate(sensor, low_rate_event_period_ns);
             }
         }).get();
 }
@@ -69,20 +108,100 @@ void repowerd::UbuntuLightSensor::disable_light_events()
             {
                 ua_sensors_light_disable(sensor);
                 enabled = false;
+                batch_flush_scheduled = false;
             }
         }).get();
 }
 
+void repowerd::UbuntuLightSensor::set_light_event_rate(LightEventRate rate)
+{
+    event_loop.post(
+        [this, rate]
+        {
+            if (this->rate == rate)
+                return;
+
+            this->rate = rate;
+
+            if (enabled)
+            {
+                if (rate == LightEventRate::low)
+                {
+                    ua_sensors_light_set_event_rate(sensor, low_rate_event_period_ns);
+                }
+                else
+                {
+                    // The device default period can't be queried, so
+                    // re-enable the sensor to have the platform restore it
+                    ua_sensors_light_disable(sensor);
+                    ua_sensors_light_enable(sensor);
+                }
+            }
+
+            if (rate == LightEventRate::normal)
+            {
+                if (batch_flush_scheduled)
+                    flush_batched_light_event();
+
+                // Don't hold back a reading delayed at the low rate
+                std::lock_guard<std::mutex> lock{direct_mailbox_mutex};
+                if (direct_mailbox)
+                    direct_mailbox->flush();
+            }
+        });
+}
+
 void repowerd::UbuntuLightSensor::static_sensor_reading_callback(
     UASLightEvent* event, void* context)
 {
     auto const uls = static_cast<UbuntuLightSensor*>(context);
     float light_value{0.0f};
     uas_light_event_get_light(event, &light_value);
-    uls->event_loop.enqueue([uls, light_value] { uls->handle_light_event(light_value); });
+
+    {
+        std::lock_guard<std::mutex> lock{uls->direct_mailbox_mutex};
+        if (uls->direct_mailbox)
+        {
+            // The mailbox batches readings by itself, so at a low rate we
+            // only need to delay the delivery
+            if (uls->rate == LightEventRate::low)
+                uls->direct_mailbox->post_in(low_rate_batch_period, light_value);
+            else
+                uls->direct_mailbox->post(light_value);
+            return;
+        }
+    }
+
+    uls->event_loop.post([uls, light_value] { uls->handle_light_event(light_value); });
 }
 
 void repowerd::UbuntuLightSensor::handle_light_event(double light)
 {
-    handler(light);
+    if (rate == LightEventRate::normal)
+    {
+        handler(light);
+        return;
+    }
+
+    batched_light_value = light;
+
+    if (!batch_flush_scheduled)
+    {
+        batch_flush_scheduled = true;
+        event_loop.schedule_in(
+            low_rate_batch_period,
+            [this]
+            {
+                if (batch_flush_scheduled)
+                    flush_batched_light_event();
+            });
+    }
+}
+
+void repowerd::UbuntuLightSensor::flush_batched_light_event()
+{
+    batch_flush_scheduled = false;
+
+    if (enabled)
+        handler(batched_light_value);
 }
@@ -23,27 +23,44 @@
 
 #include <ubuntu/application/sensors/light.h>
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+
 namespace repowerd
 {
 
+class LatestValueMailbox;
+
 class UbuntuLightSensor : public LightSensor
 {
 public:
-    UbuntuLightSensor();
+    UbuntuLightSensor(std::shared_ptr<EventLoopExecutor> const& event_loop_executor);
+    ~UbuntuLightSensor();
 
     HandlerRegistration register_light_handler(LightHandler const& handler) override;
+    HandlerRegistration register_direct_light_handler(
+        EventLoop& event_loop, LightHandler const& handler) override;
 
     void enable_light_events() override;
     void disable_light_events() override;
+    void set_light_event_rate(LightEventRate rate) override;
 
 private:
     static void static_sensor_reading_callback(UASLightEvent* event, void* context);
     void handle_light_event(double light_value);
+    void flush_batched_light_event();
 
     UASensorsLight* const sensor;
     EventLoop event_loop;
     LightHandler handler;
-    bool enabled;
+    std::atomic<bool> enabled;
+    std::atomic<LightEventRate> rate;
+    bool batch_flush_scheduled;
+    double batched_light_value;
+
+    std::mutex direct_mailbox_mutex;
+    std::unique_ptr<LatestValueMailbox> direct_mailbox;
 };
 
 }
@@ -17,6 +17,8 @@
  */
 
 #include "ubuntu_performance_booster.h"
+#include "suspend_pipeline.h"
+#include "wake_pipeline.h"
 
 #include "src/core/log.h"
 
@@ -33,9 +35,15 @@ void u_hardware_booster_deleter(UHardwareBooster* booster)
 }
 
 repowerd::UbuntuPerformanceBooster::UbuntuPerformanceBooster(
-    std::shared_ptr<Log> const& log)
+    std::shared_ptr<Log> const& log,
+    std::shared_ptr<WakePipeline> const& wake_pipeline,
+    std::shared_ptr<SuspendPipeline> const& suspend_pipeline,
+    std::shared_ptr<EventLoopExecutor> const& event_loop_executor)
     : log{log},
-      booster{u_hardware_booster_new(), u_hardware_booster_deleter}
+      wake_pipeline{wake_pipeline},
+      suspend_pipeline{suspend_pipeline},
+      booster{u_hardware_booster_new(), u_hardware_booster_deleter},
+      event_loop{"Booster", event_loop_executor}
 {
     if (!booster)
         throw std::runtime_error{"Failed to create ubuntu performance booster"};
@@ -47,16 +55,28 @@ void repowerd::UbuntuPerformanceBooster::enable_interactive_mode()
 {
     log->log(log_tag, "enable_interactive_mode()");
 
-    u_hardware_booster_enable_scenario(
-        booster.get(),
-        U_HARDWARE_BOOSTER_SCENARIO_USER_INTERACTION);
+    event_loop.post(
+        [this]
+        {
+            u_hardware_booster_enable_scenario(
+                booster.get(),
+                U_HARDWARE_BOOSTER_SCENARIO_USER_INTERACTION);
+            wake_pipeline->complete_stage(WakeStage::interactive_mode_enabled);
+        });
 }
 
 void repowerd::UbuntuPerformanceBooster::disable_interactive_mode()
 {
     log->log(log_tag, "disable_interactive_mode()");
 
-    u_hardware_booster_disable_scenario(
-        booster.get(),
-        U_HARDWARE_BOOSTER_SCENARIO_USER_INTERACTION);
+    suspend_pipeline->start_stage(SuspendStage::interactive_mode_disabled);
+
+    event_loop.post(
+        [this]
+        {
+            u_hardware_booster_disable_scenario(
+                booster.get(),
+                U_HARDWARE_BOOSTER_SCENARIO_USER_INTERACTION);
+            suspend_pipeline->complete_stage(SuspendStage::interactive_mode_disabled);
+        });
 }
@@ -19,6 +19,7 @@
 #pragma once
 
 #include "src/core/performance_booster.h"
+#include "event_loop.h"
 
 #include <ubuntu/hardware/booster.h>
 
@@ -28,11 +29,17 @@ namespace repowerd
 {
 
 class Log;
+class SuspendPipeline;
+class WakePipeline;
 
 class UbuntuPerformanceBooster : public PerformanceBooster
 {
 public:
-    UbuntuPerformanceBooster(std::shared_ptr<Log> const& log);
+    UbuntuPerformanceBooster(
+        std::shared_ptr<Log> const& log,
+        std::shared_ptr<WakePipeline> const& wake_pipeline,
+        std::shared_ptr<SuspendPipeline> const& suspend_pipeline,
+        std::shared_ptr<EventLoopExecutor> const& event_loop_executor);
     ~UbuntuPerformanceBooster();
 
     void enable_interactive_mode() override;
@@ -40,7 +47,12 @@ public:
 
 private:
     std::shared_ptr<Log> const log;
+    std::shared_ptr<WakePipeline> const wake_pipeline;
+    std::shared_ptr<SuspendPipeline> const suspend_pipeline;
     std::unique_ptr<UHardwareBooster,void(*)(UHardwareBooster*)> booster;
+    // The booster HAL calls may block, so they are made on their own
+    // thread, concurrently with the rest of the display power changes
+    EventLoop event_loop;
 };
 
 }
@@ -40,10 +40,11 @@ char const* proximity_state_to_cstr(repowerd::ProximityState state)
 
 repowerd::UbuntuProximitySensor::UbuntuProximitySensor(
     std::shared_ptr<Log> const& log,
-    DeviceQuirks const& device_quirks)
+    DeviceQuirks const& device_quirks,
+    std::shared_ptr<EventLoopExecutor> const& event_loop_executor)
     : log{log},
       sensor{ua_sensors_proximity_new()},
-      event_loop{"Proximity"},
+      event_loop{"Proximity", event_loop_executor},
       handler{null_handler},
       synthetic_event_seqno{1},
       synthetic_event_delay{device_quirks.synthetic_initial_proximity_event_delay()},
@@ -81,7 +82,7 @@ repowerd::ProximityState repowerd::UbuntuProximitySensor::proximity_state()
 
     auto const valid_state = wait_for_valid_state();
 
-    event_loop.enqueue(
+    event_loop.post(
         [this]
         {
             disable_proximity_events_unqueued(EnablementMode::without_handler);
@@ -130,7 +131,7 @@ void repowerd::UbuntuProximitySensor::static_sensor_reading_callback(
     auto const state = (distance == U_PROXIMITY_NEAR) ?
                        ProximityState::near : ProximityState::far;
 
-    ups->event_loop.enqueue([ups, state] { ups->handle_proximity_event(state); });
+    ups->event_loop.post([ups, state] { ups->handle_proximity_event(state); });
 }
 
 void repowerd::UbuntuProximitySensor::handle_proximity_event(ProximityState new_state)
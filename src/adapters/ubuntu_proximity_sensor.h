@@ -39,7 +39,8 @@ class UbuntuProximitySensor : public ProximitySensor
 public:
     UbuntuProximitySensor(
         std::shared_ptr<Log> const& log,
-        DeviceQuirks const& device_quirks);
+        DeviceQuirks const& device_quirks,
+        std::shared_ptr<EventLoopExecutor> const& event_loop_executor);
 
     HandlerRegistration register_proximity_handler(
         ProximityHandler const& handler) override;
@@ -18,6 +18,10 @@
 
 #include "unity_display.h"
 #include "scoped_g_error.h"
+#include "suspend_pipeline.h"
+#include "wake_pipeline.h"
+
+#include "src/core/suspend_metrics.h"
 
 #include <gio/gio.h>
 
@@ -27,6 +31,7 @@ char const* const unity_display_bus_name = "com.canonical.Unity.Display";
 char const* const unity_display_object_path = "/com/canonical/Unity/Display";
 char const* const unity_display_interface_name = "com.canonical.Unity.Display";
 char const* const log_tag = "UnityDisplay";
+int const display_power_call_timeout_ms = 1000;
 
 std::string filter_to_str(repowerd::DisplayPowerControlFilter filter)
 {
@@ -48,14 +53,26 @@ std::string filter_to_str(repowerd::DisplayPowerControlFilter filter)
 
 repowerd::UnityDisplay::UnityDisplay(
     std::shared_ptr<Log> const& log,
-    std::string const& dbus_bus_address)
+    std::shared_ptr<WakePipeline> const& wake_pipeline,
+    std::shared_ptr<SuspendPipeline> const& suspend_pipeline,
+    std::shared_ptr<SuspendMetrics> const& suspend_metrics,
+    std::shared_ptr<DBusConnectionHandle> const& dbus_connection,
+    std::shared_ptr<EventLoopExecutor> const& event_loop_executor)
     : log{log},
-      dbus_connection{dbus_bus_address},
-      dbus_event_loop{"Display"},
-      has_active_external_displays_{false}
+      wake_pipeline{wake_pipeline},
+      suspend_pipeline{suspend_pipeline},
+      suspend_metrics{suspend_metrics},
+      dbus_connection{dbus_connection},
+      dbus_event_loop{"Display", event_loop_executor},
+      has_active_external_displays_{false},
+      display_on_requested{false},
+      display_power_cancellable{g_cancellable_new()},
+      display_power_call_in_flight{false},
+      in_flight_display_power_request{false, DisplayPowerControlFilter::all},
+      backlight_off_deadline_check_scheduled{false}
 {
     dbus_signal_handler_registration = dbus_event_loop.register_signal_handler(
-        dbus_connection,
+        this->dbus_connection,
         unity_display_bus_name,
         "org.freedesktop.DBus.Properties",
         "PropertiesChanged",
@@ -73,30 +90,44 @@ repowerd::UnityDisplay::UnityDisplay(
                 signal_name, parameters);
         });
 
+    suspend_stage_handler_registration =
+        suspend_pipeline->register_stage_completed_handler(
+            [this]
+            {
+                dbus_event_loop.post([this] { send_next_display_power_request(); });
+            });
+
     dbus_event_loop.enqueue([this] { dbus_query_active_outputs(); }).get();
 }
 
+repowerd::UnityDisplay::~UnityDisplay()
+{
+    suspend_stage_handler_registration = HandlerRegistration{};
+
+    // Display power calls complete on the event loop thread, so cancelling
+    // there guarantees no completion touches the display after this point
+    dbus_event_loop.enqueue(
+        [this]
+        {
+            g_cancellable_cancel(display_power_cancellable);
+            pending_display_power_requests.clear();
+        }).wait();
+
+    g_object_unref(display_power_cancellable);
+}
+
 void repowerd::UnityDisplay::turn_on(DisplayPowerControlFilter filter)
 {
     auto const filter_str = filter_to_str(filter);
 
     log->log(log_tag, "turn_on(%s)", filter_str.c_str());
 
-    auto const reply = g_dbus_connection_call_sync(
-        dbus_connection,
-        unity_display_bus_name,
-        unity_display_object_path,
-        unity_display_interface_name,
-        "TurnOn",
-        g_variant_new("(s)", filter_str.c_str()),
-        nullptr,
-        G_DBUS_CALL_FLAGS_NONE,
-        /* timeout_msec */ 1000,
-        nullptr,
-        nullptr);
+    if (!display_on_requested)
+        wake_pipeline->start_wake();
+    display_on_requested = true;
 
-    if (reply)
-        g_variant_unref(reply);
+    dbus_event_loop.post(
+        [this, filter] { queue_display_power_request({true, filter}); });
 }
 
 void repowerd::UnityDisplay::turn_off(DisplayPowerControlFilter filter)
@@ -105,19 +136,153 @@ void repowerd::UnityDisplay::turn_off(DisplayPowerControlFilter filter)
 
     log->log(log_tag, "turn_off(%s)", filter_str.c_str());
 
+    if (display_on_requested)
+        suspend_pipeline->start_stage(SuspendStage::panel_off);
+    display_on_requested = false;
+
+    dbus_event_loop.post(
+        [this, filter] { queue_display_power_request({false, filter}); });
+}
+
+struct repowerd::UnityDisplay::DisplayPowerCall
+{
+    UnityDisplay* const display;
+    GCancellable* const cancellable;
+    DisplayPowerRequest const request;
+};
+
+void repowerd::UnityDisplay::queue_display_power_request(
+    DisplayPowerRequest const& request)
+{
+    // A request supersedes a pending opposite request for the same outputs,
+    // and is dropped if the outputs are already going to be in the
+    // requested state, so e.g. on->off->on while on is in flight
+    // results in no additional calls
+    auto& pending = pending_display_power_requests;
+
+    if (!pending.empty() && pending.back().filter == request.filter)
+        pending.pop_back();
+
+    bool const already_requested =
+        pending.empty() ?
+            display_power_call_in_flight &&
+                in_flight_display_power_request == request :
+            pending.back() == request;
+
+    if (already_requested)
+    {
+        log->log(log_tag, "%s(%s) collapsed with earlier request",
+                 request.on ? "turn_on" : "turn_off",
+                 filter_to_str(request.filter).c_str());
+    }
+    else
+    {
+        pending.push_back(request);
+    }
+
+    send_next_display_power_request();
+}
+
+void repowerd::UnityDisplay::send_next_display_power_request()
+{
+    if (display_power_call_in_flight || pending_display_power_requests.empty())
+        return;
+
+    if (!pending_display_power_requests.front().on &&
+        panel_off_waits_for_backlight())
+    {
+        return;
+    }
+
+    auto const request = pending_display_power_requests.front();
+    pending_display_power_requests.pop_front();
+
+    display_power_call_in_flight = true;
+    in_flight_display_power_request = request;
+
+    auto const call = new DisplayPowerCall{
+        this,
+        G_CANCELLABLE(g_object_ref(display_power_cancellable)),
+        request};
+
     g_dbus_connection_call(
         dbus_connection,
         unity_display_bus_name,
         unity_display_object_path,
         unity_display_interface_name,
-        "TurnOff",
-        g_variant_new("(s)", filter_str.c_str()),
+        request.on ? "TurnOn" : "TurnOff",
+        g_variant_new("(s)", filter_to_str(request.filter).c_str()),
         nullptr,
         G_DBUS_CALL_FLAGS_NONE,
-        -1,
-        nullptr,
-        nullptr,
-        nullptr);
+        display_power_call_timeout_ms,
+        display_power_cancellable,
+        [] (GObject* source, GAsyncResult* async_result, gpointer user_data)
+        {
+            std::unique_ptr<DisplayPowerCall> const call{
+                static_cast<DisplayPowerCall*>(user_data)};
+            ScopedGError error;
+
+            auto const result = g_dbus_connection_call_finish(
+                G_DBUS_CONNECTION(source), async_result, error);
+
+            if (!g_cancellable_is_cancelled(call->cancellable))
+            {
+                call->display->dbus_handle_display_power_reply(
+                    call->request, result ? "" : error.message_str());
+            }
+
+            if (result)
+                g_variant_unref(result);
+            g_object_unref(call->cancellable);
+        },
+        call);
+}
+
+bool repowerd::UnityDisplay::panel_off_waits_for_backlight()
+{
+    // Turning the panel off while the backlight is fading out would cut
+    // the fade short. The completion of the fade triggers a new attempt.
+    if (!suspend_pipeline->is_stage_in_progress(SuspendStage::backlight_off))
+        return false;
+
+    if (!backlight_off_deadline_check_scheduled)
+    {
+        backlight_off_deadline_check_scheduled = true;
+        dbus_event_loop.schedule_in(
+            suspend_pipeline->time_until_deadline(SuspendStage::backlight_off),
+            [this]
+            {
+                backlight_off_deadline_check_scheduled = false;
+                send_next_display_power_request();
+            });
+    }
+
+    return true;
+}
+
+void repowerd::UnityDisplay::dbus_handle_display_power_reply(
+    DisplayPowerRequest const& request, std::string const& error)
+{
+    if (!error.empty())
+    {
+        log->log(log_tag, "%s(%s) failed: %s",
+                 request.on ? "turn_on" : "turn_off",
+                 filter_to_str(request.filter).c_str(),
+                 error.c_str());
+    }
+    else if (request.on)
+    {
+        suspend_metrics->record_display_on(std::chrono::steady_clock::now());
+    }
+
+    // Don't hold up the rest of the wake if the compositor failed to reply
+    if (request.on)
+        wake_pipeline->complete_stage(WakeStage::panel_on);
+    else
+        suspend_pipeline->complete_stage(SuspendStage::panel_off);
+
+    display_power_call_in_flight = false;
+    send_next_display_power_request();
 }
 
 bool repowerd::UnityDisplay::has_active_external_displays()
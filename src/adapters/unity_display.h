@@ -28,17 +28,26 @@
 
 #include <memory>
 #include <atomic>
+#include <deque>
 
 namespace repowerd
 {
 class Log;
+class SuspendMetrics;
+class SuspendPipeline;
+class WakePipeline;
 
 class UnityDisplay : public DisplayPowerControl, public DisplayInformation
 {
 public:
     UnityDisplay(
         std::shared_ptr<Log> const& log,
-        std::string const& dbus_bus_address);
+        std::shared_ptr<WakePipeline> const& wake_pipeline,
+        std::shared_ptr<SuspendPipeline> const& suspend_pipeline,
+        std::shared_ptr<SuspendMetrics> const& suspend_metrics,
+        std::shared_ptr<DBusConnectionHandle> const& dbus_connection,
+        std::shared_ptr<EventLoopExecutor> const& event_loop_executor);
+    ~UnityDisplay();
 
     // From DisplayPowerControl
     void turn_on(DisplayPowerControlFilter filter) override;
@@ -48,6 +57,23 @@ public:
     bool has_active_external_displays() override;
 
 private:
+    struct DisplayPowerRequest
+    {
+        bool operator==(DisplayPowerRequest const& other) const
+        {
+            return on == other.on && filter == other.filter;
+        }
+
+        bool on;
+        DisplayPowerControlFilter filter;
+    };
+    struct DisplayPowerCall;
+
+    void queue_display_power_request(DisplayPowerRequest const& request);
+    void send_next_display_power_request();
+    bool panel_off_waits_for_backlight();
+    void dbus_handle_display_power_reply(
+        DisplayPowerRequest const& request, std::string const& error);
     void handle_dbus_signal(
         GDBusConnection* connection,
         gchar const* sender,
@@ -61,10 +87,27 @@ private:
 
 
     std::shared_ptr<Log> const log;
+    std::shared_ptr<WakePipeline> const wake_pipeline;
+    std::shared_ptr<SuspendPipeline> const suspend_pipeline;
+    std::shared_ptr<SuspendMetrics> const suspend_metrics;
     DBusConnectionHandle dbus_connection;
     DBusEventLoop dbus_event_loop;
     HandlerRegistration dbus_signal_handler_registration;
     std::atomic<bool> has_active_external_displays_;
+    // Only accessed from the thread calling turn_on() and turn_off()
+    bool display_on_requested;
+
+    // Display power requests are sent in order, one at a time, so that
+    // requests made while a call is in flight can be collapsed into their
+    // net effect. Only accessed from the dbus event loop thread.
+    GCancellable* const display_power_cancellable;
+    std::deque<DisplayPowerRequest> pending_display_power_requests;
+    bool display_power_call_in_flight;
+    DisplayPowerRequest in_flight_display_power_request;
+    // Turning the panel off is held until the backlight has faded out, at
+    // most until the backlight_off suspend stage reaches its deadline
+    bool backlight_off_deadline_check_scheduled;
+    HandlerRegistration suspend_stage_handler_registration;
 };
 
 }
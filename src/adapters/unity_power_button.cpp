@@ -28,9 +28,10 @@ char const* const dbus_power_button_interface = "com.canonical.Unity.PowerButton
 }
 
 repowerd::UnityPowerButton::UnityPowerButton(
-    std::string const& dbus_bus_address)
-    : dbus_connection{dbus_bus_address},
-      dbus_event_loop{"PowerButton"},
+    std::shared_ptr<DBusConnectionHandle> const& dbus_connection,
+    std::shared_ptr<EventLoopExecutor> const& event_loop_executor)
+    : dbus_connection{dbus_connection},
+      dbus_event_loop{"PowerButton", event_loop_executor},
       power_button_handler{null_handler}
 {
 }
@@ -30,7 +30,9 @@ namespace repowerd
 class UnityPowerButton : public PowerButton, public PowerButtonEventSink
 {
 public:
-    UnityPowerButton(std::string const& dbus_bus_address);
+    UnityPowerButton(
+        std::shared_ptr<DBusConnectionHandle> const& dbus_connection,
+        std::shared_ptr<EventLoopExecutor> const& event_loop_executor);
 
     void start_processing() override;
 
@@ -27,7 +27,9 @@
 #include "src/core/infinite_timeout.h"
 #include "src/core/log.h"
 
+#include <chrono>
 #include <cmath>
+#include <memory>
 
 namespace
 {
@@ -153,19 +155,29 @@ std::string notification_id(std::string const& sender, size_t index)
 
 }
 
+struct repowerd::UnityScreenService::SenderCredentialsRequest
+{
+    UnityScreenService* const service;
+    GCancellable* const cancellable;
+    std::string const sender;
+    std::vector<GDBusMethodInvocation*> invocations;
+    bool sender_disconnected;
+};
+
 repowerd::UnityScreenService::UnityScreenService(
     std::shared_ptr<WakeupService> const& wakeup_service,
     std::shared_ptr<BrightnessNotification> const& brightness_notification,
     std::shared_ptr<Log> const& log,
     std::shared_ptr<TemporarySuspendInhibition> const& temporary_suspend_inhibition,
     DeviceConfig const& device_config,
-    std::string const& dbus_bus_address)
+    std::shared_ptr<DBusConnectionHandle> const& dbus_connection,
+    std::shared_ptr<EventLoopExecutor> const& event_loop_executor)
     : wakeup_service{wakeup_service},
       brightness_notification{brightness_notification},
       temporary_suspend_inhibition{temporary_suspend_inhibition},
       log{log},
-      dbus_connection{dbus_bus_address},
-      dbus_event_loop{"DBusService"},
+      dbus_connection{dbus_connection},
+      dbus_event_loop{"DBusService", event_loop_executor},
       disable_inactivity_timeout_handler{null_arg2_handler},
       enable_inactivity_timeout_handler{null_arg2_handler},
       set_inactivity_timeout_handler{null_arg2_handler},
@@ -179,10 +191,40 @@ repowerd::UnityScreenService::UnityScreenService(
       started{false},
       next_keep_display_on_id{1},
       next_request_sys_state_id{1},
-      brightness_params(BrightnessParams::from_device_config(device_config))
+      brightness_params(BrightnessParams::from_device_config(device_config)),
+      sender_credentials_cancellable{g_cancellable_new()},
+      num_sender_credentials_lookups{0}
 {
 }
 
+repowerd::UnityScreenService::~UnityScreenService()
+{
+    // Stop receiving method calls before cancelling the credential lookups
+    // in flight. Cancelled lookups still complete on the event loop thread,
+    // failing their parked invocations and freeing their requests, so wait
+    // until all of them have completed. If they don't complete in time,
+    // stop the event loop so that they never run.
+    unity_screen_handler_registration = HandlerRegistration{};
+    powerd_handler_registration = HandlerRegistration{};
+
+    dbus_event_loop.enqueue(
+        [this] { g_cancellable_cancel(sender_credentials_cancellable); }).wait();
+
+    auto constexpr timeout = std::chrono::seconds{3};
+    std::unique_lock<std::mutex> lock{sender_credentials_lookups_mutex};
+
+    if (!sender_credentials_lookups_completed.wait_for(
+            lock, timeout, [this] { return num_sender_credentials_lookups == 0; }))
+    {
+        log->log(log_tag, "%zu credential lookups did not complete on shutdown",
+                 num_sender_credentials_lookups);
+        lock.unlock();
+        dbus_event_loop.stop();
+    }
+
+    g_object_unref(sender_credentials_cancellable);
+}
+
 void repowerd::UnityScreenService::start_processing()
 {
     if (started) return;
@@ -248,13 +290,13 @@ void repowerd::UnityScreenService::start_processing()
             temporary_suspend_inhibition->inhibit_suspend_for(
                 std::chrono::seconds{3}, "Wakeup_" + cookie);
 
-            dbus_event_loop.enqueue([this] { dbus_emit_Wakeup(); });
+            dbus_event_loop.post([this] { dbus_emit_Wakeup(); });
         });
 
     brightness_handler_registration = brightness_notification->register_brightness_handler(
         [this] (double brightness)
         {
-            dbus_event_loop.enqueue([this,brightness] { dbus_emit_brightness(brightness); });
+            dbus_event_loop.post([this,brightness] { dbus_emit_brightness(brightness); });
         });
 
     dbus_connection.request_name(dbus_screen_service_name);
@@ -387,13 +429,29 @@ void repowerd::UnityScreenService::dbus_method_call(
     gchar const* sender_cstr,
     gchar const* /*object_path_cstr*/,
     gchar const* /*interface_name_cstr*/,
-    gchar const* method_name_cstr,
-    GVariant* parameters,
+    gchar const* /*method_name_cstr*/,
+    GVariant* /*parameters*/,
     GDBusMethodInvocation* invocation)
 {
     std::string const sender{sender_cstr ? sender_cstr : ""};
+
+    auto const credentials = sender_credentials.find(sender);
+    if (credentials != sender_credentials.end())
+        dbus_dispatch_method_call(invocation, credentials->second);
+    else
+        dbus_request_sender_credentials(sender, invocation);
+}
+
+void repowerd::UnityScreenService::dbus_dispatch_method_call(
+    GDBusMethodInvocation* invocation,
+    SenderCredentials const& credentials)
+{
+    auto const sender_cstr = g_dbus_method_invocation_get_sender(invocation);
+    auto const method_name_cstr = g_dbus_method_invocation_get_method_name(invocation);
+    auto const parameters = g_dbus_method_invocation_get_parameters(invocation);
+    std::string const sender{sender_cstr ? sender_cstr : ""};
     std::string const method_name{method_name_cstr ? method_name_cstr : ""};
-    auto const pid = dbus_get_invocation_sender_pid(invocation);
+    auto const pid = credentials.pid;
 
     if (method_name == "keepDisplayOn")
     {
@@ -589,6 +647,16 @@ void repowerd::UnityScreenService::dbus_NameOwnerChanged(
     std::string const& old_owner,
     std::string const& new_owner)
 {
+    // Calls from a sender whose credentials are still being looked up
+    // haven't been handled yet, so handle its disconnection after them
+    auto const pending = sender_credentials_requests.find(name);
+    if (pending != sender_credentials_requests.end() &&
+        new_owner.empty() && old_owner == name)
+    {
+        pending->second->sender_disconnected = true;
+        return;
+    }
+
     if (keep_display_on_ids.find(name) != keep_display_on_ids.end() ||
         request_sys_state_ids.find(name) != request_sys_state_ids.end() ||
         active_notifications.find(name) != active_notifications.end())
@@ -599,6 +667,8 @@ void repowerd::UnityScreenService::dbus_NameOwnerChanged(
 
     if (new_owner.empty() && old_owner == name)
     {
+        sender_credentials.erase(name);
+
         auto const kdo_range = keep_display_on_ids.equal_range(name);
         for (auto iter = kdo_range.first; iter != kdo_range.second; ++iter)
             enable_inactivity_timeout_handler(std::to_string(iter->second), 0);
@@ -828,37 +898,116 @@ void repowerd::UnityScreenService::dbus_unknown_method(
     log->log(log_tag, "dbus_unknown_method(%s,%s)", sender.c_str(), name.c_str());
 }
 
-pid_t repowerd::UnityScreenService::dbus_get_invocation_sender_pid(
+void repowerd::UnityScreenService::dbus_request_sender_credentials(
+    std::string const& sender,
     GDBusMethodInvocation* invocation)
 {
+    auto const pending = sender_credentials_requests.find(sender);
+    if (pending != sender_credentials_requests.end())
+    {
+        pending->second->invocations.push_back(invocation);
+        return;
+    }
+
     int constexpr timeout = 1000;
-    auto constexpr null_cancellable = nullptr;
-    ScopedGError error;
-    auto const sender = g_dbus_method_invocation_get_sender(invocation);
+    auto const request = new SenderCredentialsRequest{
+        this,
+        G_CANCELLABLE(g_object_ref(sender_credentials_cancellable)),
+        sender,
+        {invocation},
+        false};
+
+    sender_credentials_requests.emplace(sender, request);
+
+    {
+        std::lock_guard<std::mutex> lock{sender_credentials_lookups_mutex};
+        ++num_sender_credentials_lookups;
+    }
 
-    auto const result = g_dbus_connection_call_sync(
+    g_dbus_connection_call(
         dbus_connection,
         "org.freedesktop.DBus",
         "/org/freedesktop/DBus",
         "org.freedesktop.DBus",
-        "GetConnectionUnixProcessID",
-        g_variant_new("(s)", sender),
-        G_VARIANT_TYPE("(u)"),
+        "GetConnectionCredentials",
+        g_variant_new("(s)", sender.c_str()),
+        G_VARIANT_TYPE("(a{sv})"),
         G_DBUS_CALL_FLAGS_NONE,
         timeout,
-        null_cancellable,
-        error);
+        sender_credentials_cancellable,
+        [] (GObject* source, GAsyncResult* async_result, gpointer user_data)
+        {
+            std::unique_ptr<SenderCredentialsRequest> const request{
+                static_cast<SenderCredentialsRequest*>(user_data)};
+            ScopedGError error;
+
+            auto const result = g_dbus_connection_call_finish(
+                G_DBUS_CONNECTION(source), async_result, error);
+
+            request->service->dbus_handle_sender_credentials(
+                *request, result, error.message_str());
+
+            if (result)
+                g_variant_unref(result);
+            g_object_unref(request->cancellable);
+
+            // The service may be destroyed as soon as this returns
+            request->service->sender_credentials_lookup_completed();
+        },
+        request);
+}
+
+void repowerd::UnityScreenService::sender_credentials_lookup_completed()
+{
+    std::lock_guard<std::mutex> lock{sender_credentials_lookups_mutex};
+
+    if (--num_sender_credentials_lookups == 0)
+        sender_credentials_lookups_completed.notify_all();
+}
+
+void repowerd::UnityScreenService::dbus_handle_sender_credentials(
+    SenderCredentialsRequest& request,
+    GVariant* result,
+    std::string const& error)
+{
+    sender_credentials_requests.erase(request.sender);
 
-    if (!result)
+    if (g_cancellable_is_cancelled(request.cancellable))
+    {
+        for (auto const invocation : request.invocations)
+        {
+            g_dbus_method_invocation_return_error_literal(
+                invocation, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                "Service is shutting down");
+        }
+        return;
+    }
+
+    SenderCredentials credentials{-1};
+
+    if (result)
+    {
+        GVariant* credentials_dict{nullptr};
+        g_variant_get(result, "(@a{sv})", &credentials_dict);
+
+        guint32 pid{0};
+        if (g_variant_lookup(credentials_dict, "ProcessID", "u", &pid))
+            credentials.pid = pid;
+
+        g_variant_unref(credentials_dict);
+
+        if (!request.sender_disconnected)
+            sender_credentials[request.sender] = credentials;
+    }
+    else
     {
-        log->log(log_tag, "failed to get pid of '%s': %s",
-                 sender, error.message_str().c_str());
-        return -1;
+        log->log(log_tag, "failed to get credentials of '%s': %s",
+                 request.sender.c_str(), error.c_str());
     }
 
-    guint pid;
-    g_variant_get(result, "(u)", &pid);
-    g_variant_unref(result);
+    for (auto const invocation : request.invocations)
+        dbus_dispatch_method_call(invocation, credentials);
 
-    return pid;
+    if (request.sender_disconnected)
+        dbus_NameOwnerChanged(request.sender, request.sender, "");
 }
@@ -26,10 +26,13 @@
 #include "dbus_connection_handle.h"
 #include "dbus_event_loop.h"
 
+#include <condition_variable>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include <gio/gio.h>
 #include <sys/types.h>
@@ -53,7 +56,9 @@ public:
         std::shared_ptr<Log> const& log,
         std::shared_ptr<TemporarySuspendInhibition> const& temporary_suspend_inhibition,
         DeviceConfig const& device_config,
-        std::string const& dbus_bus_address);
+        std::shared_ptr<DBusConnectionHandle> const& dbus_connection,
+        std::shared_ptr<EventLoopExecutor> const& event_loop_executor);
+    ~UnityScreenService();
 
     void start_processing() override;
 
@@ -85,6 +90,12 @@ public:
     void notify_display_power_off(DisplayPowerChangeReason reason) override;
 
 private:
+    struct SenderCredentials
+    {
+        pid_t pid;
+    };
+    struct SenderCredentialsRequest;
+
     void dbus_method_call(
         GDBusConnection* connection,
         gchar const* sender,
@@ -93,6 +104,9 @@ private:
         gchar const* method_name,
         GVariant* parameters,
         GDBusMethodInvocation* invocation);
+    void dbus_dispatch_method_call(
+        GDBusMethodInvocation* invocation,
+        SenderCredentials const& credentials);
     void dbus_signal(
         GDBusConnection* connection,
         gchar const* sender,
@@ -136,7 +150,14 @@ private:
     void dbus_emit_brightness(double brightness);
 
     void dbus_unknown_method(std::string const& sender, std::string const& name);
-    pid_t dbus_get_invocation_sender_pid(GDBusMethodInvocation* invocation);
+    void dbus_request_sender_credentials(
+        std::string const& sender,
+        GDBusMethodInvocation* invocation);
+    void dbus_handle_sender_credentials(
+        SenderCredentialsRequest& request,
+        GVariant* result,
+        std::string const& error);
+    void sender_credentials_lookup_completed();
 
     std::shared_ptr<WakeupService> const wakeup_service;
     std::shared_ptr<BrightnessNotification> const brightness_notification;
@@ -166,6 +187,20 @@ private:
     int32_t next_request_sys_state_id;
     BrightnessParams brightness_params;
 
+    // Credentials of a unique name never change, so they are looked up
+    // asynchronously once per sender and kept until the sender disconnects.
+    // Calls arriving while a lookup is in flight are queued in the request,
+    // so that each sender's calls are still handled in order. A request is
+    // owned by its lookup, which frees it on completion, even if cancelled.
+    std::unordered_map<std::string,SenderCredentials> sender_credentials;
+    std::unordered_map<std::string,SenderCredentialsRequest*> sender_credentials_requests;
+    GCancellable* const sender_credentials_cancellable;
+    // Lookups in flight, which destruction waits for, since their
+    // completions access the service
+    std::mutex sender_credentials_lookups_mutex;
+    std::condition_variable sender_credentials_lookups_completed;
+    size_t num_sender_credentials_lookups;
+
     // These need to be at the end, so that handlers are unregistered first on
     // destruction, to avoid accessing other members if an event arrives
     // on destruction.
@@ -37,9 +37,10 @@ repowerd::UserActivityType user_activity_type_from_dbus_value(int32_t value)
 }
 
 repowerd::UnityUserActivity::UnityUserActivity(
-    std::string const& dbus_bus_address)
-    : dbus_connection{dbus_bus_address},
-      dbus_event_loop{"UserActivity"},
+    std::shared_ptr<DBusConnectionHandle> const& dbus_connection,
+    std::shared_ptr<EventLoopExecutor> const& event_loop_executor)
+    : dbus_connection{dbus_connection},
+      dbus_event_loop{"UserActivity", event_loop_executor},
       user_activity_handler{null_handler}
 {
 }
@@ -29,7 +29,9 @@ namespace repowerd
 class UnityUserActivity : public UserActivity
 {
 public:
-    UnityUserActivity(std::string const& dbus_bus_address);
+    UnityUserActivity(
+        std::shared_ptr<DBusConnectionHandle> const& dbus_connection,
+        std::shared_ptr<EventLoopExecutor> const& event_loop_executor);
 
     void start_processing() override;
     HandlerRegistration register_user_activity_handler(
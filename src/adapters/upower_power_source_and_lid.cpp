@@ -108,12 +108,13 @@ repowerd::UPowerPowerSourceAndLid::UPowerPowerSourceAndLid(
     std::shared_ptr<Log> const& log,
     std::shared_ptr<TemporarySuspendInhibition> const& temporary_suspend_inhibition,
     DeviceConfig const& device_config,
-    std::string const& dbus_bus_address)
+    std::shared_ptr<DBusConnectionHandle> const& dbus_connection,
+    std::shared_ptr<EventLoopExecutor> const& event_loop_executor)
     : log{log},
       temporary_suspend_inhibition{temporary_suspend_inhibition},
       critical_temperature{get_critical_temperature(device_config)},
-      dbus_connection{dbus_bus_address},
-      dbus_event_loop{"UPower"},
+      dbus_connection{dbus_connection},
+      dbus_event_loop{"UPower", event_loop_executor},
       power_source_change_handler{null_handler},
       power_source_critical_handler{null_handler},
       lid_handler{null_arg_handler},
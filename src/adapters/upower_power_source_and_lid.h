@@ -40,7 +40,8 @@ public:
         std::shared_ptr<Log> const& log,
         std::shared_ptr<TemporarySuspendInhibition> const& temporary_suspend_inhibition,
         DeviceConfig const& device_config,
-        std::string const& dbus_bus_address);
+        std::shared_ptr<DBusConnectionHandle> const& dbus_connection,
+        std::shared_ptr<EventLoopExecutor> const& event_loop_executor);
 
     void start_processing() override;
 
@@ -0,0 +1,142 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "wake_pipeline.h"
+#include "chrono.h"
+
+#include "src/core/log.h"
+
+namespace
+{
+
+char const* const log_tag = "WakePipeline";
+
+auto const not_reached = std::chrono::steady_clock::duration{-1};
+
+size_t index_of(repowerd::WakeStage stage)
+{
+    return static_cast<size_t>(stage);
+}
+
+}
+
+char const* repowerd::wake_stage_name(WakeStage stage)
+{
+    switch (stage)
+    {
+    case WakeStage::panel_on_requested: return "panel_on_requested";
+    case WakeStage::panel_on: return "panel_on";
+    case WakeStage::backlight_ramp_started: return "backlight_ramp_started";
+    case WakeStage::interactive_mode_enabled: return "interactive_mode_enabled";
+    }
+
+    return "unknown";
+}
+
+repowerd::WakePipeline::WakePipeline(
+    std::shared_ptr<Chrono> const& chrono,
+    std::shared_ptr<Log> const& log,
+    std::chrono::milliseconds stage_deadline)
+    : chrono{chrono},
+      log{log},
+      stage_deadline{stage_deadline},
+      wake_started{false},
+      next_handler_id{1}
+{
+    stage_times.fill(not_reached);
+}
+
+void repowerd::WakePipeline::start_wake()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    wake_started = true;
+    wake_start = chrono->steady_now();
+    stage_times.fill(not_reached);
+    stage_times[index_of(WakeStage::panel_on_requested)] =
+        std::chrono::steady_clock::duration::zero();
+}
+
+void repowerd::WakePipeline::complete_stage(WakeStage stage)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    if (!wake_started || stage_times[index_of(stage)] != not_reached)
+        return;
+
+    auto const stage_time = chrono->steady_now() - wake_start;
+    stage_times[index_of(stage)] = stage_time;
+
+    log->log(log_tag, "%s after %.1f ms%s",
+             wake_stage_name(stage),
+             std::chrono::duration<double,std::milli>{stage_time}.count(),
+             stage_time > stage_deadline ? ", missed deadline" : "");
+
+    for (auto const& id_and_handler : stage_handlers)
+    {
+        if (id_and_handler.second.first == stage)
+            id_and_handler.second.second();
+    }
+}
+
+bool repowerd::WakePipeline::is_stage_pending(WakeStage stage)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    return wake_started && stage_times[index_of(stage)] == not_reached;
+}
+
+std::chrono::milliseconds repowerd::WakePipeline::time_until_stage_deadline()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    if (!wake_started)
+        return stage_deadline;
+
+    auto const time_until = wake_start + stage_deadline - chrono->steady_now();
+    if (time_until <= std::chrono::steady_clock::duration::zero())
+        return std::chrono::milliseconds::zero();
+
+    // Round up, so that the deadline has been reached by then
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        time_until + std::chrono::milliseconds{1} -
+        std::chrono::steady_clock::duration{1});
+}
+
+repowerd::HandlerRegistration repowerd::WakePipeline::register_stage_handler(
+    WakeStage stage, StageHandler const& handler)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const id = next_handler_id++;
+    stage_handlers.emplace(id, std::make_pair(stage, handler));
+
+    return HandlerRegistration{
+        [this, id]
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            stage_handlers.erase(id);
+        }};
+}
+
+repowerd::WakePipeline::StageTimes repowerd::WakePipeline::last_wake_stage_times()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    return stage_times;
+}
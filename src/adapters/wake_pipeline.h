@@ -0,0 +1,103 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#pragma once
+
+#include "src/core/handler_registration.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace repowerd
+{
+
+class Chrono;
+class Log;
+
+enum class WakeStage
+{
+    panel_on_requested,
+    panel_on,
+    backlight_ramp_started,
+    interactive_mode_enabled
+};
+
+size_t constexpr num_wake_stages =
+    static_cast<size_t>(WakeStage::interactive_mode_enabled) + 1;
+
+char const* wake_stage_name(WakeStage stage);
+
+// Coordinates the steps of turning on the display. The adapters run their
+// steps concurrently on their own threads, and use the pipeline only for
+// the orderings that matter, e.g. the backlight ramp waits for the panel
+// to be on. The pipeline also records when each stage of the latest wake
+// completed, relative to the start of the wake, and logs the stages that
+// miss their deadline.
+class WakePipeline
+{
+public:
+    using StageHandler = std::function<void()>;
+    // Stages not reached in the latest wake have a negative duration
+    using StageTimes = std::array<std::chrono::steady_clock::duration,num_wake_stages>;
+
+    // Each stage is expected to complete within the stage deadline after
+    // the start of the wake
+    WakePipeline(
+        std::shared_ptr<Chrono> const& chrono,
+        std::shared_ptr<Log> const& log,
+        std::chrono::milliseconds stage_deadline);
+
+    // How long until the stages of the current wake reach their deadline.
+    // Steps waiting for a stage shouldn't wait longer.
+    std::chrono::milliseconds time_until_stage_deadline();
+
+    // Starts a new wake, in which the panel has been requested to turn on
+    void start_wake();
+    void complete_stage(WakeStage stage);
+    // Whether the stage is still expected to complete in the current wake
+    bool is_stage_pending(WakeStage stage);
+
+    // Handlers are called on the thread that completes the stage, and
+    // must not call back into the pipeline
+    HandlerRegistration register_stage_handler(
+        WakeStage stage, StageHandler const& handler);
+
+    StageTimes last_wake_stage_times();
+
+private:
+    WakePipeline(WakePipeline const&) = delete;
+    WakePipeline& operator=(WakePipeline const&) = delete;
+
+    std::shared_ptr<Chrono> const chrono;
+    std::shared_ptr<Log> const log;
+    std::chrono::milliseconds const stage_deadline;
+
+    std::mutex mutex;
+    bool wake_started;
+    std::chrono::steady_clock::time_point wake_start;
+    StageTimes stage_times;
+    std::unordered_map<int,std::pair<WakeStage,StageHandler>> stage_handlers;
+    int next_handler_id;
+};
+
+}
@@ -0,0 +1,261 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "action_queue.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <system_error>
+#include <thread>
+
+namespace
+{
+
+size_t round_up_to_power_of_two(size_t n)
+{
+    size_t ret = 1;
+    while (ret < n) ret <<= 1;
+    return ret;
+}
+
+}
+
+repowerd::Action::Action(Action&& other) noexcept
+    : invoke_func{other.invoke_func},
+      manage_func{other.manage_func}
+{
+    if (manage_func)
+    {
+        manage_func(&other.storage, &storage);
+        other.invoke_func = nullptr;
+        other.manage_func = nullptr;
+    }
+}
+
+repowerd::Action& repowerd::Action::operator=(Action&& other) noexcept
+{
+    if (&other != this)
+    {
+        reset();
+
+        if (other.manage_func)
+        {
+            other.manage_func(&other.storage, &storage);
+            invoke_func = other.invoke_func;
+            manage_func = other.manage_func;
+            other.invoke_func = nullptr;
+            other.manage_func = nullptr;
+        }
+    }
+
+    return *this;
+}
+
+repowerd::Action::~Action()
+{
+    reset();
+}
+
+void repowerd::Action::operator()()
+{
+    if (invoke_func)
+        invoke_func(&storage);
+}
+
+repowerd::Action::operator bool() const
+{
+    return invoke_func != nullptr;
+}
+
+void repowerd::Action::reset()
+{
+    if (manage_func)
+        manage_func(&storage, nullptr);
+
+    invoke_func = nullptr;
+    manage_func = nullptr;
+}
+
+repowerd::ActionQueue::Ring::Ring(size_t capacity)
+    : mask{round_up_to_power_of_two(capacity) - 1},
+      slots{new Slot[mask + 1]},
+      enqueue_pos{0},
+      dequeue_pos{0}
+{
+    for (size_t i = 0; i <= mask; ++i)
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool repowerd::ActionQueue::Ring::try_push(Action&& action)
+{
+    auto pos = enqueue_pos.load(std::memory_order_relaxed);
+
+    while (true)
+    {
+        auto& slot = slots[pos & mask];
+        auto const sequence = slot.sequence.load(std::memory_order_acquire);
+        auto const diff =
+            static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+        if (diff == 0)
+        {
+            if (enqueue_pos.compare_exchange_weak(
+                    pos, pos + 1, std::memory_order_relaxed))
+            {
+                slot.action = std::move(action);
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0)
+        {
+            return false;
+        }
+        else
+        {
+            pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+repowerd::ActionQueue::PopResult repowerd::ActionQueue::Ring::try_pop(Action& action)
+{
+    auto& slot = slots[dequeue_pos & mask];
+
+    if (slot.sequence.load(std::memory_order_acquire) != dequeue_pos + 1)
+    {
+        // The slot may have been claimed by a producer that hasn't finished
+        // writing to it yet, in which case the ring isn't empty
+        if (enqueue_pos.load(std::memory_order_acquire) == dequeue_pos)
+            return PopResult::empty;
+        else
+            return PopResult::not_ready;
+    }
+
+    action = std::move(slot.action);
+    slot.sequence.store(dequeue_pos + mask + 1, std::memory_order_release);
+    ++dequeue_pos;
+
+    return PopResult::popped;
+}
+
+repowerd::ActionQueue::ActionQueue(size_t capacity)
+    : priority_ring{priority_capacity},
+      ring{capacity},
+      enqueue_epoch{1},
+      num_pending{0},
+      overflow_count{0},
+      coalesced_count{0}
+{
+    if (sem_init(&available, 0, 0) == -1)
+        throw std::system_error{errno, std::system_category(), "Failed to create semaphore"};
+}
+
+repowerd::ActionQueue::~ActionQueue()
+{
+    sem_destroy(&available);
+}
+
+void repowerd::ActionQueue::enqueue(Action&& action)
+{
+    enqueue_epoch.fetch_add(1, std::memory_order_acq_rel);
+    push(ring, overflow, std::move(action));
+}
+
+void repowerd::ActionQueue::enqueue_priority(Action&& action)
+{
+    enqueue_epoch.fetch_add(1, std::memory_order_acq_rel);
+    push(priority_ring, priority_overflow, std::move(action));
+}
+
+repowerd::Action repowerd::ActionQueue::dequeue()
+{
+    while (sem_wait(&available) == -1 && errno == EINTR)
+        continue;
+
+    Action action;
+
+    while (!try_pop(priority_ring, priority_overflow, action) &&
+           !try_pop(ring, overflow, action))
+    {
+        // A producer has claimed the next slot but is still writing to it
+        std::this_thread::yield();
+    }
+
+    num_pending.fetch_sub(1, std::memory_order_relaxed);
+
+    return action;
+}
+
+size_t repowerd::ActionQueue::size() const
+{
+    return num_pending.load(std::memory_order_relaxed);
+}
+
+size_t repowerd::ActionQueue::overflows() const
+{
+    return overflow_count.load(std::memory_order_relaxed);
+}
+
+size_t repowerd::ActionQueue::coalesced() const
+{
+    return coalesced_count.load(std::memory_order_relaxed);
+}
+
+uint64_t repowerd::ActionQueue::coalescing_tag(uint64_t epoch, int value)
+{
+    // Epochs start at 1, so a valid tag is never 0
+    return (epoch << 8) | (static_cast<uint64_t>(value) & 0xff);
+}
+
+void repowerd::ActionQueue::push(Ring& ring, Overflow& overflow, Action&& action)
+{
+    // Once actions have spilled, keep spilling until the consumer catches
+    // up, so that actions from each producer are dequeued in order
+    if (overflow.size.load(std::memory_order_acquire) != 0 ||
+        !ring.try_push(std::move(action)))
+    {
+        std::lock_guard<std::mutex> lock{overflow.mutex};
+        overflow.actions.push_back(std::move(action));
+        overflow.size.fetch_add(1, std::memory_order_release);
+        overflow_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    num_pending.fetch_add(1, std::memory_order_relaxed);
+    sem_post(&available);
+}
+
+bool repowerd::ActionQueue::try_pop(Ring& ring, Overflow& overflow, Action& action)
+{
+    auto const result = ring.try_pop(action);
+    if (result == PopResult::popped)
+        return true;
+
+    // Actions in the overflow are newer than any left in the ring, so they
+    // can only be dequeued once the ring is really empty
+    if (result == PopResult::not_ready ||
+        overflow.size.load(std::memory_order_acquire) == 0)
+        return false;
+
+    std::lock_guard<std::mutex> lock{overflow.mutex};
+    action = std::move(overflow.actions.front());
+    overflow.actions.pop_front();
+    overflow.size.fetch_sub(1, std::memory_order_release);
+
+    return true;
+}
@@ -0,0 +1,203 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <semaphore.h>
+
+namespace repowerd
+{
+
+// A move-only callable that keeps its target in inline storage, so that
+// creating, moving and destroying it never touches the heap
+class Action
+{
+public:
+    static size_t constexpr storage_size = 128;
+
+    Action() = default;
+
+    template<
+        typename F,
+        typename = std::enable_if_t<!std::is_same<std::decay_t<F>, Action>::value>>
+    Action(F&& f)
+    {
+        using Target = std::decay_t<F>;
+        static_assert(sizeof(Target) <= storage_size,
+                      "Action target is too large for inline storage");
+        static_assert(alignof(Target) <= alignof(Storage),
+                      "Action target has unsupported alignment");
+
+        new (&storage) Target{std::forward<F>(f)};
+        invoke_func = [] (void* target) { (*static_cast<Target*>(target))(); };
+        manage_func =
+            [] (void* from, void* to)
+            {
+                auto const from_target = static_cast<Target*>(from);
+                if (to) new (to) Target{std::move(*from_target)};
+                from_target->~Target();
+            };
+    }
+
+    Action(Action&& other) noexcept;
+    Action& operator=(Action&& other) noexcept;
+    ~Action();
+
+    void operator()();
+    explicit operator bool() const;
+
+private:
+    Action(Action const&) = delete;
+    Action& operator=(Action const&) = delete;
+
+    void reset();
+
+    using Storage = std::aligned_storage_t<storage_size, alignof(std::max_align_t)>;
+
+    Storage storage;
+    void (*invoke_func)(void* target) = nullptr;
+    void (*manage_func)(void* from, void* to) = nullptr;
+};
+
+// A bounded multi-producer, single-consumer queue of Actions. Producers
+// never block or allocate unless the ring is full, in which case actions
+// spill into a locked overflow list and the overflow counter is bumped.
+// Priority actions are always dequeued before normal ones.
+class ActionQueue
+{
+public:
+    static size_t constexpr default_capacity = 256;
+    static size_t constexpr priority_capacity = 8;
+
+    // Tracks a kind of event whose instances are coalesced: a new instance
+    // with the same value as the most recently queued action, which is
+    // still pending, is dropped since that action will handle it anyway
+    struct CoalescingSlot
+    {
+        std::atomic<uint64_t> pending_tag{0};
+    };
+
+    ActionQueue(size_t capacity = default_capacity);
+    ~ActionQueue();
+
+    void enqueue(Action&& action);
+    void enqueue_priority(Action&& action);
+    template<typename F>
+    void enqueue_coalesced(CoalescingSlot& slot, int value, F const& f);
+    Action dequeue();
+
+    size_t size() const;
+    size_t overflows() const;
+    size_t coalesced() const;
+
+private:
+    ActionQueue(ActionQueue const&) = delete;
+    ActionQueue& operator=(ActionQueue const&) = delete;
+
+    enum class PopResult
+    {
+        popped,
+        empty,
+        // The next slot has been claimed by a producer that hasn't finished
+        // writing to it yet
+        not_ready
+    };
+
+    class Ring
+    {
+    public:
+        Ring(size_t capacity);
+
+        bool try_push(Action&& action);
+        PopResult try_pop(Action& action);
+
+    private:
+        struct Slot
+        {
+            std::atomic<size_t> sequence;
+            Action action;
+        };
+
+        size_t const mask;
+        std::unique_ptr<Slot[]> const slots;
+        std::atomic<size_t> enqueue_pos;
+        size_t dequeue_pos;
+    };
+
+    struct Overflow
+    {
+        std::mutex mutex;
+        std::deque<Action> actions;
+        std::atomic<size_t> size{0};
+    };
+
+    static uint64_t coalescing_tag(uint64_t epoch, int value);
+    void push(Ring& ring, Overflow& overflow, Action&& action);
+    bool try_pop(Ring& ring, Overflow& overflow, Action& action);
+
+    Ring priority_ring;
+    Ring ring;
+    Overflow priority_overflow;
+    Overflow overflow;
+    std::atomic<uint64_t> enqueue_epoch;
+    std::atomic<size_t> num_pending;
+    std::atomic<size_t> overflow_count;
+    std::atomic<size_t> coalesced_count;
+    sem_t available;
+};
+
+}
+
+template<typename F>
+void repowerd::ActionQueue::enqueue_coalesced(
+    CoalescingSlot& slot, int value, F const& f)
+{
+    auto const last_tag =
+        coalescing_tag(enqueue_epoch.load(std::memory_order_acquire), value);
+
+    if (slot.pending_tag.load(std::memory_order_acquire) == last_tag)
+    {
+        coalesced_count.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto const tag = coalescing_tag(
+        enqueue_epoch.fetch_add(1, std::memory_order_acq_rel) + 1, value);
+    slot.pending_tag.store(tag, std::memory_order_release);
+
+    push(ring, overflow,
+        [&slot, f, tag, value]
+        {
+            // Stop coalescing into this action before handling the event,
+            // so that events arriving from now on are queued anew
+            auto expected = tag;
+            slot.pending_tag.compare_exchange_strong(
+                expected, 0, std::memory_order_acq_rel);
+            f(value);
+        });
+}
@@ -21,6 +21,7 @@
 #include "brightness_control.h"
 #include "client_requests.h"
 #include "client_settings.h"
+#include "dispatch_metrics.h"
 #include "display_power_control.h"
 #include "lid.h"
 #include "notification_service.h"
@@ -61,6 +62,8 @@ repowerd::Daemon::Daemon(DaemonConfig& config)
       timer{config.the_timer()},
       user_activity{config.the_user_activity()},
       voice_call_service{config.the_voice_call_service()},
+      dispatch_metrics{config.the_dispatch_metrics()},
+      config(config),
       running{false}
 {
     sessions.emplace(repowerd::invalid_session_id, Session{std::make_shared<NullStateMachine>()});
@@ -70,20 +73,20 @@ repowerd::Daemon::Daemon(DaemonConfig& config)
 void repowerd::Daemon::run()
 {
     auto const registrations = register_event_handlers();
-    start_event_processing();
+    config.run_startup([this] { start_event_processing(); });
 
     running = true;
 
     while (running)
     {
-        auto const ev = dequeue_action();
+        auto ev = dequeue_action();
         ev();
     }
 }
 
 void repowerd::Daemon::stop()
 {
-    enqueue_priority_action([this] { running = false; });
+    enqueue_priority_action(DispatchEventKind::internal, [this] { running = false; });
 }
 
 void repowerd::Daemon::flush()
@@ -91,11 +94,123 @@ void repowerd::Daemon::flush()
     std::promise<void> flushed_promise;
     auto flushed_future = flushed_promise.get_future();
 
-    enqueue_action([&flushed_promise] { flushed_promise.set_value(); });
+    enqueue_action(
+        DispatchEventKind::internal,
+        [&flushed_promise] { flushed_promise.set_value(); });
 
     flushed_future.wait();
 }
 
+template<typename F>
+auto repowerd::Daemon::instrumented(DispatchEventKind kind, F const& f)
+{
+    auto const enqueue_time = std::chrono::steady_clock::now();
+
+    return
+        [this, kind, f, enqueue_time] (auto... args)
+        {
+            auto const dequeue_time = std::chrono::steady_clock::now();
+            auto const queue_depth = action_queue.size();
+
+            f(args...);
+
+            dispatch_metrics->record_dispatch(
+                kind,
+                dequeue_time - enqueue_time,
+                std::chrono::steady_clock::now() - dequeue_time,
+                queue_depth);
+            dispatch_metrics->record_queue_counters(
+                action_queue.overflows(), action_queue.coalesced());
+        };
+}
+
+template<typename F>
+void repowerd::Daemon::enqueue_action(DispatchEventKind kind, F const& f)
+{
+    action_queue.enqueue(instrumented(kind, f));
+}
+
+template<typename F>
+void repowerd::Daemon::enqueue_priority_action(DispatchEventKind kind, F const& f)
+{
+    action_queue.enqueue_priority(instrumented(kind, f));
+}
+
+template<typename SessionAction>
+void repowerd::Daemon::enqueue_action_to_active_session(
+    DispatchEventKind kind,
+    SessionAction const& session_action)
+{
+    enqueue_action(
+        kind,
+        [this, session_action] { session_action(active_session); });
+}
+
+template<typename SessionAction>
+void repowerd::Daemon::enqueue_coalesced_action_to_active_session(
+    DispatchEventKind kind,
+    CoalescedEvent event, int value,
+    SessionAction const& session_action)
+{
+    action_queue.enqueue_coalesced(
+        coalescing_slots[event], value,
+        instrumented(
+            kind,
+            [this, session_action] (int value) { session_action(active_session, value); }));
+}
+
+template<typename SessionAction>
+void repowerd::Daemon::enqueue_action_to_all_sessions(
+    DispatchEventKind kind,
+    SessionAction const& session_action)
+{
+    enqueue_action(
+        kind,
+        [this, session_action]
+        {
+            for (auto& kv : sessions)
+                session_action(&kv.second);
+        });
+}
+
+template<typename SessionAction>
+void repowerd::Daemon::enqueue_action_to_sessions(
+    DispatchEventKind kind,
+    std::vector<std::string> const& target_sessions,
+    SessionAction const& session_action)
+{
+    enqueue_action(
+        kind,
+        [this, target_sessions, session_action]
+        {
+            for (auto const& session_id : target_sessions)
+            {
+                auto const iter = sessions.find(session_id);
+                if (iter != sessions.end())
+                    session_action(&iter->second);
+            }
+        });
+}
+
+template<typename SessionsFunc, typename SessionAction>
+void repowerd::Daemon::enqueue_action_to_sessions_from(
+    DispatchEventKind kind,
+    SessionsFunc const& sessions_func,
+    SessionAction const& session_action)
+{
+    enqueue_action(
+        kind,
+        [this, sessions_func, session_action]
+        {
+            for (auto const& session_id : sessions_func())
+            {
+                auto const iter = sessions.find(session_id);
+                if (iter != sessions.end())
+                    session_action(&iter->second);
+            }
+        });
+}
+
 std::vector<repowerd::HandlerRegistration>
 repowerd::Daemon::register_event_handlers()
 {
@@ -108,11 +223,13 @@ repowerd::Daemon::register_event_handlers()
                 if (state == PowerButtonState::pressed)
                 {
                     enqueue_action_to_active_session(
+                        DispatchEventKind::power_button,
                         [this] (Session* s) { s->state_machine->handle_power_button_press(); });
                 }
                 else if (state == PowerButtonState::released)
                 {
                     enqueue_action_to_active_session(
+                        DispatchEventKind::power_button,
                         [this] (Session* s) { s->state_machine->handle_power_button_release(); } );
                 }
             }));
@@ -122,6 +239,7 @@ repowerd::Daemon::register_event_handlers()
             [this] (AlarmId id)
             {
                 enqueue_action_to_all_sessions(
+                    DispatchEventKind::alarm,
                     [this, id] (Session* s) { s->state_machine->handle_alarm(id); });
             }));
 
@@ -131,13 +249,17 @@ repowerd::Daemon::register_event_handlers()
             {
                 if (type == UserActivityType::change_power_state)
                 {
-                    enqueue_action_to_active_session(
-                        [this] (Session* s) { s->state_machine->handle_user_activity_changing_power_state(); });
+                    enqueue_coalesced_action_to_active_session(
+                        DispatchEventKind::user_activity,
+                        CoalescedEvent::user_activity_changing_power_state, 0,
+                        [this] (Session* s, int) { s->state_machine->handle_user_activity_changing_power_state(); });
                 }
                 else if (type == UserActivityType::extend_power_state)
                 {
-                    enqueue_action_to_active_session(
-                        [this] (Session* s) { s->state_machine->handle_user_activity_extending_power_state(); });
+                    enqueue_coalesced_action_to_active_session(
+                        DispatchEventKind::user_activity,
+                        CoalescedEvent::user_activity_extending_power_state, 0,
+                        [this] (Session* s, int) { s->state_machine->handle_user_activity_extending_power_state(); });
                 }
             }));
 
@@ -145,16 +267,19 @@ repowerd::Daemon::register_event_handlers()
         proximity_sensor->register_proximity_handler(
             [this] (ProximityState state)
             {
-                if (state == ProximityState::far)
-                {
-                    enqueue_action_to_active_session(
-                        [this] (Session* s) { s->state_machine->handle_proximity_far(); });
-                }
-                else if (state == ProximityState::near)
-                {
-                    enqueue_action_to_active_session(
-                        [this] (Session* s) { s->state_machine->handle_proximity_near(); });
-                }
+                // Near and far share a coalescing slot, so that only
+                // repeated reports of the same state are coalesced
+                enqueue_coalesced_action_to_active_session(
+                    DispatchEventKind::proximity,
+                    CoalescedEvent::proximity, static_cast<int>(state),
+                    [this] (Session* s, int value)
+                    {
+                        auto const state = static_cast<ProximityState>(value);
+                        if (state == ProximityState::far)
+                            s->state_machine->handle_proximity_far();
+                        else if (state == ProximityState::near)
+                            s->state_machine->handle_proximity_near();
+                    });
             }));
 
     registrations.push_back(
@@ -162,6 +287,7 @@ repowerd::Daemon::register_event_handlers()
             [this] (std::string const& id, pid_t pid)
             {
                 enqueue_action_to_sessions(
+                    DispatchEventKind::client_request,
                     sessions_for_pid(pid),
                     [this, id] (Session* s) { s->state_event_adapter.handle_enable_inactivity_timeout(id); });
             }));
@@ -171,6 +297,7 @@ repowerd::Daemon::register_event_handlers()
             [this] (std::string const& id, pid_t pid)
             {
                 enqueue_action_to_sessions(
+                    DispatchEventKind::client_request,
                     sessions_for_pid(pid),
                     [this, id] (Session* s) { s->state_event_adapter.handle_disable_inactivity_timeout(id); });
             }));
@@ -180,6 +307,7 @@ repowerd::Daemon::register_event_handlers()
             [this] (std::chrono::milliseconds timeout, pid_t pid)
             {
                 enqueue_action_to_sessions(
+                    DispatchEventKind::client_request,
                     sessions_for_pid(pid),
                     [this, timeout] (Session* s)
                     {
@@ -199,6 +327,7 @@ repowerd::Daemon::register_event_handlers()
             [this] (std::string const& id, pid_t pid)
             {
                 enqueue_action_to_sessions(
+                    DispatchEventKind::notification,
                     sessions_for_pid(pid),
                     [this,id] (Session* s) { s->state_event_adapter.handle_notification(id); });
             }));
@@ -208,6 +337,7 @@ repowerd::Daemon::register_event_handlers()
             [this] (std::string const& id, pid_t pid)
             {
                 enqueue_action_to_sessions(
+                    DispatchEventKind::notification,
                     sessions_for_pid(pid),
                     [this,id] (Session* s){ s->state_event_adapter.handle_notification_done(id); });
             }));
@@ -217,6 +347,7 @@ repowerd::Daemon::register_event_handlers()
             [this]
             {
                 enqueue_action_to_active_session(
+                    DispatchEventKind::voice_call,
                     [this] (Session* s)
                     {
                         add_session_with_active_call(s);
@@ -228,7 +359,8 @@ repowerd::Daemon::register_event_handlers()
         voice_call_service->register_no_active_call_handler(
             [this]
             {
-                enqueue_action_to_sessions(
+                enqueue_action_to_sessions_from(
+                    DispatchEventKind::voice_call,
                     [this] { return sessions_with_active_calls; },
                     [this] (Session* s) { s->state_machine->handle_no_active_call(); });
             }));
@@ -238,6 +370,7 @@ repowerd::Daemon::register_event_handlers()
             [this] (double value, pid_t pid)
             {
                 enqueue_action_to_sessions(
+                    DispatchEventKind::client_request,
                     sessions_for_pid(pid),
                     [this,value] (Session* s)
                     {
@@ -250,6 +383,7 @@ repowerd::Daemon::register_event_handlers()
             [this] (pid_t pid)
             {
                 enqueue_action_to_sessions(
+                    DispatchEventKind::client_request,
                     sessions_for_pid(pid),
                     [this] (Session* s) { s->state_machine->handle_disable_autobrightness(); });
             }));
@@ -259,6 +393,7 @@ repowerd::Daemon::register_event_handlers()
             [this] (pid_t pid)
             {
                 enqueue_action_to_sessions(
+                    DispatchEventKind::client_request,
                     sessions_for_pid(pid),
                     [this] (Session* s) { s->state_machine->handle_enable_autobrightness(); });
             }));
@@ -268,6 +403,7 @@ repowerd::Daemon::register_event_handlers()
             [this] (std::string const& id, pid_t pid)
             {
                 enqueue_action_to_sessions(
+                    DispatchEventKind::client_request,
                     sessions_for_pid(pid),
                     [this, id] (Session* s) { s->state_event_adapter.handle_allow_suspend(id); });
             }));
@@ -277,6 +413,7 @@ repowerd::Daemon::register_event_handlers()
             [this] (std::string const& id, pid_t pid)
             {
                 enqueue_action_to_sessions(
+                    DispatchEventKind::client_request,
                     sessions_for_pid(pid),
                     [this, id] (Session* s) { s->state_event_adapter.handle_disallow_suspend(id); });
             }));
@@ -285,8 +422,10 @@ repowerd::Daemon::register_event_handlers()
         power_source->register_power_source_change_handler(
             [this]
             {
-                enqueue_action_to_active_session(
-                    [this] (Session* s) { s->state_machine->handle_power_source_change(); });
+                enqueue_coalesced_action_to_active_session(
+                    DispatchEventKind::power_source,
+                    CoalescedEvent::power_source_change, 0,
+                    [this] (Session* s, int) { s->state_machine->handle_power_source_change(); });
             }));
 
     registrations.push_back(
@@ -294,6 +433,7 @@ repowerd::Daemon::register_event_handlers()
             [this]
             {
                 enqueue_action_to_active_session(
+                    DispatchEventKind::power_source,
                     [this] (Session* s) { s->state_machine->handle_power_source_critical(); });
             }));
 
@@ -302,6 +442,7 @@ repowerd::Daemon::register_event_handlers()
             [this] (std::string const& session_id, SessionType session_type)
             {
                 enqueue_action(
+                    DispatchEventKind::session,
                     [this, session_id, session_type]
                     {
                         handle_session_activated(session_id, session_type);
@@ -313,6 +454,7 @@ repowerd::Daemon::register_event_handlers()
             [this] (std::string const& session_id)
             {
                 enqueue_action(
+                    DispatchEventKind::session,
                     [this, session_id] { handle_session_removed(session_id); });
             }));
 
@@ -323,11 +465,13 @@ repowerd::Daemon::register_event_handlers()
                 if (lid_state == LidState::closed)
                 {
                     enqueue_action_to_active_session(
+                        DispatchEventKind::lid,
                         [this] (Session* s) { s->state_machine->handle_lid_closed(); });
                 }
                 else if (lid_state == LidState::open)
                 {
                     enqueue_action_to_active_session(
+                        DispatchEventKind::lid,
                         [this] (Session* s) { s->state_machine->handle_lid_open(); });
                 }
             }));
@@ -338,6 +482,7 @@ repowerd::Daemon::register_event_handlers()
                     std::chrono::milliseconds timeout, pid_t pid)
             {
                 enqueue_action_to_sessions(
+                    DispatchEventKind::client_setting,
                     sessions_for_pid(pid),
                     [this, power_action, power_supply, timeout] (Session* s)
                     {
@@ -351,6 +496,7 @@ repowerd::Daemon::register_event_handlers()
             [this] (PowerAction power_action, PowerSupply power_supply, pid_t pid)
             {
                 enqueue_action_to_sessions(
+                    DispatchEventKind::client_setting,
                     sessions_for_pid(pid),
                     [this, power_action, power_supply] (Session* s)
                     {
@@ -364,6 +510,7 @@ repowerd::Daemon::register_event_handlers()
             [this] (PowerAction power_action, pid_t pid)
             {
                 enqueue_action_to_sessions(
+                    DispatchEventKind::client_setting,
                     sessions_for_pid(pid),
                     [this, power_action] (Session* s)
                     {
@@ -377,6 +524,7 @@ repowerd::Daemon::register_event_handlers()
             [this]
             {
                 enqueue_action_to_active_session(
+                    DispatchEventKind::system_power,
                     [this] (Session* s) { s->state_machine->handle_system_resume(); });
             }));
 
@@ -385,6 +533,7 @@ repowerd::Daemon::register_event_handlers()
             [this] (std::string const& id)
             {
                 enqueue_action_to_all_sessions(
+                    DispatchEventKind::system_power,
                     [this, id] (Session* s) { s->state_event_adapter.handle_allow_suspend(id); });
             }));
 
@@ -393,6 +542,7 @@ repowerd::Daemon::register_event_handlers()
             [this] (std::string const& id)
             {
                 enqueue_action_to_all_sessions(
+                    DispatchEventKind::system_power,
                     [this, id] (Session* s) { s->state_event_adapter.handle_disallow_suspend(id); });
             }));
 
@@ -417,80 +567,9 @@ void repowerd::Daemon::start_event_processing()
     voice_call_service->start_processing();
 }
 
-void repowerd::Daemon::enqueue_action(Action const& action)
-{
-    std::lock_guard<std::mutex> lock{action_queue_mutex};
-
-    action_queue.push_back(action);
-    action_queue_cv.notify_one();
-}
-
-void repowerd::Daemon::enqueue_priority_action(Action const& action)
-{
-    std::lock_guard<std::mutex> lock{action_queue_mutex};
-
-    action_queue.push_front(action);
-    action_queue_cv.notify_one();
-}
-
-void repowerd::Daemon::enqueue_action_to_active_session(
-    SessionAction const& session_action)
-{
-    enqueue_action(
-        [this, session_action] { session_action(active_session); });
-}
-
-void repowerd::Daemon::enqueue_action_to_all_sessions(
-    SessionAction const& session_action)
+repowerd::Action repowerd::Daemon::dequeue_action()
 {
-    enqueue_action(
-        [this, session_action]
-        {
-            for (auto& kv : sessions)
-                session_action(&kv.second);
-        });
-}
-
-void repowerd::Daemon::enqueue_action_to_sessions(
-    std::vector<std::string> const& target_sessions,
-    SessionAction const& session_action)
-{
-    enqueue_action(
-        [this, target_sessions, session_action]
-        {
-            for (auto const& session_id : target_sessions)
-            {
-                auto const iter = sessions.find(session_id);
-                if (iter != sessions.end())
-                    session_action(&iter->second);
-            }
-        });
-}
-
-void repowerd::Daemon::enqueue_action_to_sessions(
-    std::function<std::vector<std::string>()> const& sessions_func,
-    SessionAction const& session_action)
-{
-    enqueue_action(
-        [this, sessions_func, session_action]
-        {
-            for (auto const& session_id : sessions_func())
-            {
-                auto const iter = sessions.find(session_id);
-                if (iter != sessions.end())
-                    session_action(&iter->second);
-            }
-        });
-}
-
-repowerd::Daemon::Action repowerd::Daemon::dequeue_action()
-{
-    std::unique_lock<std::mutex> lock{action_queue_mutex};
-
-    action_queue_cv.wait(lock, [this] { return !action_queue.empty(); });
-    auto ev = action_queue.front();
-    action_queue.pop_front();
-    return ev;
+    return action_queue.dequeue();
 }
 
 void repowerd::Daemon::handle_session_activated(
@@ -18,16 +18,16 @@
 
 #pragma once
 
+#include "action_queue.h"
 #include "daemon_config.h"
+#include "dispatch_metrics.h"
 #include "handler_registration.h"
 #include "state_event_adapter.h"
 #include "session_tracker.h"
 
+#include <array>
 #include <memory>
 #include <vector>
-#include <deque>
-#include <mutex>
-#include <condition_variable>
 #include <functional>
 #include <unordered_map>
 #include <string>
@@ -52,20 +52,46 @@ private:
         StateEventAdapter state_event_adapter;
     };
 
-    using Action = std::function<void()>;
-    using SessionAction = std::function<void(Session*)>;
+    struct CoalescedEventEnum {
+        enum Event {
+            user_activity_changing_power_state,
+            user_activity_extending_power_state,
+            proximity,
+            power_source_change,
+            count};
+    };
+    using CoalescedEvent = CoalescedEventEnum::Event;
 
     std::vector<HandlerRegistration> register_event_handlers();
     void start_event_processing();
-    void enqueue_action(Action const& action);
-    void enqueue_priority_action(Action const& action);
-    void enqueue_action_to_active_session(SessionAction const& action);
-    void enqueue_action_to_all_sessions(SessionAction const& action);
+    template<typename F>
+    auto instrumented(DispatchEventKind kind, F const& f);
+    template<typename F>
+    void enqueue_action(DispatchEventKind kind, F const& f);
+    template<typename F>
+    void enqueue_priority_action(DispatchEventKind kind, F const& f);
+    template<typename SessionAction>
+    void enqueue_action_to_active_session(
+        DispatchEventKind kind,
+        SessionAction const& action);
+    template<typename SessionAction>
+    void enqueue_coalesced_action_to_active_session(
+        DispatchEventKind kind,
+        CoalescedEvent event, int value,
+        SessionAction const& action);
+    template<typename SessionAction>
+    void enqueue_action_to_all_sessions(
+        DispatchEventKind kind,
+        SessionAction const& action);
+    template<typename SessionAction>
     void enqueue_action_to_sessions(
+        DispatchEventKind kind,
         std::vector<std::string> const& sessions,
         SessionAction const& action);
-    void enqueue_action_to_sessions(
-        std::function<std::vector<std::string>()> const& sessions_func,
+    template<typename SessionsFunc, typename SessionAction>
+    void enqueue_action_to_sessions_from(
+        DispatchEventKind kind,
+        SessionsFunc const& sessions_func,
         SessionAction const& action);
     Action dequeue_action();
 
@@ -89,6 +115,8 @@ private:
     std::shared_ptr<Timer> const timer;
     std::shared_ptr<UserActivity> const user_activity;
     std::shared_ptr<VoiceCallService> const voice_call_service;
+    std::shared_ptr<DispatchMetrics> const dispatch_metrics;
+    DaemonConfig& config;
 
     bool running;
 
@@ -96,9 +124,8 @@ private:
     std::vector<std::string> sessions_with_active_calls;
     Session* active_session;
 
-    std::mutex action_queue_mutex;
-    std::condition_variable action_queue_cv;
-    std::deque<Action> action_queue;
+    ActionQueue action_queue;
+    std::array<ActionQueue::CoalescingSlot,CoalescedEvent::count> coalescing_slots;
 };
 
 }
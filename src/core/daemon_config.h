@@ -20,6 +20,7 @@
 
 #include <memory>
 #include <chrono>
+#include <functional>
 
 namespace repowerd
 {
@@ -28,6 +29,7 @@ class DisplayInformation;
 class BrightnessControl;
 class ClientRequests;
 class ClientSettings;
+class DispatchMetrics;
 class DisplayPowerControl;
 class DisplayPowerEventSink;
 class Lid;
@@ -42,6 +44,7 @@ class ProximitySensor;
 class SessionTracker;
 class StateMachineFactory;
 class StateMachineOptions;
+class SuspendMetrics;
 class SystemPowerControl;
 class Timer;
 class UserActivity;
@@ -56,6 +59,7 @@ public:
     virtual std::shared_ptr<BrightnessControl> the_brightness_control() = 0;
     virtual std::shared_ptr<ClientRequests> the_client_requests() = 0;
     virtual std::shared_ptr<ClientSettings> the_client_settings() = 0;
+    virtual std::shared_ptr<DispatchMetrics> the_dispatch_metrics() = 0;
     virtual std::shared_ptr<DisplayPowerControl> the_display_power_control() = 0;
     virtual std::shared_ptr<DisplayPowerEventSink> the_display_power_event_sink() = 0;
     virtual std::shared_ptr<Lid> the_lid() = 0;
@@ -70,11 +74,16 @@ public:
     virtual std::shared_ptr<SessionTracker> the_session_tracker() = 0;
     virtual std::shared_ptr<StateMachineFactory> the_state_machine_factory() = 0;
     virtual std::shared_ptr<StateMachineOptions> the_state_machine_options() = 0;
+    virtual std::shared_ptr<SuspendMetrics> the_suspend_metrics() = 0;
     virtual std::shared_ptr<SystemPowerControl> the_system_power_control() = 0;
     virtual std::shared_ptr<Timer> the_timer() = 0;
     virtual std::shared_ptr<UserActivity> the_user_activity() = 0;
     virtual std::shared_ptr<VoiceCallService> the_voice_call_service() = 0;
 
+    // Runs the startup of all components, giving the config the chance to
+    // batch the work the components do when starting
+    virtual void run_startup(std::function<void()> const& startup) = 0;
+
 protected:
     DaemonConfig() = default;
     DaemonConfig(DaemonConfig const&) = delete;
@@ -30,6 +30,7 @@
 #include "power_source.h"
 #include "proximity_sensor.h"
 #include "state_machine_options.h"
+#include "suspend_metrics.h"
 #include "system_power_control.h"
 #include "timer.h"
 
@@ -37,6 +38,21 @@ namespace
 {
 char const* const suspend_id = "DefaultStateMachine";
 
+std::chrono::milliseconds time_until(
+    std::chrono::steady_clock::time_point tp,
+    std::chrono::steady_clock::time_point now)
+{
+    if (tp <= now)
+        return std::chrono::milliseconds{0};
+
+    auto const duration = tp - now;
+    auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(duration);
+    if (duration_ms < duration)
+        ++duration_ms;
+
+    return duration_ms;
+}
+
 std::string power_action_to_str(repowerd::PowerAction power_action)
 {
     if (power_action == repowerd::PowerAction::none)
@@ -78,6 +94,7 @@ repowerd::DefaultStateMachine::DefaultStateMachine(
       power_button_event_sink{config.the_power_button_event_sink()},
       power_source{config.the_power_source()},
       proximity_sensor{config.the_proximity_sensor()},
+      suspend_metrics{config.the_suspend_metrics()},
       system_power_control{config.the_system_power_control()},
       timer{config.the_timer()},
       display_power_mode{DisplayPowerMode::off},
@@ -88,6 +105,9 @@ repowerd::DefaultStateMachine::DefaultStateMachine(
       power_button_long_press_timeout{config.the_state_machine_options()->power_button_long_press_timeout()},
       user_inactivity_display_dim_alarm_id{AlarmId::invalid},
       user_inactivity_display_off_alarm_id{AlarmId::invalid},
+      user_inactivity_suspend_alarm_id{AlarmId::invalid},
+      user_inactivity_display_dim_time_point{std::chrono::steady_clock::time_point::max()},
+      user_inactivity_suspend_time_point{std::chrono::steady_clock::time_point::max()},
       user_inactivity_normal_display_dim_duration{
           config.the_state_machine_options()->user_inactivity_normal_display_dim_duration()},
       user_inactivity_normal_display_off_timeout{
@@ -133,23 +153,47 @@ void repowerd::DefaultStateMachine::handle_alarm(AlarmId id)
     }
     else if (id == user_inactivity_display_dim_alarm_id)
     {
-        log->log(log_tag, "handle_alarm(display_dim)");
         user_inactivity_display_dim_alarm_id = AlarmId::invalid;
+        if (rearm_alarm_if_deadline_not_reached(
+                user_inactivity_display_dim_alarm_id,
+                user_inactivity_display_dim_alarm_time_point,
+                user_inactivity_display_dim_time_point))
+        {
+            return;
+        }
+
+        log->log(log_tag, "handle_alarm(display_dim)");
         if (is_inactivity_timeout_application_allowed())
             dim_display();
     }
     else if (id == user_inactivity_display_off_alarm_id)
     {
-        log->log(log_tag, "handle_alarm(display_off)");
         user_inactivity_display_off_alarm_id = AlarmId::invalid;
+        if (rearm_alarm_if_deadline_not_reached(
+                user_inactivity_display_off_alarm_id,
+                user_inactivity_display_off_alarm_time_point,
+                user_inactivity_display_off_time_point))
+        {
+            return;
+        }
+
+        log->log(log_tag, "handle_alarm(display_off)");
         if (is_inactivity_timeout_application_allowed())
             turn_off_display(DisplayPowerChangeReason::activity);
         scheduled_timeout_type = ScheduledTimeoutType::none;
     }
     else if (id == user_inactivity_suspend_alarm_id)
     {
-        log->log(log_tag, "handle_alarm(suspend)");
         user_inactivity_suspend_alarm_id = AlarmId::invalid;
+        if (rearm_alarm_if_deadline_not_reached(
+                user_inactivity_suspend_alarm_id,
+                user_inactivity_suspend_alarm_time_point,
+                user_inactivity_suspend_time_point))
+        {
+            return;
+        }
+
+        log->log(log_tag, "handle_alarm(suspend)");
         if (is_inactivity_timeout_application_allowed())
             suspend_when_allowed();
     }
@@ -580,6 +624,8 @@ void repowerd::DefaultStateMachine::handle_system_resume()
 {
     log->log(log_tag, "handle_system_resume");
 
+    suspend_metrics->record_first_event_after_resume(timer->now());
+
     turn_on_display_with_normal_timeout(DisplayPowerChangeReason::activity);
 }
 
@@ -637,7 +683,7 @@ void repowerd::DefaultStateMachine::resume()
         proximity_sensor->enable_proximity_events();
 }
 
-void repowerd::DefaultStateMachine::cancel_user_inactivity_display_off_alarm()
+void repowerd::DefaultStateMachine::cancel_user_inactivity_display_dim_alarm()
 {
     if (user_inactivity_display_dim_alarm_id != AlarmId::invalid)
     {
@@ -645,6 +691,13 @@ void repowerd::DefaultStateMachine::cancel_user_inactivity_display_off_alarm()
         user_inactivity_display_dim_alarm_id = AlarmId::invalid;
     }
 
+    user_inactivity_display_dim_time_point = std::chrono::steady_clock::time_point::max();
+}
+
+void repowerd::DefaultStateMachine::cancel_user_inactivity_display_off_alarm()
+{
+    cancel_user_inactivity_display_dim_alarm();
+
     if (user_inactivity_display_off_alarm_id != AlarmId::invalid)
     {
         timer->cancel_alarm(user_inactivity_display_off_alarm_id);
@@ -655,13 +708,42 @@ void repowerd::DefaultStateMachine::cancel_user_inactivity_display_off_alarm()
     scheduled_timeout_type = ScheduledTimeoutType::none;
 }
 
-void repowerd::DefaultStateMachine::cancel_user_inactivity_suspend_alarm()
+void repowerd::DefaultStateMachine::arm_alarm_for_deadline(
+    AlarmId& alarm_id,
+    std::chrono::steady_clock::time_point& alarm_time_point,
+    std::chrono::steady_clock::time_point deadline)
 {
-    if (user_inactivity_suspend_alarm_id != AlarmId::invalid)
+    if (alarm_id != AlarmId::invalid)
     {
-        timer->cancel_alarm(user_inactivity_suspend_alarm_id);
-        user_inactivity_suspend_alarm_id = AlarmId::invalid;
+        // An alarm that expires no later than the deadline is kept, and
+        // re-armed for the remaining time when it fires
+        if (alarm_time_point <= deadline &&
+            deadline != std::chrono::steady_clock::time_point::max())
+        {
+            return;
+        }
+
+        timer->cancel_alarm(alarm_id);
+        alarm_id = AlarmId::invalid;
     }
+
+    if (deadline == std::chrono::steady_clock::time_point::max())
+        return;
+
+    alarm_id = timer->schedule_alarm_in(time_until(deadline, timer->now()));
+    alarm_time_point = deadline;
+}
+
+bool repowerd::DefaultStateMachine::rearm_alarm_if_deadline_not_reached(
+    AlarmId& alarm_id,
+    std::chrono::steady_clock::time_point& alarm_time_point,
+    std::chrono::steady_clock::time_point deadline)
+{
+    if (timer->now() >= deadline)
+        return false;
+
+    arm_alarm_for_deadline(alarm_id, alarm_time_point, deadline);
+    return true;
 }
 
 void repowerd::DefaultStateMachine::cancel_notification_expiration_alarm()
@@ -681,11 +763,11 @@ void repowerd::DefaultStateMachine::schedule_normal_user_inactivity_alarm()
 
 void repowerd::DefaultStateMachine::schedule_normal_user_inactivity_display_off_alarm()
 {
-    cancel_user_inactivity_display_off_alarm();
     scheduled_timeout_type = ScheduledTimeoutType::normal;
 
     if (user_inactivity_normal_display_off_timeout.get() == repowerd::infinite_timeout)
     {
+        user_inactivity_display_dim_time_point = std::chrono::steady_clock::time_point::max();
         user_inactivity_display_off_time_point = std::chrono::steady_clock::time_point::max();
     }
     else
@@ -694,27 +776,46 @@ void repowerd::DefaultStateMachine::schedule_normal_user_inactivity_display_off_
             timer->now() + user_inactivity_normal_display_off_timeout.get();
         if (user_inactivity_normal_display_off_timeout.get() > user_inactivity_normal_display_dim_duration)
         {
-            user_inactivity_display_dim_alarm_id =
-                timer->schedule_alarm_in(
-                    user_inactivity_normal_display_off_timeout.get() -
-                    user_inactivity_normal_display_dim_duration);
+            user_inactivity_display_dim_time_point =
+                user_inactivity_display_off_time_point -
+                user_inactivity_normal_display_dim_duration;
+        }
+        else
+        {
+            user_inactivity_display_dim_time_point = std::chrono::steady_clock::time_point::max();
         }
-
-        user_inactivity_display_off_alarm_id =
-            timer->schedule_alarm_in(user_inactivity_normal_display_off_timeout.get());
     }
+
+    // Activity usually just pushes the deadlines further out, in which case
+    // the armed alarms are kept and re-armed lazily when they fire
+    arm_alarm_for_deadline(
+        user_inactivity_display_dim_alarm_id,
+        user_inactivity_display_dim_alarm_time_point,
+        user_inactivity_display_dim_time_point);
+    arm_alarm_for_deadline(
+        user_inactivity_display_off_alarm_id,
+        user_inactivity_display_off_alarm_time_point,
+        user_inactivity_display_off_time_point);
 }
 
 void repowerd::DefaultStateMachine::schedule_normal_user_inactivity_suspend_alarm()
 {
-    cancel_user_inactivity_suspend_alarm();
     cancel_suspend_when_allowed();
 
-    if (user_inactivity_normal_suspend_timeout.get() != repowerd::infinite_timeout)
+    if (user_inactivity_normal_suspend_timeout.get() == repowerd::infinite_timeout)
     {
-        user_inactivity_suspend_alarm_id =
-            timer->schedule_alarm_in(user_inactivity_normal_suspend_timeout.get());
+        user_inactivity_suspend_time_point = std::chrono::steady_clock::time_point::max();
     }
+    else
+    {
+        user_inactivity_suspend_time_point =
+            timer->now() + user_inactivity_normal_suspend_timeout.get();
+    }
+
+    arm_alarm_for_deadline(
+        user_inactivity_suspend_alarm_id,
+        user_inactivity_suspend_alarm_time_point,
+        user_inactivity_suspend_time_point);
 }
 
 void repowerd::DefaultStateMachine::schedule_post_notification_user_inactivity_alarm()
@@ -722,10 +823,12 @@ void repowerd::DefaultStateMachine::schedule_post_notification_user_inactivity_a
     auto const tp = timer->now() + user_inactivity_post_notification_display_off_timeout;
     if (tp > user_inactivity_display_off_time_point)
     {
-        cancel_user_inactivity_display_off_alarm();
-        user_inactivity_display_off_alarm_id =
-            timer->schedule_alarm_in(user_inactivity_post_notification_display_off_timeout);
+        cancel_user_inactivity_display_dim_alarm();
         user_inactivity_display_off_time_point = tp;
+        arm_alarm_for_deadline(
+            user_inactivity_display_off_alarm_id,
+            user_inactivity_display_off_alarm_time_point,
+            user_inactivity_display_off_time_point);
         scheduled_timeout_type = ScheduledTimeoutType::post_notification;
     }
 }
@@ -735,10 +838,12 @@ void repowerd::DefaultStateMachine::schedule_reduced_user_inactivity_alarm()
     auto const tp = timer->now() + user_inactivity_reduced_display_off_timeout;
     if (tp > user_inactivity_display_off_time_point)
     {
-        cancel_user_inactivity_display_off_alarm();
-        user_inactivity_display_off_alarm_id =
-            timer->schedule_alarm_in(user_inactivity_reduced_display_off_timeout);
+        cancel_user_inactivity_display_dim_alarm();
         user_inactivity_display_off_time_point = tp;
+        arm_alarm_for_deadline(
+            user_inactivity_display_off_alarm_id,
+            user_inactivity_display_off_alarm_time_point,
+            user_inactivity_display_off_time_point);
         scheduled_timeout_type = ScheduledTimeoutType::reduced;
     }
 }
@@ -770,10 +875,12 @@ void repowerd::DefaultStateMachine::schedule_immediate_user_inactivity_alarm()
     auto const tp = timer->now();
     if (tp > user_inactivity_display_off_time_point)
     {
-        cancel_user_inactivity_display_off_alarm();
-        user_inactivity_display_off_alarm_id =
-            timer->schedule_alarm_in(std::chrono::milliseconds{0});
+        cancel_user_inactivity_display_dim_alarm();
         user_inactivity_display_off_time_point = tp;
+        arm_alarm_for_deadline(
+            user_inactivity_display_off_alarm_id,
+            user_inactivity_display_off_alarm_time_point,
+            user_inactivity_display_off_time_point);
         scheduled_timeout_type = ScheduledTimeoutType::post_notification;
     }
 }
@@ -802,11 +909,13 @@ void repowerd::DefaultStateMachine::turn_on_display_without_timeout(
     if (paused) return;
 
     system_power_control->disallow_automatic_suspend(suspend_id);
-    performance_booster->enable_interactive_mode();
+    // Turning on the panel is the slowest step, so start it first and let
+    // the other steps proceed while it's in progress
     if (lid_closed)
         display_power_control->turn_on(DisplayPowerControlFilter::external);
     else
         display_power_control->turn_on(DisplayPowerControlFilter::all);
+    performance_booster->enable_interactive_mode();
     display_power_mode = DisplayPowerMode::on;
     display_power_mode_reason = reason;
     if (!lid_closed)
@@ -110,8 +110,16 @@ private:
     using ConfigurableTimeout = ConfigurableValue<std::chrono::milliseconds>;
     using ConfigurablePowerAction = ConfigurableValue<PowerAction>;
 
+    void cancel_user_inactivity_display_dim_alarm();
     void cancel_user_inactivity_display_off_alarm();
-    void cancel_user_inactivity_suspend_alarm();
+    void arm_alarm_for_deadline(
+        AlarmId& alarm_id,
+        std::chrono::steady_clock::time_point& alarm_time_point,
+        std::chrono::steady_clock::time_point deadline);
+    bool rearm_alarm_if_deadline_not_reached(
+        AlarmId& alarm_id,
+        std::chrono::steady_clock::time_point& alarm_time_point,
+        std::chrono::steady_clock::time_point deadline);
     void cancel_notification_expiration_alarm();
     void schedule_normal_user_inactivity_alarm();
     void schedule_normal_user_inactivity_display_off_alarm();
@@ -150,6 +158,7 @@ private:
     std::shared_ptr<PowerButtonEventSink> const power_button_event_sink;
     std::shared_ptr<PowerSource> const power_source;
     std::shared_ptr<ProximitySensor> const proximity_sensor;
+    std::shared_ptr<SuspendMetrics> const suspend_metrics;
     std::shared_ptr<SystemPowerControl> const system_power_control;
     std::shared_ptr<Timer> const timer;
 
@@ -166,7 +175,14 @@ private:
     AlarmId user_inactivity_suspend_alarm_id;
     AlarmId proximity_disable_alarm_id;
     AlarmId notification_expiration_alarm_id;
+    // The inactivity deadlines, and the time points the corresponding
+    // alarms were armed for, which may be earlier than the deadlines
+    std::chrono::steady_clock::time_point user_inactivity_display_dim_time_point;
     std::chrono::steady_clock::time_point user_inactivity_display_off_time_point;
+    std::chrono::steady_clock::time_point user_inactivity_suspend_time_point;
+    std::chrono::steady_clock::time_point user_inactivity_display_dim_alarm_time_point;
+    std::chrono::steady_clock::time_point user_inactivity_display_off_alarm_time_point;
+    std::chrono::steady_clock::time_point user_inactivity_suspend_alarm_time_point;
     std::chrono::milliseconds const user_inactivity_normal_display_dim_duration;
     ConfigurableTimeout user_inactivity_normal_display_off_timeout;
     ConfigurableTimeout user_inactivity_normal_suspend_timeout;
@@ -0,0 +1,182 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "dispatch_metrics.h"
+
+#include <limits>
+
+namespace
+{
+
+uint64_t constexpr unbounded = std::numeric_limits<uint64_t>::max();
+
+template<size_t N>
+size_t bucket_for(std::array<uint64_t,N> const& limits, uint64_t value)
+{
+    size_t i = 0;
+    while (value > limits[i]) ++i;
+    return i;
+}
+
+template<size_t N>
+void increment(std::array<std::atomic<uint64_t>,N>& histogram, size_t bucket)
+{
+    histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+template<size_t N>
+std::array<uint64_t,N> snapshot(std::array<std::atomic<uint64_t>,N> const& histogram)
+{
+    std::array<uint64_t,N> ret;
+    for (size_t i = 0; i < N; ++i)
+        ret[i] = histogram[i].load(std::memory_order_relaxed);
+    return ret;
+}
+
+template<size_t N>
+void clear(std::array<std::atomic<uint64_t>,N>& histogram)
+{
+    for (auto& bucket : histogram)
+        bucket.store(0, std::memory_order_relaxed);
+}
+
+uint64_t to_usec(std::chrono::steady_clock::duration d)
+{
+    auto const usec = std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+    return usec < 0 ? 0 : usec;
+}
+
+}
+
+char const* repowerd::dispatch_event_kind_name(DispatchEventKind kind)
+{
+    switch (kind)
+    {
+    case DispatchEventKind::power_button: return "power_button";
+    case DispatchEventKind::alarm: return "alarm";
+    case DispatchEventKind::user_activity: return "user_activity";
+    case DispatchEventKind::proximity: return "proximity";
+    case DispatchEventKind::client_request: return "client_request";
+    case DispatchEventKind::client_setting: return "client_setting";
+    case DispatchEventKind::notification: return "notification";
+    case DispatchEventKind::voice_call: return "voice_call";
+    case DispatchEventKind::power_source: return "power_source";
+    case DispatchEventKind::lid: return "lid";
+    case DispatchEventKind::session: return "session";
+    case DispatchEventKind::system_power: return "system_power";
+    case DispatchEventKind::internal: return "internal";
+    }
+
+    return "unknown";
+}
+
+repowerd::DispatchMetrics::LatencyHistogram const&
+repowerd::DispatchMetrics::latency_bucket_limits_usec()
+{
+    static LatencyHistogram const limits{{
+        10, 20, 50,
+        100, 200, 500,
+        1000, 2000, 5000,
+        10000, 20000, 50000,
+        100000, 200000, 500000,
+        unbounded}};
+    return limits;
+}
+
+repowerd::DispatchMetrics::DepthHistogram const&
+repowerd::DispatchMetrics::depth_bucket_limits()
+{
+    static DepthHistogram const limits{{
+        0, 1, 2, 4, 8, 16, 32, 64, 128, 256, unbounded}};
+    return limits;
+}
+
+repowerd::DispatchMetrics::DispatchMetrics()
+    : max_depth{0},
+      num_queue_overflows{0},
+      num_coalesced_events{0}
+{
+    for (auto& latencies : per_event_latencies)
+    {
+        clear(latencies.queue_wait);
+        clear(latencies.handling);
+    }
+
+    clear(queue_depths);
+}
+
+void repowerd::DispatchMetrics::record_dispatch(
+    DispatchEventKind kind,
+    std::chrono::steady_clock::duration queue_wait,
+    std::chrono::steady_clock::duration handling,
+    size_t queue_depth)
+{
+    auto& latencies = per_event_latencies[static_cast<size_t>(kind)];
+    auto const& latency_limits = latency_bucket_limits_usec();
+
+    increment(latencies.queue_wait, bucket_for(latency_limits, to_usec(queue_wait)));
+    increment(latencies.handling, bucket_for(latency_limits, to_usec(handling)));
+    increment(queue_depths, bucket_for(depth_bucket_limits(), queue_depth));
+
+    // Only the Daemon thread records, so a plain load/store is enough
+    if (queue_depth > max_depth.load(std::memory_order_relaxed))
+        max_depth.store(queue_depth, std::memory_order_relaxed);
+}
+
+void repowerd::DispatchMetrics::record_queue_counters(
+    size_t overflows, size_t coalesced)
+{
+    num_queue_overflows.store(overflows, std::memory_order_relaxed);
+    num_coalesced_events.store(coalesced, std::memory_order_relaxed);
+}
+
+repowerd::DispatchMetrics::EventLatencies
+repowerd::DispatchMetrics::event_latencies(DispatchEventKind kind) const
+{
+    auto const& latencies = per_event_latencies[static_cast<size_t>(kind)];
+
+    EventLatencies ret;
+    ret.queue_wait = snapshot(latencies.queue_wait);
+    ret.handling = snapshot(latencies.handling);
+    ret.count = 0;
+    for (auto const count : ret.queue_wait)
+        ret.count += count;
+
+    return ret;
+}
+
+repowerd::DispatchMetrics::DepthHistogram
+repowerd::DispatchMetrics::queue_depth_histogram() const
+{
+    return snapshot(queue_depths);
+}
+
+uint64_t repowerd::DispatchMetrics::max_queue_depth() const
+{
+    return max_depth.load(std::memory_order_relaxed);
+}
+
+uint64_t repowerd::DispatchMetrics::queue_overflows() const
+{
+    return num_queue_overflows.load(std::memory_order_relaxed);
+}
+
+uint64_t repowerd::DispatchMetrics::coalesced_events() const
+{
+    return num_coalesced_events.load(std::memory_order_relaxed);
+}
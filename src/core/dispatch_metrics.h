@@ -0,0 +1,110 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace repowerd
+{
+
+enum class DispatchEventKind
+{
+    power_button,
+    alarm,
+    user_activity,
+    proximity,
+    client_request,
+    client_setting,
+    notification,
+    voice_call,
+    power_source,
+    lid,
+    session,
+    system_power,
+    internal
+};
+
+size_t constexpr num_dispatch_event_kinds =
+    static_cast<size_t>(DispatchEventKind::internal) + 1;
+
+char const* dispatch_event_kind_name(DispatchEventKind kind);
+
+// Fixed-bucket histograms of how long Daemon actions wait in the queue and
+// how long they take to handle, plus queue depth statistics. Recording only
+// touches preallocated atomic counters, so it never allocates and can be
+// read concurrently from other threads.
+class DispatchMetrics
+{
+public:
+    static size_t constexpr num_latency_buckets = 16;
+    static size_t constexpr num_depth_buckets = 11;
+
+    using LatencyHistogram = std::array<uint64_t,num_latency_buckets>;
+    using DepthHistogram = std::array<uint64_t,num_depth_buckets>;
+
+    struct EventLatencies
+    {
+        uint64_t count;
+        LatencyHistogram queue_wait;
+        LatencyHistogram handling;
+    };
+
+    // Inclusive upper bucket limits; the last bucket is unbounded
+    static LatencyHistogram const& latency_bucket_limits_usec();
+    static DepthHistogram const& depth_bucket_limits();
+
+    DispatchMetrics();
+
+    void record_dispatch(
+        DispatchEventKind kind,
+        std::chrono::steady_clock::duration queue_wait,
+        std::chrono::steady_clock::duration handling,
+        size_t queue_depth);
+    void record_queue_counters(size_t overflows, size_t coalesced);
+
+    EventLatencies event_latencies(DispatchEventKind kind) const;
+    DepthHistogram queue_depth_histogram() const;
+    uint64_t max_queue_depth() const;
+    uint64_t queue_overflows() const;
+    uint64_t coalesced_events() const;
+
+private:
+    DispatchMetrics(DispatchMetrics const&) = delete;
+    DispatchMetrics& operator=(DispatchMetrics const&) = delete;
+
+    template<size_t N> using AtomicHistogram = std::array<std::atomic<uint64_t>,N>;
+
+    struct AtomicEventLatencies
+    {
+        AtomicHistogram<num_latency_buckets> queue_wait;
+        AtomicHistogram<num_latency_buckets> handling;
+    };
+
+    std::array<AtomicEventLatencies,num_dispatch_event_kinds> per_event_latencies;
+    AtomicHistogram<num_depth_buckets> queue_depths;
+    std::atomic<uint64_t> max_depth;
+    std::atomic<uint64_t> num_queue_overflows;
+    std::atomic<uint64_t> num_coalesced_events;
+};
+
+}
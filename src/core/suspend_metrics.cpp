@@ -0,0 +1,138 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "suspend_metrics.h"
+
+namespace
+{
+
+uint64_t usec_between(
+    repowerd::SuspendMetrics::TimePoint from,
+    repowerd::SuspendMetrics::TimePoint to)
+{
+    auto const usec = std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+    return usec < 0 ? 0 : usec;
+}
+
+}
+
+size_t constexpr repowerd::SuspendMetrics::max_cycles;
+uint64_t constexpr repowerd::SuspendMetrics::not_observed;
+
+repowerd::SuspendMetrics::SuspendMetrics()
+    : num_cycles{0},
+      decision_pending{false},
+      current_cycle_resumed{false},
+      first_event_pending{false},
+      display_on_pending{false}
+{
+}
+
+void repowerd::SuspendMetrics::record_suspend_decision(TimePoint tp)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    // The latest decision is the one that leads to suspend, earlier ones
+    // have been superseded
+    decision_pending = true;
+    decision_time = tp;
+}
+
+void repowerd::SuspendMetrics::record_suspend_entry(TimePoint tp)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    start_cycle();
+
+    if (decision_pending)
+    {
+        current_cycle().decision_to_suspend_usec = usec_between(decision_time, tp);
+        decision_pending = false;
+    }
+}
+
+void repowerd::SuspendMetrics::record_resume(TimePoint tp)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    // Resuming without having seen the suspend entry still starts a cycle
+    if (num_cycles == 0 || current_cycle_resumed)
+        start_cycle();
+
+    current_cycle_resumed = true;
+    resume_time = tp;
+    first_event_pending = true;
+    display_on_pending = true;
+    decision_pending = false;
+}
+
+void repowerd::SuspendMetrics::record_first_event_after_resume(TimePoint tp)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    if (!first_event_pending)
+        return;
+
+    current_cycle().resume_to_first_event_usec = usec_between(resume_time, tp);
+    first_event_pending = false;
+}
+
+void repowerd::SuspendMetrics::record_display_on(TimePoint tp)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    if (!display_on_pending)
+        return;
+
+    current_cycle().resume_to_display_on_usec = usec_between(resume_time, tp);
+    display_on_pending = false;
+}
+
+std::vector<repowerd::SuspendCycle> repowerd::SuspendMetrics::recent_cycles() const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const num_recent = num_cycles < max_cycles ? num_cycles : max_cycles;
+
+    std::vector<SuspendCycle> ret;
+    ret.reserve(num_recent);
+    for (auto i = num_cycles - num_recent; i < num_cycles; ++i)
+        ret.push_back(cycles[i % max_cycles]);
+
+    return ret;
+}
+
+uint64_t repowerd::SuspendMetrics::total_cycles() const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return num_cycles;
+}
+
+void repowerd::SuspendMetrics::start_cycle()
+{
+    ++num_cycles;
+    current_cycle() = SuspendCycle{not_observed, not_observed, not_observed};
+    current_cycle_resumed = false;
+    first_event_pending = false;
+    display_on_pending = false;
+}
+
+repowerd::SuspendCycle& repowerd::SuspendMetrics::current_cycle()
+{
+    return cycles[(num_cycles - 1) % max_cycles];
+}
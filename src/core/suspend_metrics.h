@@ -0,0 +1,88 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace repowerd
+{
+
+// Durations of the stages of a suspend/resume cycle, as seen by repowerd
+struct SuspendCycle
+{
+    // From the decision to suspend until the system starts suspending
+    uint64_t decision_to_suspend_usec;
+    // From resume until the daemon handles the resume event
+    uint64_t resume_to_first_event_usec;
+    // From resume until the display panel is on
+    uint64_t resume_to_display_on_usec;
+};
+
+// Ring of the most recent suspend/resume cycles. The suspend and resume
+// points are recorded by the system power control and the later points by
+// the components that reach them, possibly from different threads, so
+// recording takes a lock but never allocates.
+class SuspendMetrics
+{
+public:
+    static size_t constexpr max_cycles = 16;
+    // Marks a duration that was not observed in a cycle, e.g. the decision
+    // to suspend of a cycle that was started by some other process
+    static uint64_t constexpr not_observed = std::numeric_limits<uint64_t>::max();
+
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    SuspendMetrics();
+
+    void record_suspend_decision(TimePoint tp);
+    void record_suspend_entry(TimePoint tp);
+    void record_resume(TimePoint tp);
+    void record_first_event_after_resume(TimePoint tp);
+    void record_display_on(TimePoint tp);
+
+    // Oldest cycle first; the last cycle may still be in progress
+    std::vector<SuspendCycle> recent_cycles() const;
+    uint64_t total_cycles() const;
+
+private:
+    SuspendMetrics(SuspendMetrics const&) = delete;
+    SuspendMetrics& operator=(SuspendMetrics const&) = delete;
+
+    void start_cycle();
+    SuspendCycle& current_cycle();
+
+    std::mutex mutable mutex;
+    std::array<SuspendCycle,max_cycles> cycles;
+    uint64_t num_cycles;
+
+    bool decision_pending;
+    TimePoint decision_time;
+    bool current_cycle_resumed;
+    TimePoint resume_time;
+    bool first_event_pending;
+    bool display_on_pending;
+};
+
+}
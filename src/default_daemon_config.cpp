@@ -18,6 +18,8 @@
 
 #include "default_daemon_config.h"
 #include "core/default_state_machine_factory.h"
+#include "core/dispatch_metrics.h"
+#include "core/suspend_metrics.h"
 
 #include "adapters/android_autobrightness_algorithm.h"
 #include "adapters/android_backlight.h"
@@ -25,8 +27,11 @@
 #include "adapters/android_device_quirks.h"
 #include "adapters/backlight_brightness_control.h"
 #include "adapters/console_log.h"
+#include "adapters/dbus_connection_handle.h"
+#include "adapters/dbus_event_loop.h"
 #include "adapters/default_state_machine_options.h"
 #include "adapters/dev_alarm_wakeup_service.h"
+#include "adapters/event_loop_executor.h"
 #include "adapters/event_loop_timer.h"
 #include "adapters/libsuspend_system_power_control.h"
 #include "adapters/logind_session_tracker.h"
@@ -37,6 +42,7 @@
 #include "adapters/real_filesystem.h"
 #include "adapters/real_temporary_suspend_inhibition.h"
 #include "adapters/repowerd_service.h"
+#include "adapters/suspend_pipeline.h"
 #include "adapters/sysfs_backlight.h"
 #include "adapters/syslog_log.h"
 #include "adapters/timerfd_wakeup_service.h"
@@ -48,6 +54,7 @@
 #include "adapters/unity_screen_service.h"
 #include "adapters/unity_user_activity.h"
 #include "adapters/upower_power_source_and_lid.h"
+#include "adapters/wake_pipeline.h"
 
 namespace
 {
@@ -85,8 +92,15 @@ struct NullLightSensor : repowerd::LightSensor
         return NullHandlerRegistration{};
     }
 
+    repowerd::HandlerRegistration register_direct_light_handler(
+        repowerd::EventLoop&, repowerd::LightHandler const&) override
+    {
+        return NullHandlerRegistration{};
+    }
+
     void enable_light_events() override {}
     void disable_light_events() override {}
+    void set_light_event_rate(repowerd::LightEventRate) override {}
 };
 
 struct NullModemPowerControl : repowerd::ModemPowerControl
@@ -180,12 +194,25 @@ repowerd::DefaultDaemonConfig::the_client_settings()
     if (!client_settings)
     {
         client_settings = std::make_shared<RepowerdService>(
-            the_log(), the_dbus_bus_address());
+            the_dispatch_metrics(),
+            the_suspend_metrics(),
+            the_log(),
+            the_dbus_connection(),
+            the_event_loop_executor());
     }
 
     return client_settings;
 }
 
+std::shared_ptr<repowerd::DispatchMetrics>
+repowerd::DefaultDaemonConfig::the_dispatch_metrics()
+{
+    if (!dispatch_metrics)
+        dispatch_metrics = std::make_shared<DispatchMetrics>();
+
+    return dispatch_metrics;
+}
+
 std::shared_ptr<repowerd::DisplayPowerControl>
 repowerd::DefaultDaemonConfig::the_display_power_control()
 {
@@ -217,7 +244,10 @@ repowerd::DefaultDaemonConfig::the_performance_booster()
     try
     {
         performance_booster = std::make_shared<UbuntuPerformanceBooster>(
-            the_log());
+            the_log(),
+            the_wake_pipeline(),
+            the_suspend_pipeline(),
+            the_event_loop_executor());
     }
     catch (std::exception const& e)
     {
@@ -256,7 +286,8 @@ repowerd::DefaultDaemonConfig::the_proximity_sensor()
     {
         proximity_sensor = std::make_shared<UbuntuProximitySensor>(
             the_log(),
-            *the_device_quirks());
+            *the_device_quirks(),
+            the_event_loop_executor());
     }
     catch (std::exception const& e)
     {
@@ -274,8 +305,15 @@ repowerd::DefaultDaemonConfig::the_session_tracker()
 {
     if (!session_tracker)
     {
+        // Client request handlers look up the session of the requesting pid
+        // from the EventLoops of the client services, so the session tracker
+        // can't share the executor with them
         session_tracker = std::make_shared<LogindSessionTracker>(
-            the_filesystem(), the_log(), *the_device_quirks(), the_dbus_bus_address());
+            the_filesystem(),
+            the_log(),
+            *the_device_quirks(),
+            the_dbus_connection(),
+            nullptr);
     }
 
     return session_tracker;
@@ -306,7 +344,10 @@ repowerd::DefaultDaemonConfig::the_system_power_control()
         try
         {
             system_power_control = std::make_shared<LibsuspendSystemPowerControl>(
-                the_log());
+                the_log(),
+                the_suspend_pipeline(),
+                the_suspend_metrics(),
+                the_event_loop_executor());
         }
         catch (std::exception const& e)
         {
@@ -320,7 +361,9 @@ repowerd::DefaultDaemonConfig::the_system_power_control()
             {
                 system_power_control = std::make_shared<LogindSystemPowerControl>(
                     the_log(),
-                    the_dbus_bus_address());
+                    the_suspend_metrics(),
+                    the_dbus_connection(),
+                    the_event_loop_executor());
             }
         }
         catch (std::exception const& e)
@@ -338,7 +381,7 @@ std::shared_ptr<repowerd::Timer>
 repowerd::DefaultDaemonConfig::the_timer()
 {
     if (!timer)
-        timer = std::make_shared<EventLoopTimer>();
+        timer = std::make_shared<EventLoopTimer>(the_event_loop_executor());
     return timer;
 }
 
@@ -346,7 +389,11 @@ std::shared_ptr<repowerd::UserActivity>
 repowerd::DefaultDaemonConfig::the_user_activity()
 {
     if (!user_activity)
-        user_activity = std::make_shared<UnityUserActivity>(the_dbus_bus_address());
+    {
+        user_activity = std::make_shared<UnityUserActivity>(
+            the_dbus_connection(),
+            the_event_loop_executor());
+    }
     return user_activity;
 }
 
@@ -402,11 +449,16 @@ repowerd::DefaultDaemonConfig::the_backlight_brightness_control()
         backlight_brightness_control = std::make_shared<BacklightBrightnessControl>(
             the_backlight(),
             the_light_sensor(),
-            std::make_shared<AndroidAutobrightnessAlgorithm>(*the_device_config(), ab_log), 
+            std::make_shared<AndroidAutobrightnessAlgorithm>(
+                *the_device_config(), the_chrono(), ab_log),
             the_chrono(),
+            the_wake_pipeline(),
+            the_suspend_pipeline(),
             the_log(),
             *the_device_config(),
-            *the_device_quirks());
+            *the_device_quirks(),
+            nullptr,
+            the_event_loop_executor());
     }
 
     return backlight_brightness_control;
@@ -448,6 +500,45 @@ std::string repowerd::DefaultDaemonConfig::the_dbus_bus_address()
     return address ? address.get() : std::string{};
 }
 
+std::shared_ptr<repowerd::DBusConnectionHandle>
+repowerd::DefaultDaemonConfig::the_dbus_connection()
+{
+    // Without sharing, each adapter gets a connection of its own
+    if (!the_dbus_connection_sharing())
+    {
+        return std::make_shared<DBusConnectionHandle>(
+            the_dbus_bus_address(), the_dbus_registration_batch());
+    }
+
+    if (!dbus_connection)
+    {
+        dbus_connection = std::make_shared<DBusConnectionHandle>(
+            the_dbus_bus_address(), the_dbus_registration_batch());
+    }
+
+    return dbus_connection;
+}
+
+bool repowerd::DefaultDaemonConfig::the_dbus_connection_sharing()
+{
+    bool sharing = REPOWERD_SHARED_DBUS_CONNECTION;
+
+    auto const sharing_env_cstr = getenv("REPOWERD_SHARED_DBUS_CONNECTION");
+    if (sharing_env_cstr)
+        sharing = std::string{sharing_env_cstr} == "1";
+
+    return sharing;
+}
+
+std::shared_ptr<repowerd::DBusRegistrationBatch>
+repowerd::DefaultDaemonConfig::the_dbus_registration_batch()
+{
+    if (!dbus_registration_batch)
+        dbus_registration_batch = std::make_shared<DBusRegistrationBatch>();
+
+    return dbus_registration_batch;
+}
+
 std::shared_ptr<repowerd::DeviceConfig>
 repowerd::DefaultDaemonConfig::the_device_config()
 {
@@ -483,6 +574,25 @@ repowerd::DefaultDaemonConfig::the_device_quirks()
     return device_quirks;
 }
 
+std::shared_ptr<repowerd::EventLoopExecutor>
+repowerd::DefaultDaemonConfig::the_event_loop_executor()
+{
+    if (!event_loop_executor)
+    {
+        // Zero threads means that each EventLoop gets its own thread
+        size_t num_threads = REPOWERD_EVENT_LOOP_THREADS;
+
+        auto const threads_env_cstr = getenv("REPOWERD_EVENT_LOOP_THREADS");
+        if (threads_env_cstr)
+            num_threads = strtoul(threads_env_cstr, nullptr, 10);
+
+        if (num_threads > 0)
+            event_loop_executor = std::make_shared<EventLoopExecutor>("EventLoop", num_threads);
+    }
+
+    return event_loop_executor;
+}
+
 std::shared_ptr<repowerd::Filesystem>
 repowerd::DefaultDaemonConfig::the_filesystem()
 {
@@ -498,7 +608,9 @@ repowerd::DefaultDaemonConfig::the_light_sensor()
     if (!light_sensor)
     try
     {
-        light_sensor = std::make_shared<UbuntuLightSensor>();
+        // BacklightBrightnessControl waits for the light sensor from its own
+        // EventLoop, so the light sensor can't share the executor with it
+        light_sensor = std::make_shared<UbuntuLightSensor>(nullptr);
     }
     catch (std::exception const& e)
     {
@@ -517,11 +629,40 @@ repowerd::DefaultDaemonConfig::the_ofono_voice_call_service()
     {
         ofono_voice_call_service = std::make_shared<OfonoVoiceCallService>(
             the_log(),
-            the_dbus_bus_address());
+            the_dbus_connection(),
+            the_event_loop_executor());
     }
     return ofono_voice_call_service;
 }
 
+std::chrono::milliseconds repowerd::DefaultDaemonConfig::the_pipeline_stage_deadline()
+{
+    // How long the wake and suspend pipelines expect each stage to take
+    return std::chrono::milliseconds{300};
+}
+
+std::shared_ptr<repowerd::SuspendPipeline>
+repowerd::DefaultDaemonConfig::the_suspend_pipeline()
+{
+    if (!suspend_pipeline)
+    {
+        suspend_pipeline = std::make_shared<SuspendPipeline>(
+            the_chrono(),
+            the_log(),
+            the_pipeline_stage_deadline());
+    }
+    return suspend_pipeline;
+}
+
+std::shared_ptr<repowerd::SuspendMetrics>
+repowerd::DefaultDaemonConfig::the_suspend_metrics()
+{
+    if (!suspend_metrics)
+        suspend_metrics = std::make_shared<SuspendMetrics>();
+
+    return suspend_metrics;
+}
+
 std::shared_ptr<repowerd::Lid>
 repowerd::DefaultDaemonConfig::the_lid()
 {
@@ -534,7 +675,9 @@ repowerd::DefaultDaemonConfig::the_temporary_suspend_inhibition()
     if (!temporary_suspend_inhibition)
     {
         temporary_suspend_inhibition = std::make_shared<RealTemporarySuspendInhibition>(
-            the_system_power_control());
+            the_system_power_control(),
+            the_log(),
+            the_event_loop_executor());
     }
     return temporary_suspend_inhibition;
 }
@@ -563,7 +706,11 @@ repowerd::DefaultDaemonConfig::the_unity_display()
     {
         unity_display = std::make_shared<UnityDisplay>(
             the_log(),
-            the_dbus_bus_address());
+            the_wake_pipeline(),
+            the_suspend_pipeline(),
+            the_suspend_metrics(),
+            the_dbus_connection(),
+            the_event_loop_executor());
     }
     return unity_display;
 }
@@ -579,7 +726,8 @@ repowerd::DefaultDaemonConfig::the_unity_screen_service()
             the_log(),
             the_temporary_suspend_inhibition(),
             *the_device_config(),
-            the_dbus_bus_address());
+            the_dbus_connection(),
+            the_event_loop_executor());
     }
 
     return unity_screen_service;
@@ -589,7 +737,11 @@ std::shared_ptr<repowerd::UnityPowerButton>
 repowerd::DefaultDaemonConfig::the_unity_power_button()
 {
     if (!unity_power_button)
-        unity_power_button = std::make_shared<UnityPowerButton>(the_dbus_bus_address());
+    {
+        unity_power_button = std::make_shared<UnityPowerButton>(
+            the_dbus_connection(),
+            the_event_loop_executor());
+    }
     return unity_power_button;
 }
 
@@ -602,12 +754,27 @@ repowerd::DefaultDaemonConfig::the_upower_power_source_and_lid()
             the_log(),
             the_temporary_suspend_inhibition(),
             *the_device_config(),
-            the_dbus_bus_address());
+            the_dbus_connection(),
+            the_event_loop_executor());
     }
 
     return upower_power_source_and_lid;
 }
 
+std::shared_ptr<repowerd::WakePipeline>
+repowerd::DefaultDaemonConfig::the_wake_pipeline()
+{
+    if (!wake_pipeline)
+    {
+        wake_pipeline = std::make_shared<WakePipeline>(
+            the_chrono(),
+            the_log(),
+            the_pipeline_stage_deadline());
+    }
+
+    return wake_pipeline;
+}
+
 std::shared_ptr<repowerd::WakeupService>
 repowerd::DefaultDaemonConfig::the_wakeup_service()
 {
@@ -623,7 +790,23 @@ repowerd::DefaultDaemonConfig::the_wakeup_service()
     }
 
     if (!wakeup_service)
-        wakeup_service = std::make_shared<TimerfdWakeupService>(the_log());
+    {
+        // UnityScreenService waits for wakeup requests from its own
+        // EventLoop, so the wakeup service can't share the executor with it
+        wakeup_service = std::make_shared<TimerfdWakeupService>(the_log(), nullptr);
+    }
 
     return wakeup_service;
 }
+
+void repowerd::DefaultDaemonConfig::run_startup(std::function<void()> const& startup)
+{
+    // Components register their DBus handlers while starting; batch the
+    // registrations so that we wait for the dbus daemon to process them
+    // only once per connection
+    auto const batch = the_dbus_registration_batch();
+
+    batch->start();
+    startup();
+    batch->finish();
+}
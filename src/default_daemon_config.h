@@ -20,6 +20,8 @@
 
 #include "core/daemon_config.h"
 
+#include <chrono>
+
 namespace repowerd
 {
 
@@ -27,16 +29,21 @@ class Backlight;
 class BacklightBrightnessControl;
 class BrightnessNotification;
 class Chrono;
+class DBusConnectionHandle;
+class DBusRegistrationBatch;
 class DeviceConfig;
 class DeviceQuirks;
+class EventLoopExecutor;
 class Filesystem;
 class LightSensor;
 class OfonoVoiceCallService;
+class SuspendPipeline;
 class TemporarySuspendInhibition;
 class UnityScreenService;
 class UnityPowerButton;
 class UnityDisplay;
 class UPowerPowerSourceAndLid;
+class WakePipeline;
 class WakeupService;
 
 class DefaultDaemonConfig : public DaemonConfig
@@ -46,6 +53,7 @@ public:
     std::shared_ptr<BrightnessControl> the_brightness_control() override;
     std::shared_ptr<ClientRequests> the_client_requests() override;
     std::shared_ptr<ClientSettings> the_client_settings() override;
+    std::shared_ptr<DispatchMetrics> the_dispatch_metrics() override;
     std::shared_ptr<DisplayPowerControl> the_display_power_control() override;
     std::shared_ptr<DisplayPowerEventSink> the_display_power_event_sink() override;
     std::shared_ptr<Lid> the_lid() override;
@@ -60,26 +68,36 @@ public:
     std::shared_ptr<SessionTracker> the_session_tracker() override;
     std::shared_ptr<StateMachineFactory> the_state_machine_factory() override;
     std::shared_ptr<StateMachineOptions> the_state_machine_options() override;
+    std::shared_ptr<SuspendMetrics> the_suspend_metrics() override;
     std::shared_ptr<SystemPowerControl> the_system_power_control() override;
     std::shared_ptr<Timer> the_timer() override;
     std::shared_ptr<UserActivity> the_user_activity() override;
     std::shared_ptr<VoiceCallService> the_voice_call_service() override;
 
+    void run_startup(std::function<void()> const& startup) override;
+
     std::shared_ptr<Backlight> the_backlight();
     std::shared_ptr<BacklightBrightnessControl> the_backlight_brightness_control();
     std::shared_ptr<BrightnessNotification> the_brightness_notification();
     std::shared_ptr<Chrono> the_chrono();
     std::string the_dbus_bus_address();
+    std::shared_ptr<DBusConnectionHandle> the_dbus_connection();
+    bool the_dbus_connection_sharing();
+    std::shared_ptr<DBusRegistrationBatch> the_dbus_registration_batch();
     std::shared_ptr<DeviceConfig> the_device_config();
     std::shared_ptr<DeviceQuirks> the_device_quirks();
+    std::shared_ptr<EventLoopExecutor> the_event_loop_executor();
     std::shared_ptr<Filesystem> the_filesystem();
     std::shared_ptr<LightSensor> the_light_sensor();
     std::shared_ptr<OfonoVoiceCallService> the_ofono_voice_call_service();
+    std::chrono::milliseconds the_pipeline_stage_deadline();
+    std::shared_ptr<SuspendPipeline> the_suspend_pipeline();
     std::shared_ptr<TemporarySuspendInhibition> the_temporary_suspend_inhibition();
     std::shared_ptr<UnityDisplay> the_unity_display();
     std::shared_ptr<UnityScreenService> the_unity_screen_service();
     std::shared_ptr<UnityPowerButton> the_unity_power_button();
     std::shared_ptr<UPowerPowerSourceAndLid> the_upower_power_source_and_lid();
+    std::shared_ptr<WakePipeline> the_wake_pipeline();
     std::shared_ptr<WakeupService> the_wakeup_service();
 
 private:
@@ -90,8 +108,12 @@ private:
     std::shared_ptr<BrightnessNotification> brightness_notification;
     std::shared_ptr<Chrono> chrono;
     std::shared_ptr<ClientSettings> client_settings;
+    std::shared_ptr<DBusConnectionHandle> dbus_connection;
+    std::shared_ptr<DBusRegistrationBatch> dbus_registration_batch;
     std::shared_ptr<DeviceConfig> device_config;
     std::shared_ptr<DeviceQuirks> device_quirks;
+    std::shared_ptr<DispatchMetrics> dispatch_metrics;
+    std::shared_ptr<EventLoopExecutor> event_loop_executor;
     std::shared_ptr<Filesystem> filesystem;
     std::shared_ptr<LightSensor> light_sensor;
     std::shared_ptr<Log> log;
@@ -102,6 +124,8 @@ private:
     std::shared_ptr<SessionTracker> session_tracker;
     std::shared_ptr<StateMachineFactory> state_machine_factory;
     std::shared_ptr<StateMachineOptions> state_machine_options;
+    std::shared_ptr<SuspendMetrics> suspend_metrics;
+    std::shared_ptr<SuspendPipeline> suspend_pipeline;
     std::shared_ptr<SystemPowerControl> system_power_control;
     std::shared_ptr<Timer> timer;
     std::shared_ptr<TemporarySuspendInhibition> temporary_suspend_inhibition;
@@ -110,6 +134,7 @@ private:
     std::shared_ptr<UnityScreenService> unity_screen_service;
     std::shared_ptr<UPowerPowerSourceAndLid> upower_power_source_and_lid;
     std::shared_ptr<UserActivity> user_activity;
+    std::shared_ptr<WakePipeline> wake_pipeline;
     std::shared_ptr<WakeupService> wakeup_service;
 };
 
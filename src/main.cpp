@@ -18,10 +18,13 @@
 
 #include "core/daemon.h"
 #include "core/log.h"
+#include "adapters/event_loop_executor.h"
+#include "adapters/process_status.h"
 #include "default_daemon_config.h"
 
 #include <csignal>
 #include <cstring>
+#include <string>
 
 namespace
 {
@@ -78,6 +81,17 @@ int main()
     repowerd::Daemon daemon{config};
     SignalHandler signal_handler{&daemon, log.get()};
 
+    auto const event_loop_executor = config.the_event_loop_executor();
+    auto const event_loop_mode = event_loop_executor ?
+        std::to_string(event_loop_executor->num_threads()) + " shared threads" :
+        std::string{"one thread per event loop"};
+    auto const process_status = repowerd::current_process_status(*config.the_filesystem());
+
+    log->log(log_tag, "Event loops: %s, threads: %zu, RSS: %zu kB",
+             event_loop_mode.c_str(),
+             process_status.num_threads,
+             process_status.rss_kb);
+
     daemon.run();
 
     log->log(log_tag, "Exiting repowerd");
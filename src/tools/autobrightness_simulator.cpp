@@ -0,0 +1,306 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "src/default_daemon_config.h"
+#include "src/adapters/android_autobrightness_algorithm.h"
+#include "src/adapters/backlight.h"
+#include "src/adapters/backlight_brightness_control.h"
+#include "src/adapters/device_config.h"
+#include "src/adapters/event_loop.h"
+#include "src/adapters/light_sensor.h"
+#include "src/adapters/null_log.h"
+#include "src/adapters/simulated_clock.h"
+#include "src/adapters/suspend_pipeline.h"
+#include "src/adapters/wake_pipeline.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+
+// Time to keep running after the last light sample, for pending
+// debouncing and brightness transitions to settle
+auto const settle_time = std::chrono::seconds{60};
+// The period at which a sensor set to a low light event rate reports
+auto const low_rate_period = std::chrono::seconds{2};
+
+struct LightSample
+{
+    std::chrono::steady_clock::duration time;
+    double light;
+};
+
+class SimulatedBacklight : public repowerd::Backlight
+{
+public:
+    void set_brightness(double value) override
+    {
+        brightness = value;
+        ++num_writes;
+    }
+
+    double get_brightness() override
+    {
+        return brightness;
+    }
+
+    double brightness = 0.0;
+    uint64_t num_writes = 0;
+};
+
+class SimulatedLightSensor : public repowerd::LightSensor
+{
+public:
+    repowerd::HandlerRegistration register_light_handler(
+        repowerd::LightHandler const& handler) override
+    {
+        light_handler = handler;
+        return repowerd::HandlerRegistration{[this] { light_handler = [](double){}; }};
+    }
+
+    repowerd::HandlerRegistration register_direct_light_handler(
+        repowerd::EventLoop& event_loop, repowerd::LightHandler const& handler) override
+    {
+        light_handler =
+            [&event_loop, handler] (double light)
+            {
+                event_loop.post([handler, light] { handler(light); });
+            };
+        return repowerd::HandlerRegistration{[this] { light_handler = [](double){}; }};
+    }
+
+    void enable_light_events() override { enabled = true; }
+    void disable_light_events() override { enabled = false; }
+    void set_light_event_rate(repowerd::LightEventRate rate) override
+    {
+        this->rate = rate;
+    }
+
+    // At a low rate readings closer than the low rate period to the last
+    // reported one are dropped, as a sensor at that rate would do
+    void emit_light(std::chrono::steady_clock::time_point time, double light)
+    {
+        if (!enabled)
+            return;
+
+        if (rate == repowerd::LightEventRate::low &&
+            time - last_emit_time < low_rate_period)
+        {
+            ++num_dropped;
+            return;
+        }
+
+        last_emit_time = time;
+        light_handler(light);
+    }
+
+    uint64_t num_dropped = 0;
+
+private:
+    repowerd::LightHandler light_handler = [](double){};
+    std::atomic<bool> enabled{false};
+    std::atomic<repowerd::LightEventRate> rate{repowerd::LightEventRate::normal};
+    std::chrono::steady_clock::time_point last_emit_time;
+};
+
+class OverridingDeviceConfig : public repowerd::DeviceConfig
+{
+public:
+    OverridingDeviceConfig(repowerd::DeviceConfig const& device_config)
+        : device_config(device_config)
+    {
+    }
+
+    std::string get(
+        std::string const& name, std::string const& default_value) const override
+    {
+        auto const iter = overrides.find(name);
+        if (iter != overrides.end())
+            return iter->second;
+
+        return device_config.get(name, default_value);
+    }
+
+    void set(std::string const& name, std::string const& value)
+    {
+        overrides[name] = value;
+    }
+
+private:
+    repowerd::DeviceConfig const& device_config;
+    std::unordered_map<std::string,std::string> overrides;
+};
+
+// Each line of a trace is "<time in seconds> <light in lux>", with times
+// not decreasing. Empty lines and lines starting with '#' are ignored.
+std::vector<LightSample> read_trace(std::string const& path)
+{
+    std::ifstream file{path};
+    if (!file)
+        throw std::runtime_error{"Failed to open trace file " + path};
+
+    std::vector<LightSample> samples;
+    std::string line;
+    int line_number = 0;
+
+    while (std::getline(file, line))
+    {
+        ++line_number;
+
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::stringstream ss{line};
+        double time_sec;
+        double light;
+
+        if (!(ss >> time_sec >> light) || time_sec < 0 || light < 0)
+            throw std::runtime_error{"Invalid trace line " + std::to_string(line_number)};
+
+        auto const time = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>{time_sec});
+
+        if (!samples.empty() && time < samples.back().time)
+            throw std::runtime_error{"Trace time goes backwards at line " + std::to_string(line_number)};
+
+        samples.push_back({time, light});
+    }
+
+    return samples;
+}
+
+double seconds(std::chrono::steady_clock::duration d)
+{
+    return std::chrono::duration<double>{d}.count();
+}
+
+}
+
+int main(int argc, char** argv)
+try
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <trace-file> [<device-config-key>=<value>...]" << std::endl
+                  << "Runs a trace of \"<time in seconds> <light in lux>\" lines through" << std::endl
+                  << "autobrightness in simulated time, reporting the resulting brightness" << std::endl
+                  << "timeline and statistics. Device config values can be overridden, e.g." << std::endl
+                  << "  autoBrightnessLevels=10,100,1000" << std::endl
+                  << "  autoBrightnessLcdBacklightValues=20,60,150,255" << std::endl;
+        return 1;
+    }
+
+    auto const samples = read_trace(argv[1]);
+
+    repowerd::DefaultDaemonConfig config;
+    OverridingDeviceConfig device_config{*config.the_device_config()};
+
+    for (auto i = 2; i < argc; ++i)
+    {
+        std::string const arg{argv[i]};
+        auto const eq = arg.find('=');
+        if (eq == std::string::npos)
+            throw std::runtime_error{"Invalid device config override " + arg};
+        device_config.set(arg.substr(0, eq), arg.substr(eq + 1));
+    }
+
+    if (device_config.get("autoBrightnessLevels", "").empty())
+        throw std::runtime_error{"The device config doesn't support autobrightness"};
+
+    auto const ab_log_env_cstr = getenv("REPOWERD_LOG_AUTOBRIGHTNESS");
+    auto const log = ab_log_env_cstr ?
+        config.the_log() :
+        std::static_pointer_cast<repowerd::Log>(std::make_shared<repowerd::NullLog>());
+
+    auto const clock = std::make_shared<repowerd::SimulatedClock>();
+    auto const start = clock->steady_now();
+
+    auto const backlight = std::make_shared<SimulatedBacklight>();
+    auto const light_sensor = std::make_shared<SimulatedLightSensor>();
+    auto const ab_algorithm = std::make_shared<repowerd::AndroidAutobrightnessAlgorithm>(
+        device_config, clock, log);
+
+    uint64_t num_brightness_changes = 0;
+
+    {
+        repowerd::BacklightBrightnessControl brightness_control{
+            backlight, light_sensor, ab_algorithm, clock,
+            std::make_shared<repowerd::WakePipeline>(
+                clock, log, config.the_pipeline_stage_deadline()),
+            std::make_shared<repowerd::SuspendPipeline>(
+                clock, log, config.the_pipeline_stage_deadline()),
+            log,
+            device_config, *config.the_device_quirks(),
+            clock, nullptr};
+
+        double last_brightness = -1.0;
+        repowerd::BrightnessHandler const brightness_handler =
+            [&] (double brightness)
+            {
+                if (brightness == last_brightness)
+                    return;
+
+                last_brightness = brightness;
+                ++num_brightness_changes;
+
+                printf("%.3f %.4f\n", seconds(clock->steady_now() - start), brightness);
+            };
+
+        auto const registration =
+            brightness_control.register_brightness_handler(brightness_handler);
+
+        printf("# time_sec brightness\n");
+
+        brightness_control.enable_autobrightness();
+        brightness_control.set_normal_brightness();
+
+        for (auto const& sample : samples)
+        {
+            clock->advance_to(start + sample.time);
+            light_sensor->emit_light(start + sample.time, sample.light);
+            clock->run_pending();
+        }
+
+        auto const end_time = samples.empty() ?
+            std::chrono::steady_clock::duration{} : samples.back().time;
+
+        clock->advance_to(start + end_time + settle_time);
+    }
+
+    printf("# Simulated time: %.3f sec\n", seconds(clock->steady_now() - start));
+    printf("# Light samples: %zu\n", samples.size());
+    printf("# Backlight writes: %llu\n", static_cast<unsigned long long>(backlight->num_writes));
+    printf("# Light samples dropped at low rate: %llu\n", static_cast<unsigned long long>(light_sensor->num_dropped));
+    printf("# Light values processed: %llu\n", static_cast<unsigned long long>(ab_algorithm->num_processed_light_values()));
+    printf("# Debounce timers: %llu\n", static_cast<unsigned long long>(ab_algorithm->num_debounce_timers()));
+    printf("# Debounce timers fired: %llu\n", static_cast<unsigned long long>(ab_algorithm->num_fired_debounce_timers()));
+    printf("# Brightness changes: %llu\n", static_cast<unsigned long long>(num_brightness_changes));
+}
+catch (std::exception const& e)
+{
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+}
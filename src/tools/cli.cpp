@@ -21,6 +21,8 @@
 #include <gio/gio.h>
 
 #include <csignal>
+#include <cstdint>
+#include <iomanip>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
@@ -53,6 +55,7 @@ void show_usage(std::string const& progname)
     std::cerr << "  settings inactivity <power_action> <power_supply> <timeout>" << std::endl;
     std::cerr << "  settings lid <power_action> <power-supply>" << std::endl;
     std::cerr << "  settings critical-power <power_action>" << std::endl;
+    std::cerr << "  suspend-metrics: show durations of recent suspend/resume cycles" << std::endl;
     std::cerr << std::endl;
     std::cerr << "<power_action>: none, display-off, suspend, power-off" << std::endl;
     std::cerr << "<power_supply>: battery, line-power" << std::endl;
@@ -300,6 +303,63 @@ void set_critical_power_behavior(
     g_variant_unref(ret);
 }
 
+void print_duration_usec(uint64_t usec)
+{
+    if (usec == UINT64_MAX)
+        std::cout << std::setw(18) << "-";
+    else
+        std::cout << std::setw(18) << std::fixed << std::setprecision(1) << usec / 1000.0;
+}
+
+void show_suspend_metrics(GDBusProxy* repowerd_proxy)
+{
+    repowerd::ScopedGError error;
+
+    auto const ret = g_dbus_proxy_call_sync(
+        repowerd_proxy,
+        "GetSuspendMetrics",
+        NULL,
+        G_DBUS_CALL_FLAGS_NONE,
+        -1,
+        NULL,
+        error);
+
+    if (ret == nullptr)
+    {
+        throw std::runtime_error(
+            "com.canonical.repowerd.GetSuspendMetrics() failed: " + error.message_str());
+    }
+
+    guint64 total_cycles{0};
+    GVariantIter* cycles{nullptr};
+    g_variant_get(ret, "(ta(ttt))", &total_cycles, &cycles);
+
+    std::cout << "Suspend/resume cycles: " << total_cycles
+              << ", showing the " << g_variant_iter_n_children(cycles)
+              << " most recent (durations in ms)" << std::endl;
+    std::cout << std::setw(18) << "decide->suspend"
+              << std::setw(18) << "resume->event"
+              << std::setw(18) << "resume->display" << std::endl;
+
+    guint64 decision_to_suspend{0};
+    guint64 resume_to_first_event{0};
+    guint64 resume_to_display_on{0};
+
+    while (g_variant_iter_next(cycles, "(ttt)",
+                               &decision_to_suspend,
+                               &resume_to_first_event,
+                               &resume_to_display_on))
+    {
+        print_duration_usec(decision_to_suspend);
+        print_duration_usec(resume_to_first_event);
+        print_duration_usec(resume_to_display_on);
+        std::cout << std::endl;
+    }
+
+    g_variant_iter_free(cycles);
+    g_variant_unref(ret);
+}
+
 void handle_display_command(GDBusProxy* uscreen_proxy)
 {
     auto const cookie = keep_display_on(uscreen_proxy);
@@ -396,6 +456,10 @@ try
     {
         handle_settings_command(repowerd_proxy.get(), args);
     }
+    else if (args[0] == "suspend-metrics")
+    {
+        show_suspend_metrics(repowerd_proxy.get());
+    }
     else
     {
         throw std::invalid_argument{""};
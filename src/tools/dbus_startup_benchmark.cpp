@@ -0,0 +1,272 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "src/default_daemon_config.h"
+#include "src/adapters/scoped_g_error.h"
+#include "src/core/daemon.h"
+
+#include <gio/gio.h>
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+// Measures the startup cost of the DBus adapters with separate and with
+// shared DBus connections, and the resources they use in the bus daemon.
+// Also measures the startup of the whole daemon, from the construction of
+// the config until the first event is processed, with and without batched
+// DBus handler registration.
+
+namespace
+{
+
+class PrivateBus
+{
+public:
+    PrivateBus()
+        : pid{0}
+    {
+        auto const pipe = popen(
+            "dbus-daemon --session --print-address=1 --print-pid=1 --fork", "r");
+        if (!pipe)
+            throw std::runtime_error{"Failed to launch dbus-daemon"};
+
+        std::string output;
+        char buffer[256];
+        while (fgets(buffer, sizeof buffer, pipe))
+            output += buffer;
+        pclose(pipe);
+
+        std::stringstream ss{output};
+        std::getline(ss, address);
+        ss >> pid;
+
+        if (address.empty() || pid == 0)
+            throw std::runtime_error{"Failed to start private dbus-daemon"};
+    }
+
+    ~PrivateBus()
+    {
+        kill(pid, SIGTERM);
+    }
+
+    std::string address;
+    pid_t pid;
+};
+
+struct BusStats
+{
+    int num_connections;
+    int num_match_rules;
+};
+
+// Counts the connections and match rules on the bus, excluding the
+// connection used for counting
+BusStats get_bus_stats(std::string const& address)
+{
+    repowerd::ScopedGError error;
+
+    auto const connection = g_dbus_connection_new_for_address_sync(
+        address.c_str(),
+        GDBusConnectionFlags(
+            G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION |
+            G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT),
+        nullptr,
+        nullptr,
+        error);
+
+    if (!connection)
+        throw std::runtime_error{"Failed to connect to bus: " + error.message_str()};
+
+    BusStats stats{-1, -1};
+
+    auto const names = g_dbus_connection_call_sync(
+        connection,
+        "org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus",
+        "ListNames", nullptr, G_VARIANT_TYPE("(as)"),
+        G_DBUS_CALL_FLAGS_NONE, -1, nullptr, nullptr);
+
+    if (names)
+    {
+        GVariantIter* iter;
+        char const* name;
+        stats.num_connections = 0;
+
+        g_variant_get(names, "(as)", &iter);
+        while (g_variant_iter_next(iter, "&s", &name))
+        {
+            if (name[0] == ':')
+                ++stats.num_connections;
+        }
+        g_variant_iter_free(iter);
+        g_variant_unref(names);
+
+        --stats.num_connections;
+    }
+
+    // Needs a bus daemon built with statistics support
+    auto const match_rules = g_dbus_connection_call_sync(
+        connection,
+        "org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus.Debug.Stats",
+        "GetAllMatchRules", nullptr, G_VARIANT_TYPE("(a{sas})"),
+        G_DBUS_CALL_FLAGS_NONE, -1, nullptr, nullptr);
+
+    if (match_rules)
+    {
+        GVariantIter* iter;
+        GVariant* rules;
+        stats.num_match_rules = 0;
+
+        g_variant_get(match_rules, "(a{sas})", &iter);
+        while (g_variant_iter_next(iter, "{&s@as}", nullptr, &rules))
+        {
+            stats.num_match_rules += g_variant_n_children(rules);
+            g_variant_unref(rules);
+        }
+        g_variant_iter_free(iter);
+        g_variant_unref(match_rules);
+    }
+
+    g_dbus_connection_close_sync(connection, nullptr, nullptr);
+    g_object_unref(connection);
+
+    return stats;
+}
+
+void create_dbus_adapters(repowerd::DefaultDaemonConfig& config)
+{
+    config.the_client_settings();
+    config.the_unity_screen_service();
+    config.the_unity_display();
+    config.the_unity_power_button();
+    config.the_user_activity();
+    config.the_upower_power_source_and_lid();
+    config.the_session_tracker();
+    config.the_ofono_voice_call_service();
+    config.the_system_power_control();
+}
+
+// Starts components without batching their DBus handler registrations,
+// for comparison with the default config
+class UnbatchedDaemonConfig : public repowerd::DefaultDaemonConfig
+{
+public:
+    void run_startup(std::function<void()> const& startup) override
+    {
+        startup();
+    }
+};
+
+void run_daemon(bool shared, bool batched)
+{
+    setenv("REPOWERD_SHARED_DBUS_CONNECTION", shared ? "1" : "0", 1);
+
+    auto const start = std::chrono::steady_clock::now();
+
+    std::unique_ptr<repowerd::DefaultDaemonConfig> config;
+    if (batched)
+        config = std::make_unique<repowerd::DefaultDaemonConfig>();
+    else
+        config = std::make_unique<UnbatchedDaemonConfig>();
+
+    repowerd::Daemon daemon{*config};
+
+    std::thread daemon_thread{[&daemon] { daemon.run(); }};
+
+    // The flush is processed after startup, so it marks the first
+    // processed event
+    daemon.flush();
+
+    auto const duration = std::chrono::steady_clock::now() - start;
+
+    daemon.stop();
+    daemon_thread.join();
+
+    std::string const name =
+        std::string{shared ? "shared" : "separate"} +
+        (batched ? ", batched" : ", unbatched");
+
+    printf("%-19s daemon startup: %7.2f ms\n",
+           name.c_str(),
+           std::chrono::duration<double,std::milli>{duration}.count());
+}
+
+void run_adapters(bool shared)
+{
+    setenv("REPOWERD_SHARED_DBUS_CONNECTION", shared ? "1" : "0", 1);
+
+    auto const start = std::chrono::steady_clock::now();
+
+    repowerd::DefaultDaemonConfig config;
+    create_dbus_adapters(config);
+
+    auto const duration = std::chrono::steady_clock::now() - start;
+    auto const stats = get_bus_stats(config.the_dbus_bus_address());
+
+    printf("%-9s startup: %7.2f ms, connections: %d, match rules: %s\n",
+           shared ? "shared" : "separate",
+           std::chrono::duration<double,std::milli>{duration}.count(),
+           stats.num_connections,
+           stats.num_match_rules >= 0 ?
+               std::to_string(stats.num_match_rules).c_str() : "unavailable");
+}
+
+}
+
+int main(int argc, char** argv)
+try
+{
+    std::string const arg{argc > 1 ? argv[1] : ""};
+
+    if (arg != "" && arg != "--private-bus")
+    {
+        std::cerr << "Usage: " << argv[0] << " [--private-bus]" << std::endl
+                  << "Measures DBus adapter and daemon startup with separate and shared" << std::endl
+                  << "connections, on the system bus or on a private bus" << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<PrivateBus> private_bus;
+    if (arg == "--private-bus")
+    {
+        private_bus = std::make_unique<PrivateBus>();
+        setenv("DBUS_SYSTEM_BUS_ADDRESS", private_bus->address.c_str(), 1);
+    }
+
+    setenv("REPOWERD_LOG", "null", 0);
+
+    run_adapters(false);
+    run_adapters(true);
+
+    run_daemon(false, false);
+    run_daemon(false, true);
+    run_daemon(true, false);
+    run_daemon(true, true);
+}
+catch (std::exception const& e)
+{
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+}
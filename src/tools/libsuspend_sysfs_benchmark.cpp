@@ -0,0 +1,164 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "src/adapters/libsuspend/sysfs.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Compares the cost of the sysfs writes libsuspend makes for each suspend
+// transition when opening and closing the attribute for every write, to
+// the cost when keeping the attribute descriptors open. A temporary
+// directory stands in for /sys/power, so this measures the syscall
+// overhead rather than the work the kernel does for each attribute.
+
+namespace
+{
+
+struct FakeSysfs
+{
+    FakeSysfs()
+    {
+        char dir_template[] = "/tmp/repowerd-sysfs-benchmark-XXXXXX";
+        if (!mkdtemp(dir_template))
+            throw std::runtime_error{"Failed to create temporary directory"};
+
+        dir = dir_template;
+        wake_lock = create_attribute("wake_lock");
+        wake_unlock = create_attribute("wake_unlock");
+        autosleep = create_attribute("autosleep");
+    }
+
+    ~FakeSysfs()
+    {
+        unlink(wake_lock.c_str());
+        unlink(wake_unlock.c_str());
+        unlink(autosleep.c_str());
+        rmdir(dir.c_str());
+    }
+
+    std::string create_attribute(std::string const& name)
+    {
+        auto const path = dir + "/" + name;
+        auto const fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        if (fd == -1)
+            throw std::runtime_error{"Failed to create " + path};
+        close(fd);
+        return path;
+    }
+
+    std::string dir;
+    std::string wake_lock;
+    std::string wake_unlock;
+    std::string autosleep;
+};
+
+char const wake_lock_name[] = "repowerd";
+char const mem_str[] = "mem";
+char const off_str[] = "off";
+
+int str_len(char const* str)
+{
+    return std::char_traits<char>::length(str);
+}
+
+// A transition takes and releases a wake lock and leaves and re-enters
+// automatic suspend, the writes on the suspend-critical path
+std::chrono::steady_clock::duration run(
+    int num_transitions,
+    std::function<void(char const*)> const& write_wake_lock,
+    std::function<void(char const*)> const& write_wake_unlock,
+    std::function<void(char const*)> const& write_autosleep)
+{
+    auto const start = std::chrono::steady_clock::now();
+
+    for (auto i = 0; i < num_transitions; ++i)
+    {
+        write_wake_lock(wake_lock_name);
+        write_autosleep(off_str);
+        write_wake_unlock(wake_lock_name);
+        write_autosleep(mem_str);
+    }
+
+    return std::chrono::steady_clock::now() - start;
+}
+
+void report(char const* name, int num_transitions, std::chrono::steady_clock::duration d)
+{
+    printf("%-10s %8.1f ns/transition\n",
+           name,
+           std::chrono::duration<double,std::nano>{d}.count() / num_transitions);
+}
+
+void check(int ret)
+{
+    if (ret < 0)
+        throw std::runtime_error{"sysfs write failed"};
+}
+
+}
+
+int main(int argc, char** argv)
+try
+{
+    auto const num_transitions = argc > 1 ? std::atoi(argv[1]) : 100000;
+
+    if (num_transitions <= 0)
+    {
+        std::cerr << "Usage: " << argv[0] << " [<number of transitions>]" << std::endl;
+        return 1;
+    }
+
+    FakeSysfs fake_sysfs;
+
+    auto const reopening = run(
+        num_transitions,
+        [&] (char const* s) { check(sysfs_write(fake_sysfs.wake_lock.c_str(), s, str_len(s))); },
+        [&] (char const* s) { check(sysfs_write(fake_sysfs.wake_unlock.c_str(), s, str_len(s))); },
+        [&] (char const* s) { check(sysfs_write(fake_sysfs.autosleep.c_str(), s, str_len(s))); });
+
+    sysfs_attr wake_lock_attr{fake_sysfs.wake_lock.c_str(), -1};
+    sysfs_attr wake_unlock_attr{fake_sysfs.wake_unlock.c_str(), -1};
+    sysfs_attr autosleep_attr{fake_sysfs.autosleep.c_str(), -1};
+
+    auto const persistent = run(
+        num_transitions,
+        [&] (char const* s) { check(sysfs_attr_write(&wake_lock_attr, s, str_len(s))); },
+        [&] (char const* s) { check(sysfs_attr_write(&wake_unlock_attr, s, str_len(s))); },
+        [&] (char const* s) { check(sysfs_attr_write(&autosleep_attr, s, str_len(s))); });
+
+    sysfs_attr_close(&wake_lock_attr);
+    sysfs_attr_close(&wake_unlock_attr);
+    sysfs_attr_close(&autosleep_attr);
+
+    report("reopening", num_transitions, reopening);
+    report("persistent", num_transitions, persistent);
+}
+catch (std::exception const& e)
+{
+    std::cerr << e.what() << std::endl;
+    return 1;
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "src/adapters/event_loop.h"
+#include "src/adapters/latest_value_mailbox.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+
+// Compares the cost of handing light sensor readings to the brightness
+// control through the sensor's own event loop, as done with handlers
+// registered with register_light_handler(), to handing them directly to
+// the brightness control event loop, as done with handlers registered with
+// register_direct_light_handler().
+
+namespace
+{
+
+struct Result
+{
+    std::chrono::steady_clock::duration producer_time;
+    std::chrono::steady_clock::duration total_time;
+    uint64_t num_handled;
+};
+
+// Delivers the samples as fast as possible, like a sensor thread would,
+// and then waits with drain() until all deliveries have been handled
+Result run(int num_samples,
+           std::function<void(double)> const& deliver,
+           std::function<void()> const& drain,
+           uint64_t const& num_handled)
+{
+    auto const start = std::chrono::steady_clock::now();
+
+    for (auto i = 0; i < num_samples; ++i)
+        deliver(i);
+
+    auto const producer_end = std::chrono::steady_clock::now();
+
+    drain();
+
+    return {producer_end - start, std::chrono::steady_clock::now() - start, num_handled};
+}
+
+void report(char const* name, int num_samples, Result const& result)
+{
+    auto const ns_per_sample = [num_samples] (std::chrono::steady_clock::duration d)
+        {
+            return std::chrono::duration<double,std::nano>{d}.count() / num_samples;
+        };
+
+    printf("%-8s producer: %8.1f ns/sample, end-to-end: %8.1f ns/sample, handled: %llu/%d\n",
+           name,
+           ns_per_sample(result.producer_time),
+           ns_per_sample(result.total_time),
+           static_cast<unsigned long long>(result.num_handled),
+           num_samples);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    auto const num_samples = argc > 1 ? std::atoi(argv[1]) : 100000;
+
+    if (num_samples <= 0)
+    {
+        std::cerr << "Usage: " << argv[0] << " [<number of samples>]" << std::endl;
+        return 1;
+    }
+
+    repowerd::EventLoop light_loop{"Light"};
+    repowerd::EventLoop backlight_loop{"Backlight"};
+
+    uint64_t num_handled_queued = 0;
+    auto const queued_handler = [&] (double) { ++num_handled_queued; };
+
+    auto const queued = run(
+        num_samples,
+        [&] (double light)
+        {
+            light_loop.post(
+                [&, light]
+                {
+                    backlight_loop.post([&, light] { queued_handler(light); });
+                });
+        },
+        [&]
+        {
+            light_loop.enqueue([]{}).get();
+            backlight_loop.enqueue([]{}).get();
+        },
+        num_handled_queued);
+
+    uint64_t num_handled_direct = 0;
+    repowerd::LatestValueMailbox mailbox{
+        backlight_loop, [&] (double) { ++num_handled_direct; }};
+
+    auto const direct = run(
+        num_samples,
+        [&] (double light) { mailbox.post(light); },
+        [&] { backlight_loop.enqueue([]{}).get(); },
+        num_handled_direct);
+
+    report("queued", num_samples, queued);
+    report("direct", num_samples, direct);
+}
@@ -21,6 +21,7 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <sstream>
 #include <stdexcept>
 
@@ -161,6 +162,45 @@ int repowerd::test::FakeFilesystem::ioctl(
         return ioctl_handlers.at(path)(path.c_str(), request, args);
 }
 
+ssize_t repowerd::test::FakeFilesystem::pread(
+    int fd, void* buf, size_t count, off_t offset) const
+{
+    if (paths.find(fd) == paths.end())
+        return -1;
+
+    auto const& path = paths[fd];
+
+    if (files.find(path) == files.end() || files.at(path)->empty())
+        return -1;
+
+    auto const& contents = files.at(path)->back();
+    if (static_cast<size_t>(offset) >= contents.size())
+        return 0;
+
+    auto const num_read = std::min(count, contents.size() - offset);
+    contents.copy(static_cast<char*>(buf), num_read, offset);
+
+    return num_read;
+}
+
+// Like sysfs attributes, every write replaces the whole file contents,
+// which are recorded as a new entry in the file's history
+ssize_t repowerd::test::FakeFilesystem::pwrite(
+    int fd, void const* buf, size_t count, off_t) const
+{
+    if (paths.find(fd) == paths.end())
+        return -1;
+
+    auto const& path = paths[fd];
+
+    if (files.find(path) == files.end())
+        return -1;
+
+    files[path]->push_back(std::string(static_cast<char const*>(buf), count));
+
+    return count;
+}
+
 void repowerd::test::FakeFilesystem::add_file_with_contents(
     std::string const& path, std::string const& contents)
 {
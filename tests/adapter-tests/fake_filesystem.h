@@ -45,6 +45,8 @@ public:
 
     Fd open(char const* pathname, int flags) const override;
     int ioctl(int fd, unsigned long request, void* args) const override;
+    ssize_t pread(int fd, void* buf, size_t count, off_t offset) const override;
+    ssize_t pwrite(int fd, void const* buf, size_t count, off_t offset) const override;
 
     void add_file_with_contents(std::string const& path, std::string const& contents);
     std::shared_ptr<std::deque<std::string>> add_file_with_live_contents(
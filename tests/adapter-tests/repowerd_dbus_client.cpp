@@ -68,3 +68,15 @@ rt::DBusAsyncReplyVoid rt::RepowerdDBusClient::request_set_critical_power_behavi
         repowerd_interface, "SetCriticalPowerBehavior",
         g_variant_new("(s)", power_action.c_str()));
 }
+
+rt::DBusAsyncReply rt::RepowerdDBusClient::request_dispatch_metrics()
+{
+    return invoke_with_reply<rt::DBusAsyncReply>(
+        repowerd_interface, "GetDispatchMetrics", nullptr);
+}
+
+rt::DBusAsyncReply rt::RepowerdDBusClient::request_suspend_metrics()
+{
+    return invoke_with_reply<rt::DBusAsyncReply>(
+        repowerd_interface, "GetSuspendMetrics", nullptr);
+}
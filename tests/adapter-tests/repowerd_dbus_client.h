@@ -42,6 +42,8 @@ public:
         std::string const& power_supply);
     DBusAsyncReplyVoid request_set_critical_power_behavior(
         std::string const& power_action);
+    DBusAsyncReply request_dispatch_metrics();
+    DBusAsyncReply request_suspend_metrics();
 };
 
 }
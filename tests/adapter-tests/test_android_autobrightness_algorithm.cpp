@@ -18,6 +18,8 @@
 
 #include "src/adapters/android_autobrightness_algorithm.h"
 #include "src/adapters/event_loop.h"
+#include "src/adapters/real_chrono.h"
+#include "src/adapters/simulated_clock.h"
 
 #include "fake_device_config.h"
 #include "fake_log.h"
@@ -26,6 +28,7 @@
 
 namespace rt = repowerd::test;
 using namespace testing;
+using namespace std::chrono_literals;
 
 namespace
 {
@@ -43,7 +46,14 @@ struct AnAndroidAutobrightnessAlgorithm : Test
         event_loop.enqueue([]{}).get();
     }
 
+    std::unique_ptr<repowerd::EventLoop> create_simulated_event_loop(
+        std::shared_ptr<repowerd::SimulatedClock> const& clock)
+    {
+        return std::make_unique<repowerd::EventLoop>("simulated", nullptr, clock);
+    }
+
     repowerd::EventLoop event_loop{"test"};
+    std::shared_ptr<repowerd::RealChrono> const chrono{std::make_shared<repowerd::RealChrono>()};
     std::shared_ptr<rt::FakeLog> const fake_log{std::make_shared<rt::FakeLog>()};
 
     rt::FakeDeviceConfig device_config_with_valid_curves;
@@ -58,7 +68,7 @@ TEST_F(AnAndroidAutobrightnessAlgorithm,
     rt::FakeDeviceConfig device_config_without_curves;
 
     repowerd::AndroidAutobrightnessAlgorithm ab_algorithm{
-        device_config_without_curves, fake_log};
+        device_config_without_curves, chrono, fake_log};
 
     EXPECT_FALSE(ab_algorithm.init(event_loop));
 }
@@ -71,7 +81,7 @@ TEST_F(AnAndroidAutobrightnessAlgorithm,
     device_config_with_invalid_curves.set("autoBrightnessLcdBacklightValues", "1,2,3");
 
     repowerd::AndroidAutobrightnessAlgorithm ab_algorithm{
-        device_config_with_invalid_curves, fake_log};
+        device_config_with_invalid_curves, chrono, fake_log};
 
     EXPECT_FALSE(ab_algorithm.init(event_loop));
 }
@@ -80,7 +90,7 @@ TEST_F(AnAndroidAutobrightnessAlgorithm,
        initializes_with_autobrightness_curves_of_correct_size)
 {
     repowerd::AndroidAutobrightnessAlgorithm ab_algorithm{
-        device_config_with_valid_curves, fake_log};
+        device_config_with_valid_curves, chrono, fake_log};
 
     EXPECT_TRUE(ab_algorithm.init(event_loop));
 }
@@ -89,7 +99,7 @@ TEST_F(AnAndroidAutobrightnessAlgorithm,
        reacts_immediately_to_first_light_value_after_started)
 {
     repowerd::AndroidAutobrightnessAlgorithm ab_algorithm{
-        device_config_with_valid_curves, fake_log};
+        device_config_with_valid_curves, chrono, fake_log};
     ASSERT_TRUE(ab_algorithm.init(event_loop));
 
     std::vector<double> ab_values;
@@ -107,7 +117,7 @@ TEST_F(AnAndroidAutobrightnessAlgorithm,
 TEST_F(AnAndroidAutobrightnessAlgorithm, ignores_light_values_when_stopped)
 {
     repowerd::AndroidAutobrightnessAlgorithm ab_algorithm{
-        device_config_with_valid_curves, fake_log};
+        device_config_with_valid_curves, chrono, fake_log};
     ASSERT_TRUE(ab_algorithm.init(event_loop));
 
     std::vector<double> ab_values;
@@ -124,3 +134,124 @@ TEST_F(AnAndroidAutobrightnessAlgorithm, ignores_light_values_when_stopped)
     wait_for_event_loop_processing();
     EXPECT_THAT(ab_values, IsEmpty());
 }
+
+TEST_F(AnAndroidAutobrightnessAlgorithm,
+       requests_low_light_event_rate_while_light_is_stable)
+{
+    auto const clock = std::make_shared<repowerd::SimulatedClock>();
+    auto const simulated_event_loop = create_simulated_event_loop(clock);
+    auto const start = clock->steady_now();
+
+    repowerd::AndroidAutobrightnessAlgorithm ab_algorithm{
+        device_config_with_valid_curves, clock, fake_log};
+    ASSERT_TRUE(ab_algorithm.init(*simulated_event_loop));
+
+    std::vector<repowerd::LightEventRate> rates;
+    auto const reg = ab_algorithm.register_light_event_rate_handler(
+        [&] (repowerd::LightEventRate rate) { rates.push_back(rate); });
+
+    ab_algorithm.start();
+    ab_algorithm.new_light_value(100.0);
+    clock->advance_to(start + 1s);
+    ab_algorithm.new_light_value(100.0);
+    clock->advance_to(start + 10s);
+
+    EXPECT_THAT(rates, ElementsAre(repowerd::LightEventRate::low));
+
+    ab_algorithm.new_light_value(1000.0);
+    clock->run_pending();
+
+    EXPECT_THAT(rates, ElementsAre(repowerd::LightEventRate::low,
+                                   repowerd::LightEventRate::normal));
+    EXPECT_THAT(ab_algorithm.num_processed_light_values(), Eq(3));
+    EXPECT_THAT(ab_algorithm.num_fired_debounce_timers(), Eq(1));
+
+    ab_algorithm.stop();
+    clock->run_pending();
+}
+
+TEST_F(AnAndroidAutobrightnessAlgorithm, cancels_debounce_timer_when_stopped)
+{
+    auto const clock = std::make_shared<repowerd::SimulatedClock>();
+    auto const simulated_event_loop = create_simulated_event_loop(clock);
+    auto const start = clock->steady_now();
+
+    repowerd::AndroidAutobrightnessAlgorithm ab_algorithm{
+        device_config_with_valid_curves, clock, fake_log};
+    ASSERT_TRUE(ab_algorithm.init(*simulated_event_loop));
+
+    ab_algorithm.start();
+    ab_algorithm.new_light_value(100.0);
+    clock->advance_to(start + 1s);
+    ab_algorithm.new_light_value(500.0);
+    clock->run_pending();
+    ab_algorithm.stop();
+    clock->advance_to(start + 10s);
+
+    EXPECT_THAT(ab_algorithm.num_debounce_timers(), Eq(1));
+    EXPECT_THAT(ab_algorithm.num_fired_debounce_timers(), Eq(0));
+}
+
+TEST_F(AnAndroidAutobrightnessAlgorithm,
+       reacts_immediately_to_recent_light_value_when_restarted)
+{
+    auto const clock = std::make_shared<repowerd::SimulatedClock>();
+    auto const simulated_event_loop = create_simulated_event_loop(clock);
+    auto const start = clock->steady_now();
+
+    repowerd::AndroidAutobrightnessAlgorithm ab_algorithm{
+        device_config_with_valid_curves, clock, fake_log};
+    ASSERT_TRUE(ab_algorithm.init(*simulated_event_loop));
+
+    std::vector<double> ab_values;
+    auto const reg = ab_algorithm.register_autobrightness_handler(
+        [&] (double brightness) { ab_values.push_back(brightness); });
+
+    ab_algorithm.start();
+    ab_algorithm.new_light_value(2.0);
+    ab_algorithm.stop();
+    clock->advance_to(start + 10s);
+
+    ab_algorithm.start();
+    EXPECT_THAT(ab_values.size(), Eq(2));
+    EXPECT_THAT(ab_values[1], Eq(ab_values[0]));
+
+    // A similar first light value doesn't cause another brightness change
+    ab_algorithm.new_light_value(2.0);
+    clock->run_pending();
+    EXPECT_THAT(ab_values.size(), Eq(2));
+
+    ab_algorithm.stop();
+    clock->run_pending();
+}
+
+TEST_F(AnAndroidAutobrightnessAlgorithm,
+       waits_for_light_value_when_restarted_if_previous_light_value_is_old)
+{
+    auto const clock = std::make_shared<repowerd::SimulatedClock>();
+    auto const simulated_event_loop = create_simulated_event_loop(clock);
+    auto const start = clock->steady_now();
+
+    repowerd::AndroidAutobrightnessAlgorithm ab_algorithm{
+        device_config_with_valid_curves, clock, fake_log};
+    ASSERT_TRUE(ab_algorithm.init(*simulated_event_loop));
+
+    std::vector<double> ab_values;
+    auto const reg = ab_algorithm.register_autobrightness_handler(
+        [&] (double brightness) { ab_values.push_back(brightness); });
+
+    ab_algorithm.start();
+    ab_algorithm.new_light_value(2.0);
+    ab_algorithm.stop();
+    clock->advance_to(start + 10min);
+
+    ab_algorithm.start();
+    EXPECT_THAT(ab_values.size(), Eq(1));
+
+    ab_algorithm.new_light_value(2.0);
+    clock->run_pending();
+    EXPECT_THAT(ab_values.size(), Eq(2));
+
+    ab_algorithm.stop();
+    clock->run_pending();
+}
@@ -44,6 +44,7 @@ char const* const config_default1 = R"(
     <item>6</item>
   </integer-array>
   <integer name='config_id'>1</integer>
+  <string name='config_stringconfig'>abc</string>
 </resources>
 )";
 
@@ -108,6 +109,7 @@ TEST_F(AnAndroidDeviceConfig, reads_default_config_file)
     EXPECT_THAT(config.get("integerconfig", ""), StrEq("4"));
     EXPECT_THAT(config.get("integerconfigwithoutprefix", ""), StrEq("680"));
     EXPECT_THAT(config.get("integerarrayconfig", ""), StrEq("2,4,6"));
+    EXPECT_THAT(config.get("stringconfig", ""), StrEq("abc"));
 }
 
 TEST_F(AnAndroidDeviceConfig, returns_default_value_for_unknown_key)
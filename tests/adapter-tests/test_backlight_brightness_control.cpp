@@ -21,7 +21,10 @@
 #include "src/adapters/backlight.h"
 #include "src/adapters/event_loop_handler_registration.h"
 #include "src/adapters/light_sensor.h"
+#include "src/adapters/suspend_pipeline.h"
+#include "src/adapters/wake_pipeline.h"
 
+#include "duration_of.h"
 #include "fake_chrono.h"
 #include "fake_device_config.h"
 #include "fake_device_quirks.h"
@@ -104,8 +107,21 @@ public:
             [this] { light_handler = [](double){}; });
     }
 
+    repowerd::HandlerRegistration register_direct_light_handler(
+        repowerd::EventLoop& event_loop, repowerd::LightHandler const& handler) override
+    {
+        light_handler =
+            [&event_loop, handler] (double light)
+            {
+                event_loop.post([handler, light] { handler(light); });
+            };
+        return repowerd::HandlerRegistration(
+            [this] { light_handler = [](double){}; });
+    }
+
     void enable_light_events() override { enabled = true; }
     void disable_light_events() override { enabled = false; }
+    void set_light_event_rate(repowerd::LightEventRate rate) override { this->rate = rate; }
 
     void emit_light_if_enabled(double light)
     {
@@ -115,6 +131,7 @@ public:
 
     repowerd::LightHandler light_handler{[](double){}};
     bool enabled{false};
+    repowerd::LightEventRate rate{repowerd::LightEventRate::normal};
 };
 
 class FakeAutobrightnessAlgorithm : public repowerd::AutobrightnessAlgorithm
@@ -162,15 +179,95 @@ public:
             [this] { autobrightness_handler = [](double){}; });
     }
 
+    void emit_light_event_rate(repowerd::LightEventRate rate)
+    {
+        event_loop->enqueue([this,rate] { light_event_rate_handler(rate); }).get();
+    }
+
+    repowerd::HandlerRegistration register_light_event_rate_handler(
+        repowerd::LightEventRateHandler const& handler) override
+    {
+        return repowerd::EventLoopHandlerRegistration(
+            *event_loop,
+            [this,&handler] { light_event_rate_handler = handler; },
+            [this] { light_event_rate_handler = [](repowerd::LightEventRate){}; });
+    }
+
     repowerd::EventLoop* event_loop;
     repowerd::AutobrightnessHandler autobrightness_handler{[](double){}};
+    repowerd::LightEventRateHandler light_event_rate_handler{[](repowerd::LightEventRate){}};
     std::vector<double> light_history;
 };
 
 struct ABacklightBrightnessControl : Test
 {
+    // Brightness controls notify of the brightness when a transition
+    // completes, so until the backlight is at the notified brightness a
+    // transition is in progress
+    repowerd::HandlerRegistration observe_transitions_of(
+        repowerd::BacklightBrightnessControl& control)
+    {
+        return control.register_brightness_handler(
+            [this] (double brightness)
+            {
+                std::lock_guard<std::mutex> lock{notification_mutex};
+                notified_brightness = brightness;
+                brightness_handler(brightness);
+            });
+    }
+
+    repowerd::HandlerRegistration register_brightness_handler(
+        repowerd::BrightnessHandler const& handler)
+    {
+        std::lock_guard<std::mutex> lock{notification_mutex};
+        brightness_handler = handler;
+
+        return repowerd::HandlerRegistration{
+            [this]
+            {
+                std::lock_guard<std::mutex> lock{notification_mutex};
+                brightness_handler = [](double){};
+            }};
+    }
+
+    bool is_transition_in_progress()
+    {
+        std::lock_guard<std::mutex> lock{notification_mutex};
+        return backlight.brightness_history.back() != notified_brightness;
+    }
+
+    void wait_for_transition()
+    {
+        rt::spin_wait_for_condition_or_timeout(
+            [this] { return !is_transition_in_progress(); },
+            default_timeout,
+            1ms);
+    }
+
+    std::unique_ptr<repowerd::BacklightBrightnessControl>
+        create_brightness_control_with_transition_curve(
+            std::string const& curve, int frame_rate)
+    {
+        fake_device_config.set("screenBrightnessTransitionCurve", curve);
+        fake_device_config.set("screenBrightnessTransitionFrameRate", std::to_string(frame_rate));
+
+        return std::make_unique<repowerd::BacklightBrightnessControl>(
+            rt::fake_shared(backlight),
+            rt::fake_shared(light_sensor),
+            rt::fake_shared(autobrightness_algorithm),
+            rt::fake_shared(fake_chrono),
+            rt::fake_shared(wake_pipeline),
+            rt::fake_shared(suspend_pipeline),
+            rt::fake_shared(fake_log),
+            fake_device_config,
+            fake_device_quirks,
+            nullptr,
+            nullptr);
+    }
+
     void expect_brightness_value(double brightness)
     {
+        wait_for_transition();
         EXPECT_THAT(backlight.brightness_history.back(), Eq(brightness));
     }
 
@@ -189,14 +286,33 @@ struct ABacklightBrightnessControl : Test
     rt::FakeChrono fake_chrono;
     rt::FakeLog fake_log;
     rt::FakeDeviceQuirks fake_device_quirks;
+    std::chrono::milliseconds const stage_deadline{300};
+    repowerd::WakePipeline wake_pipeline{
+        rt::fake_shared(fake_chrono),
+        rt::fake_shared(fake_log),
+        stage_deadline};
+    repowerd::SuspendPipeline suspend_pipeline{
+        rt::fake_shared(fake_chrono),
+        rt::fake_shared(fake_log),
+        stage_deadline};
     repowerd::BacklightBrightnessControl brightness_control{
         rt::fake_shared(backlight), 
         rt::fake_shared(light_sensor), 
         rt::fake_shared(autobrightness_algorithm),
         rt::fake_shared(fake_chrono),
+        rt::fake_shared(wake_pipeline),
+        rt::fake_shared(suspend_pipeline),
         rt::fake_shared(fake_log),
         fake_device_config,
-        fake_device_quirks};
+        fake_device_quirks,
+        nullptr,
+        nullptr};
+
+    std::mutex notification_mutex;
+    double notified_brightness{backlight.starting_brightness};
+    repowerd::BrightnessHandler brightness_handler{[](double){}};
+    repowerd::HandlerRegistration const transitions_registration{
+        observe_transitions_of(brightness_control)};
 
     double const normal_percent =
         static_cast<double>(fake_device_config.brightness_default_value) /
@@ -209,9 +325,9 @@ struct ABacklightBrightnessControl : Test
     std::chrono::seconds default_timeout{3};
 };
 
-MATCHER_P(IsAbout, a, "")
+MATCHER_P(IsAboutInRealTime, a, "")
 {
-    return arg >= a && arg <= a + 10ms;
+    return arg >= a - 10ms && arg <= a + 50ms;
 }
 
 }
@@ -268,7 +384,9 @@ TEST_F(ABacklightBrightnessControl,
 TEST_F(ABacklightBrightnessControl, transitions_smoothly_between_brightness_values_when_increasing)
 {
     brightness_control.set_off_brightness();
+    wait_for_transition();
     brightness_control.set_normal_brightness();
+    wait_for_transition();
 
     EXPECT_THAT(backlight.brightness_history.size(), Ge(20));
     EXPECT_THAT(backlight.brightness_steps_stddev(), Le(0.01));
@@ -277,10 +395,13 @@ TEST_F(ABacklightBrightnessControl, transitions_smoothly_between_brightness_valu
 TEST_F(ABacklightBrightnessControl, transitions_smoothly_between_brightness_values_when_decreasing)
 {
     brightness_control.set_off_brightness();
+    wait_for_transition();
     brightness_control.set_normal_brightness();
+    wait_for_transition();
     backlight.clear_brightness_history();
 
     brightness_control.set_off_brightness();
+    wait_for_transition();
 
     EXPECT_THAT(backlight.brightness_history.size(), Ge(20));
     EXPECT_THAT(backlight.brightness_steps_stddev(), Le(0.01));
@@ -290,13 +411,74 @@ TEST_F(ABacklightBrightnessControl,
        transitions_between_zero_and_non_zero_brightness_in_100ms)
 {
     brightness_control.set_off_brightness();
+    wait_for_transition();
+
+    EXPECT_THAT(rt::duration_of(
+                    [&]
+                    {
+                        brightness_control.set_normal_brightness();
+                        wait_for_transition();
+                    }),
+                IsAboutInRealTime(100ms));
+    EXPECT_THAT(rt::duration_of(
+                    [&]
+                    {
+                        brightness_control.set_off_brightness();
+                        wait_for_transition();
+                    }),
+                IsAboutInRealTime(100ms));
+    EXPECT_THAT(rt::duration_of(
+                    [&]
+                    {
+                        brightness_control.set_dim_brightness();
+                        wait_for_transition();
+                    }),
+                IsAboutInRealTime(100ms));
+}
+
+TEST_F(ABacklightBrightnessControl, does_not_block_callers_while_transitioning)
+{
+    brightness_control.set_off_brightness();
+    wait_for_transition();
 
     EXPECT_THAT(fake_chrono_duration_of([&]{brightness_control.set_normal_brightness();}),
-                IsAbout(100ms));
+                Eq(0ms));
+    EXPECT_TRUE(is_transition_in_progress());
+
+    wait_for_transition();
     EXPECT_THAT(fake_chrono_duration_of([&]{brightness_control.set_off_brightness();}),
-                IsAbout(100ms));
-    EXPECT_THAT(fake_chrono_duration_of([&]{brightness_control.set_dim_brightness();}),
-                IsAbout(100ms));
+                Eq(0ms));
+    EXPECT_TRUE(is_transition_in_progress());
+
+    expect_brightness_value(0.0);
+}
+
+TEST_F(ABacklightBrightnessControl, retargets_transition_in_progress_smoothly)
+{
+    int num_notifications{0};
+    double notified_brightness{0.0};
+
+    auto const handler_registration =
+        register_brightness_handler(
+            [&](double brightness)
+            {
+                ++num_notifications;
+                notified_brightness = brightness;
+            });
+
+    brightness_control.set_off_brightness();
+    wait_for_transition();
+    num_notifications = 0;
+    backlight.clear_brightness_history();
+
+    brightness_control.set_normal_brightness();
+    brightness_control.set_normal_brightness_value(0.2);
+
+    expect_brightness_value(0.2);
+    auto const steps = backlight.brightness_steps();
+    EXPECT_THAT(*std::max_element(steps.begin(), steps.end()), Le(0.01 + 1e-9));
+    EXPECT_THAT(num_notifications, Eq(1));
+    EXPECT_THAT(notified_brightness, Eq(0.2));
 }
 
 TEST_F(ABacklightBrightnessControl,
@@ -374,6 +556,19 @@ TEST_F(ABacklightBrightnessControl,
     EXPECT_THAT(autobrightness_algorithm.light_history.size(), Eq(1));
 }
 
+TEST_F(ABacklightBrightnessControl,
+       sets_light_event_rate_requested_by_autobrightness_algorithm)
+{
+    brightness_control.set_normal_brightness();
+    brightness_control.enable_autobrightness();
+
+    autobrightness_algorithm.emit_light_event_rate(repowerd::LightEventRate::low);
+    EXPECT_THAT(light_sensor.rate, Eq(repowerd::LightEventRate::low));
+
+    autobrightness_algorithm.emit_light_event_rate(repowerd::LightEventRate::normal);
+    EXPECT_THAT(light_sensor.rate, Eq(repowerd::LightEventRate::normal));
+}
+
 TEST_F(ABacklightBrightnessControl,
        updates_brightness_from_autobrightness_algorithm_when_enabled_while_in_normal_mode)
 {
@@ -410,6 +605,25 @@ TEST_F(ABacklightBrightnessControl,
     expect_brightness_value(0.0);
 }
 
+TEST_F(ABacklightBrightnessControl,
+       sets_autobrightness_value_provided_on_start_when_set_from_off_to_normal_mode)
+{
+    brightness_control.enable_autobrightness();
+    brightness_control.set_normal_brightness();
+    brightness_control.set_off_brightness();
+
+    EXPECT_CALL(autobrightness_algorithm.mock, start())
+        .WillOnce(Invoke([this] { autobrightness_algorithm.autobrightness_handler(0.7); }));
+
+    brightness_control.set_normal_brightness();
+
+    expect_brightness_value(0.7);
+    EXPECT_THAT(std::count(backlight.brightness_history.begin(),
+                           backlight.brightness_history.end(),
+                           normal_percent),
+                Eq(0));
+}
+
 TEST_F(ABacklightBrightnessControl,
        sets_normal_brightness_if_autobrightness_enabled_when_set_from_off_to_normal_mode_with_quirk)
 {
@@ -419,15 +633,21 @@ TEST_F(ABacklightBrightnessControl,
         rt::fake_shared(light_sensor), 
         rt::fake_shared(autobrightness_algorithm),
         rt::fake_shared(fake_chrono),
+        rt::fake_shared(wake_pipeline),
+        rt::fake_shared(suspend_pipeline),
         rt::fake_shared(fake_log),
         fake_device_config,
-        fake_device_quirks};
+        fake_device_quirks,
+        nullptr,
+        nullptr};
+    auto const registration = observe_transitions_of(quirked_brightness_control);
 
     quirked_brightness_control.enable_autobrightness();
     quirked_brightness_control.set_normal_brightness();
     quirked_brightness_control.set_off_brightness();
 
     quirked_brightness_control.set_normal_brightness();
+    wait_for_transition();
     expect_brightness_value(normal_percent);
 }
 
@@ -549,15 +769,17 @@ TEST_F(ABacklightBrightnessControl, notifies_of_brightness_change)
     double notified_brightness{0.0};
 
     auto const handler_registration =
-        brightness_control.register_brightness_handler(
+        register_brightness_handler(
             [&](double brightness) { notified_brightness = brightness; });
 
     brightness_control.set_normal_brightness();
     brightness_control.set_normal_brightness_value(0.9);
+    wait_for_transition();
 
     EXPECT_THAT(notified_brightness, Eq(0.9));
 
     brightness_control.set_dim_brightness();
+    wait_for_transition();
 
     EXPECT_THAT(notified_brightness, Eq(dim_percent));
 }
@@ -567,12 +789,13 @@ TEST_F(ABacklightBrightnessControl, notifies_of_autobrightness_change)
     double notified_brightness{0.0};
 
     auto const handler_registration =
-        brightness_control.register_brightness_handler(
+        register_brightness_handler(
             [&](double brightness) { notified_brightness = brightness; });
 
     brightness_control.set_normal_brightness();
     brightness_control.enable_autobrightness();
     autobrightness_algorithm.emit_autobrightness(0.9);
+    wait_for_transition();
 
     EXPECT_THAT(notified_brightness, Eq(0.9));
 }
@@ -582,7 +805,7 @@ TEST_F(ABacklightBrightnessControl, does_not_notify_if_brightness_does_not_chang
     double notified_brightness{-1.0};
 
     auto const handler_registration =
-        brightness_control.register_brightness_handler(
+        register_brightness_handler(
             [&](double brightness) { notified_brightness = brightness; });
 
     expect_brightness_value(backlight.starting_brightness);
@@ -598,6 +821,7 @@ TEST_F(ABacklightBrightnessControl, does_not_notify_if_brightness_does_not_chang
 TEST_F(ABacklightBrightnessControl, logs_brightness_transition)
 {
     brightness_control.set_off_brightness();
+    wait_for_transition();
 
     EXPECT_TRUE(fake_log.contains_line(
         {std::to_string(normal_percent).substr(0, 4), "0.00", "steps"}));
@@ -619,6 +843,7 @@ TEST_F(ABacklightBrightnessControl, transitions_directly_to_new_value_if_current
     auto const prev_history_size = backlight.brightness_history.size();
 
     brightness_control.set_dim_brightness();
+    wait_for_transition();
 
     EXPECT_THAT(backlight.brightness_history.size(), Eq(prev_history_size + 1));
     expect_brightness_value(dim_percent);
@@ -635,3 +860,158 @@ TEST_F(ABacklightBrightnessControl, logs_autobrightness_values)
     EXPECT_TRUE(fake_log.contains_line(
         {"autobrightness", "value", std::to_string(autobrightness_value).substr(0, 4)}));
 }
+
+TEST_F(ABacklightBrightnessControl,
+       perceptual_transitions_write_bounded_number_of_values_regardless_of_distance)
+{
+    auto const perceptual_brightness_control =
+        create_brightness_control_with_transition_curve("gamma", 60);
+    auto const registration = observe_transitions_of(*perceptual_brightness_control);
+    auto const max_writes = 6u;
+
+    perceptual_brightness_control->set_off_brightness();
+    wait_for_transition();
+    backlight.clear_brightness_history();
+
+    perceptual_brightness_control->set_normal_brightness();
+    wait_for_transition();
+    EXPECT_THAT(backlight.brightness_history.size() - 1, Eq(max_writes));
+    backlight.clear_brightness_history();
+
+    perceptual_brightness_control->set_normal_brightness_value(0.52);
+    wait_for_transition();
+    EXPECT_THAT(backlight.brightness_history.size() - 1, Le(max_writes));
+    backlight.clear_brightness_history();
+
+    perceptual_brightness_control->set_normal_brightness_value(1.0);
+    wait_for_transition();
+    EXPECT_THAT(backlight.brightness_history.size() - 1, Le(max_writes));
+
+    expect_brightness_value(1.0);
+}
+
+TEST_F(ABacklightBrightnessControl, perceptual_transitions_use_configured_frame_rate)
+{
+    auto const perceptual_brightness_control =
+        create_brightness_control_with_transition_curve("log", 120);
+    auto const registration = observe_transitions_of(*perceptual_brightness_control);
+
+    perceptual_brightness_control->set_off_brightness();
+    wait_for_transition();
+    backlight.clear_brightness_history();
+
+    perceptual_brightness_control->set_normal_brightness();
+    wait_for_transition();
+
+    EXPECT_THAT(backlight.brightness_history.size() - 1, Eq(12u));
+    expect_brightness_value(normal_percent);
+}
+
+TEST_F(ABacklightBrightnessControl, perceptual_transitions_ease_in_perceptual_space)
+{
+    auto const perceptual_brightness_control =
+        create_brightness_control_with_transition_curve("gamma", 60);
+    auto const registration = observe_transitions_of(*perceptual_brightness_control);
+
+    perceptual_brightness_control->set_off_brightness();
+    wait_for_transition();
+    backlight.clear_brightness_history();
+
+    perceptual_brightness_control->set_normal_brightness();
+    wait_for_transition();
+
+    auto const& history = backlight.brightness_history;
+    EXPECT_TRUE(std::is_sorted(history.begin(), history.end()));
+    // Halfway through, the brightness is perceptually, not linearly, halfway
+    EXPECT_THAT(history[history.size() / 2], Lt(normal_percent / 2));
+    EXPECT_THAT(history.back(), Eq(normal_percent));
+}
+
+TEST_F(ABacklightBrightnessControl, waits_for_panel_to_turn_on_before_ramping_up_from_off)
+{
+    brightness_control.set_off_brightness();
+    wait_for_transition();
+
+    wake_pipeline.start_wake();
+    brightness_control.set_normal_brightness();
+    wait_for_transition();
+
+    EXPECT_THAT(backlight.brightness_history.back(), Eq(0));
+
+    wake_pipeline.complete_stage(repowerd::WakeStage::panel_on);
+
+    expect_brightness_value(normal_percent);
+}
+
+TEST_F(ABacklightBrightnessControl, does_not_ramp_up_after_panel_turns_on_if_turned_off_meanwhile)
+{
+    brightness_control.set_off_brightness();
+    wait_for_transition();
+
+    wake_pipeline.start_wake();
+    brightness_control.set_normal_brightness();
+    brightness_control.set_off_brightness();
+
+    wake_pipeline.complete_stage(repowerd::WakeStage::panel_on);
+
+    // Process the deferred ramp, if any
+    brightness_control.set_off_brightness();
+    expect_brightness_value(0);
+}
+
+TEST_F(ABacklightBrightnessControl, ramps_up_anyway_if_panel_does_not_turn_on_by_deadline)
+{
+    brightness_control.set_off_brightness();
+    wait_for_transition();
+
+    wake_pipeline.start_wake();
+    brightness_control.set_normal_brightness();
+
+    std::this_thread::sleep_for(stage_deadline + 50ms);
+
+    expect_brightness_value(normal_percent);
+    EXPECT_TRUE(fake_log.contains_line({"not", "on", "deadline"}));
+}
+
+TEST_F(ABacklightBrightnessControl, counts_panel_deadline_from_wake_start)
+{
+    brightness_control.set_off_brightness();
+    wait_for_transition();
+
+    wake_pipeline.start_wake();
+    fake_chrono.sleep_for(stage_deadline);
+    brightness_control.set_normal_brightness();
+
+    std::this_thread::sleep_for(50ms);
+
+    expect_brightness_value(normal_percent);
+    EXPECT_TRUE(fake_log.contains_line({"not", "on", "deadline"}));
+}
+
+TEST_F(ABacklightBrightnessControl, completes_backlight_off_suspend_stage_when_fade_out_ends)
+{
+    brightness_control.set_normal_brightness();
+    wait_for_transition();
+
+    brightness_control.set_off_brightness();
+
+    EXPECT_TRUE(
+        rt::spin_wait_for_condition_or_timeout(
+            [this] { return !suspend_pipeline.has_stages_in_progress(); },
+            stage_deadline));
+    EXPECT_FALSE(fake_log.contains_line({"backlight_off", "missed"}));
+    expect_brightness_value(0);
+}
+
+TEST_F(ABacklightBrightnessControl, does_not_complete_backlight_off_suspend_stage_when_fade_out_is_retargeted)
+{
+    brightness_control.set_normal_brightness();
+    wait_for_transition();
+
+    brightness_control.set_off_brightness();
+    brightness_control.set_dim_brightness();
+    wait_for_transition();
+
+    expect_brightness_value(dim_percent);
+    EXPECT_TRUE(suspend_pipeline.is_stage_in_progress(repowerd::SuspendStage::backlight_off));
+}
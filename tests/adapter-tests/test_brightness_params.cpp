@@ -57,4 +57,35 @@ TEST_F(ABrightnessParams, falls_back_to_sensible_values_if_config_entries_are_mi
     EXPECT_THAT(brightness_params.max_value, Eq(255));
     EXPECT_THAT(brightness_params.default_value, Eq(102));
     EXPECT_THAT(brightness_params.autobrightness_supported, Eq(false));
+    EXPECT_THAT(brightness_params.transition_curve,
+                Eq(repowerd::BrightnessTransitionCurve::linear));
+    EXPECT_THAT(brightness_params.transition_frame_rate, Eq(60));
+}
+
+TEST_F(ABrightnessParams, reads_transition_curve_and_frame_rate)
+{
+    device_config.set("screenBrightnessTransitionCurve", "gamma");
+    device_config.set("screenBrightnessTransitionFrameRate", "30");
+    auto brightness_params = repowerd::BrightnessParams::from_device_config(device_config);
+
+    EXPECT_THAT(brightness_params.transition_curve,
+                Eq(repowerd::BrightnessTransitionCurve::gamma));
+    EXPECT_THAT(brightness_params.transition_frame_rate, Eq(30));
+
+    device_config.set("screenBrightnessTransitionCurve", "log");
+    brightness_params = repowerd::BrightnessParams::from_device_config(device_config);
+
+    EXPECT_THAT(brightness_params.transition_curve,
+                Eq(repowerd::BrightnessTransitionCurve::log));
+}
+
+TEST_F(ABrightnessParams, falls_back_to_sensible_transition_values_if_invalid)
+{
+    device_config.set("screenBrightnessTransitionCurve", "bla");
+    device_config.set("screenBrightnessTransitionFrameRate", "0");
+    auto const brightness_params = repowerd::BrightnessParams::from_device_config(device_config);
+
+    EXPECT_THAT(brightness_params.transition_curve,
+                Eq(repowerd::BrightnessTransitionCurve::linear));
+    EXPECT_THAT(brightness_params.transition_frame_rate, Eq(60));
 }
@@ -0,0 +1,76 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "src/adapters/dbus_connection_handle.h"
+
+#include "dbus_bus.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <memory>
+
+using namespace testing;
+
+namespace rt = repowerd::test;
+
+namespace
+{
+
+struct ADBusConnectionHandle : Test
+{
+    rt::DBusBus bus;
+};
+
+}
+
+TEST_F(ADBusConnectionHandle, opens_separate_connections_for_addresses)
+{
+    repowerd::DBusConnectionHandle handle1{bus.address()};
+    repowerd::DBusConnectionHandle handle2{bus.address()};
+
+    EXPECT_THAT(static_cast<GDBusConnection*>(handle1),
+                Ne(static_cast<GDBusConnection*>(handle2)));
+}
+
+TEST_F(ADBusConnectionHandle, uses_connection_of_shared_handle)
+{
+    auto const shared = std::make_shared<repowerd::DBusConnectionHandle>(bus.address());
+
+    repowerd::DBusConnectionHandle handle1{shared};
+    repowerd::DBusConnectionHandle handle2{shared};
+
+    EXPECT_THAT(static_cast<GDBusConnection*>(handle1),
+                Eq(static_cast<GDBusConnection*>(*shared)));
+    EXPECT_THAT(static_cast<GDBusConnection*>(handle2),
+                Eq(static_cast<GDBusConnection*>(*shared)));
+}
+
+TEST_F(ADBusConnectionHandle, keeps_shared_connection_open_until_last_handle_is_destroyed)
+{
+    auto shared = std::make_shared<repowerd::DBusConnectionHandle>(bus.address());
+
+    auto handle1 = std::make_unique<repowerd::DBusConnectionHandle>(shared);
+    repowerd::DBusConnectionHandle handle2{shared};
+
+    shared.reset();
+    handle1.reset();
+
+    EXPECT_FALSE(g_dbus_connection_is_closed(handle2));
+    EXPECT_NO_THROW(handle2.request_name("com.test.Name"));
+}
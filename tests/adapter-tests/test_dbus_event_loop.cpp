@@ -19,6 +19,9 @@
 #include "src/adapters/dbus_event_loop.h"
 
 #include "current_thread_name.h"
+#include "dbus_bus.h"
+#include "dbus_client.h"
+#include "wait_condition.h"
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
@@ -27,6 +30,24 @@ using namespace testing;
 
 namespace rt = repowerd::test;
 
+namespace
+{
+
+char const* const test_path = "/com/test/Object";
+char const* const test_interface = "com.test.Interface";
+
+struct TestDBusClient : rt::DBusClient
+{
+    TestDBusClient(std::string const& bus_address)
+        : rt::DBusClient{bus_address, "com.test.Service", test_path}
+    {
+    }
+};
+
+std::chrono::seconds const default_timeout{3};
+
+}
+
 TEST(ADBusEventLoop, sets_thread_name)
 {
     std::string const thread_name{"MyThreadName"};
@@ -51,3 +72,74 @@ TEST(ADBusEventLoop, truncates_long_thread_name)
     EXPECT_THAT(event_loop_thread_name, StrEq(long_thread_name.substr(0, 15)));
 }
 
+TEST(ADBusEventLoop, handles_signals_subscribed_in_registration_batch)
+{
+    rt::DBusBus bus;
+    auto const batch = std::make_shared<repowerd::DBusRegistrationBatch>();
+    repowerd::DBusConnectionHandle connection{bus.address(), batch};
+    repowerd::DBusEventLoop event_loop{"Test"};
+    TestDBusClient client{bus.address()};
+    rt::WaitCondition signal_received;
+
+    batch->start();
+
+    auto const registration = event_loop.register_signal_handler(
+        connection,
+        nullptr,
+        test_interface,
+        "Signal",
+        test_path,
+        [&] (GDBusConnection*, char const*, char const*, char const*,
+             char const*, GVariant*)
+        {
+            signal_received.wake_up();
+        });
+
+    batch->finish();
+
+    client.emit_signal(test_interface, "Signal", nullptr);
+
+    signal_received.wait_for(default_timeout);
+    EXPECT_TRUE(signal_received.woken());
+}
+
+TEST(ADBusEventLoop, defers_registration_waits_to_active_batch_only)
+{
+    rt::DBusBus bus;
+    repowerd::DBusConnectionHandle connection{bus.address()};
+    repowerd::DBusRegistrationBatch batch;
+
+    EXPECT_FALSE(batch.add_pending_requests(connection));
+
+    batch.start();
+    EXPECT_TRUE(batch.add_pending_requests(connection));
+    batch.finish();
+
+    EXPECT_FALSE(batch.add_pending_requests(connection));
+}
+
+TEST(ADBusEventLoop, shares_registration_batch_with_shared_connection_handles)
+{
+    rt::DBusBus bus;
+    auto const batch = std::make_shared<repowerd::DBusRegistrationBatch>();
+    auto const connection =
+        std::make_shared<repowerd::DBusConnectionHandle>(bus.address(), batch);
+    repowerd::DBusConnectionHandle shared_connection{connection};
+    repowerd::DBusConnectionHandle other_connection{bus.address()};
+
+    EXPECT_THAT(shared_connection.registration_batch(), Eq(batch));
+    EXPECT_THAT(other_connection.registration_batch(), IsNull());
+}
+
+TEST(ADBusEventLoop, refuses_to_start_active_registration_batch)
+{
+    repowerd::DBusRegistrationBatch batch;
+
+    batch.start();
+
+    EXPECT_THROW({ batch.start(); }, std::logic_error);
+
+    batch.finish();
+
+    EXPECT_NO_THROW({ batch.start(); });
+}
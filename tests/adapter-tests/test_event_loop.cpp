@@ -25,8 +25,11 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <future>
 #include <mutex>
+#include <stdexcept>
 #include <system_error>
+#include <vector>
 
 using namespace testing;
 
@@ -107,3 +110,57 @@ TEST(AnEventLoop, watches_fd)
     if (write(write_fd, "b", 1)) {}
     wait_for_string_contents(data, "ab", data_mutex);
 }
+
+TEST(AnEventLoop, runs_enqueued_callbacks_in_order)
+{
+    repowerd::EventLoop event_loop{"order"};
+
+    std::vector<int> values;
+    std::vector<int> expected_values;
+
+    for (int i = 0; i < 100; ++i)
+    {
+        event_loop.enqueue([&values, i] { values.push_back(i); });
+        expected_values.push_back(i);
+    }
+
+    event_loop.enqueue([]{}).wait();
+
+    EXPECT_THAT(values, ContainerEq(expected_values));
+}
+
+TEST(AnEventLoop, runs_posted_callbacks_in_order_with_enqueued_callbacks)
+{
+    repowerd::EventLoop event_loop{"post"};
+
+    std::string data;
+
+    event_loop.post([&] { data += "a"; });
+    event_loop.enqueue([&] { data += "b"; });
+    event_loop.post([&] { data += "c"; });
+    event_loop.enqueue([]{}).wait();
+
+    EXPECT_THAT(data, StrEq("abc"));
+}
+
+TEST(AnEventLoop, runs_callbacks_enqueued_from_callbacks)
+{
+    repowerd::EventLoop event_loop{"nested"};
+
+    std::promise<void> nested_done;
+
+    event_loop.enqueue(
+        [&] { event_loop.post([&] { nested_done.set_value(); }); });
+
+    EXPECT_THAT(nested_done.get_future().wait_for(std::chrono::seconds{3}),
+                Eq(std::future_status::ready));
+}
+
+TEST(AnEventLoop, propagates_enqueued_callback_exception_to_future)
+{
+    repowerd::EventLoop event_loop{"exception"};
+
+    auto future = event_loop.enqueue([] { throw std::runtime_error{"error"}; });
+
+    EXPECT_THROW({ future.get(); }, std::runtime_error);
+}
@@ -0,0 +1,219 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "src/adapters/event_loop.h"
+#include "src/adapters/event_loop_executor.h"
+#include "src/adapters/process_status.h"
+#include "src/adapters/real_filesystem.h"
+
+#include "current_thread_name.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <future>
+#include <stdexcept>
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace rt = repowerd::test;
+
+namespace
+{
+
+struct AnEventLoopExecutor : Test
+{
+    std::thread::id thread_id_of(repowerd::EventLoop& event_loop)
+    {
+        std::thread::id id;
+        event_loop.enqueue([&] { id = std::this_thread::get_id(); }).wait();
+        return id;
+    }
+
+    size_t current_num_threads()
+    {
+        return repowerd::current_process_status(real_fs).num_threads;
+    }
+
+    repowerd::RealFilesystem real_fs;
+};
+
+}
+
+TEST_F(AnEventLoopExecutor, runs_event_loops_on_shared_thread)
+{
+    auto const executor = std::make_shared<repowerd::EventLoopExecutor>("Shared", 1);
+    repowerd::EventLoop event_loop1{"Loop1", executor};
+    repowerd::EventLoop event_loop2{"Loop2", executor};
+
+    auto const thread_id1 = thread_id_of(event_loop1);
+    auto const thread_id2 = thread_id_of(event_loop2);
+
+    EXPECT_THAT(thread_id1, Eq(thread_id2));
+    EXPECT_THAT(thread_id1, Ne(std::this_thread::get_id()));
+}
+
+TEST_F(AnEventLoopExecutor, names_its_threads)
+{
+    auto const executor = std::make_shared<repowerd::EventLoopExecutor>("Shared", 1);
+    repowerd::EventLoop event_loop{"Loop", executor};
+
+    std::string thread_name;
+    event_loop.enqueue([&] { thread_name = rt::current_thread_name(); }).wait();
+
+    EXPECT_THAT(thread_name, StrEq("Shared0"));
+}
+
+TEST_F(AnEventLoopExecutor, spreads_event_loops_over_threads)
+{
+    auto const executor = std::make_shared<repowerd::EventLoopExecutor>("Shared", 2);
+    repowerd::EventLoop event_loop1{"Loop1", executor};
+    repowerd::EventLoop event_loop2{"Loop2", executor};
+
+    EXPECT_THAT(thread_id_of(event_loop1), Ne(thread_id_of(event_loop2)));
+}
+
+TEST_F(AnEventLoopExecutor, dispatches_each_event_loop_with_its_own_thread_default_context)
+{
+    auto const executor = std::make_shared<repowerd::EventLoopExecutor>("Shared", 1);
+    repowerd::EventLoop event_loop1{"Loop1", executor};
+    repowerd::EventLoop event_loop2{"Loop2", executor};
+
+    GMainContext* context1{nullptr};
+    GMainContext* context2{nullptr};
+    event_loop1.enqueue([&] { context1 = g_main_context_get_thread_default(); }).wait();
+    event_loop2.enqueue([&] { context2 = g_main_context_get_thread_default(); }).wait();
+
+    EXPECT_THAT(context1, NotNull());
+    EXPECT_THAT(context2, NotNull());
+    EXPECT_THAT(context1, Ne(context2));
+}
+
+TEST_F(AnEventLoopExecutor, does_not_run_callbacks_of_stopped_event_loop)
+{
+    auto const executor = std::make_shared<repowerd::EventLoopExecutor>("Shared", 1);
+    repowerd::EventLoop event_loop1{"Loop1", executor};
+    repowerd::EventLoop event_loop2{"Loop2", executor};
+
+    std::atomic<bool> stopped_callback_called{false};
+    event_loop1.schedule_in(50ms, [&] { stopped_callback_called = true; });
+    event_loop1.stop();
+
+    event_loop2.schedule_in(100ms, []{}).wait();
+
+    EXPECT_FALSE(stopped_callback_called);
+}
+
+TEST_F(AnEventLoopExecutor, refuses_waiting_for_event_loop_sharing_the_same_thread)
+{
+    auto const executor = std::make_shared<repowerd::EventLoopExecutor>("Shared", 1);
+    repowerd::EventLoop event_loop1{"Loop1", executor};
+    repowerd::EventLoop event_loop2{"Loop2", executor};
+
+    bool exception_caught{false};
+    bool callback_called{false};
+
+    event_loop1.enqueue(
+        [&]
+        {
+            try
+            {
+                event_loop2.enqueue([&] { callback_called = true; }).get();
+            }
+            catch (std::logic_error const&)
+            {
+                exception_caught = true;
+            }
+        }).wait();
+
+    // Flush event_loop2, so that any callback queued before the error runs
+    event_loop2.enqueue([]{}).wait();
+
+    EXPECT_TRUE(exception_caught);
+    EXPECT_FALSE(callback_called);
+}
+
+TEST_F(AnEventLoopExecutor, runs_callbacks_posted_from_event_loop_sharing_the_same_thread)
+{
+    auto const executor = std::make_shared<repowerd::EventLoopExecutor>("Shared", 1);
+    repowerd::EventLoop event_loop1{"Loop1", executor};
+    repowerd::EventLoop event_loop2{"Loop2", executor};
+
+    std::promise<GMainContext*> inner_context_promise;
+    GMainContext* outer_context{nullptr};
+
+    event_loop1.enqueue(
+        [&]
+        {
+            event_loop2.post(
+                [&]
+                {
+                    inner_context_promise.set_value(
+                        g_main_context_get_thread_default());
+                });
+            outer_context = g_main_context_get_thread_default();
+        }).wait();
+
+    auto const inner_context = inner_context_promise.get_future().get();
+
+    EXPECT_THAT(inner_context, NotNull());
+    EXPECT_THAT(outer_context, NotNull());
+    EXPECT_THAT(inner_context, Ne(outer_context));
+}
+
+TEST_F(AnEventLoopExecutor, allows_waiting_for_event_loop_on_another_thread)
+{
+    auto const executor = std::make_shared<repowerd::EventLoopExecutor>("Shared", 2);
+    repowerd::EventLoop event_loop1{"Loop1", executor};
+    repowerd::EventLoop event_loop2{"Loop2", executor};
+
+    bool inner_callback_called{false};
+
+    event_loop1.enqueue(
+        [&]
+        {
+            event_loop2.enqueue([&] { inner_callback_called = true; }).get();
+        }).wait();
+
+    EXPECT_TRUE(inner_callback_called);
+}
+
+TEST_F(AnEventLoopExecutor, uses_fewer_threads_than_dedicated_event_loops)
+{
+    size_t constexpr num_event_loops = 4;
+    auto const initial_num_threads = current_num_threads();
+
+    {
+        std::vector<std::unique_ptr<repowerd::EventLoop>> event_loops;
+        for (size_t i = 0; i < num_event_loops; ++i)
+            event_loops.push_back(std::make_unique<repowerd::EventLoop>("Dedicated"));
+
+        EXPECT_THAT(current_num_threads(), Eq(initial_num_threads + num_event_loops));
+    }
+
+    {
+        auto const executor = std::make_shared<repowerd::EventLoopExecutor>("Shared", 1);
+        std::vector<std::unique_ptr<repowerd::EventLoop>> event_loops;
+        for (size_t i = 0; i < num_event_loops; ++i)
+            event_loops.push_back(std::make_unique<repowerd::EventLoop>("Loop", executor));
+
+        EXPECT_THAT(current_num_threads(), Eq(initial_num_threads + 1));
+    }
+}
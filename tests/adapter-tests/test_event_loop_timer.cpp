@@ -35,7 +35,7 @@ namespace
 
 struct AnEventLoopTimer : testing::Test
 {
-    repowerd::EventLoopTimer timer;
+    repowerd::EventLoopTimer timer{nullptr};
     repowerd::HandlerRegistration const reg{
         timer.register_alarm_handler(
             [this](repowerd::AlarmId id) { alarm_handler(id); })};
@@ -133,3 +133,50 @@ TEST_F(AnEventLoopTimer, does_not_notify_for_cancelled_alarms)
 
     std::this_thread::sleep_for(250ms);
 }
+
+TEST_F(AnEventLoopTimer, notifies_for_alarm_scheduled_earlier_than_pending_alarms)
+{
+    auto const id1 = timer.schedule_alarm_in(10s);
+    auto const id2 = timer.schedule_alarm_in(50ms);
+
+    rt::WaitCondition alarm_triggered;
+
+    EXPECT_CALL(*this, alarm_handler(id1)).Times(0);
+    EXPECT_CALL(*this, alarm_handler(id2))
+        .WillOnce(WakeUp(&alarm_triggered));
+
+    alarm_triggered.wait_for(100ms);
+    EXPECT_TRUE(alarm_triggered.woken());
+}
+
+TEST_F(AnEventLoopTimer, notifies_for_later_alarm_when_earliest_alarm_is_cancelled)
+{
+    auto const id1 = timer.schedule_alarm_in(50ms);
+    auto const id2 = timer.schedule_alarm_in(100ms);
+
+    rt::WaitCondition alarm_triggered;
+
+    EXPECT_CALL(*this, alarm_handler(id1)).Times(0);
+    EXPECT_CALL(*this, alarm_handler(id2))
+        .WillOnce(WakeUp(&alarm_triggered));
+
+    timer.cancel_alarm(id1);
+
+    alarm_triggered.wait_for(150ms);
+    EXPECT_TRUE(alarm_triggered.woken());
+}
+
+TEST_F(AnEventLoopTimer, does_not_accumulate_entries_for_rescheduled_alarms)
+{
+    EXPECT_CALL(*this, alarm_handler(_)).Times(0);
+
+    auto id = timer.schedule_alarm_in(10s);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        timer.cancel_alarm(id);
+        id = timer.schedule_alarm_in(10s);
+    }
+
+    EXPECT_THAT(timer.num_stored_alarm_entries(), Le(64u));
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "src/adapters/latest_value_mailbox.h"
+#include "src/adapters/event_loop.h"
+
+#include "wait_condition.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <thread>
+#include <vector>
+
+namespace rt = repowerd::test;
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+struct ALatestValueMailbox : Test
+{
+    void block_event_loop()
+    {
+        event_loop.post([this] { unblock.wait_for(default_timeout); });
+    }
+
+    void wait_for_event_loop_processing()
+    {
+        event_loop.enqueue([]{}).get();
+    }
+
+    repowerd::EventLoop event_loop{"test"};
+    rt::WaitCondition unblock;
+    std::vector<double> values;
+    std::chrono::seconds const default_timeout{3};
+};
+
+}
+
+TEST_F(ALatestValueMailbox, delivers_value_on_event_loop)
+{
+    std::thread::id handler_thread_id;
+    repowerd::LatestValueMailbox mailbox{
+        event_loop,
+        [&] (double v) { values.push_back(v); handler_thread_id = std::this_thread::get_id(); }};
+
+    mailbox.post(1.0);
+    wait_for_event_loop_processing();
+
+    EXPECT_THAT(values, ElementsAre(1.0));
+    EXPECT_THAT(handler_thread_id, Ne(std::this_thread::get_id()));
+}
+
+TEST_F(ALatestValueMailbox, delivers_only_latest_value_if_values_arrive_faster_than_handled)
+{
+    repowerd::LatestValueMailbox mailbox{
+        event_loop, [this] (double v) { values.push_back(v); }};
+
+    block_event_loop();
+    mailbox.post(1.0);
+    mailbox.post(2.0);
+    mailbox.post(3.0);
+    unblock.wake_up();
+    wait_for_event_loop_processing();
+
+    EXPECT_THAT(values, ElementsAre(3.0));
+
+    mailbox.post(4.0);
+    wait_for_event_loop_processing();
+
+    EXPECT_THAT(values, ElementsAre(3.0, 4.0));
+}
+
+TEST_F(ALatestValueMailbox, delays_delivery_with_post_in)
+{
+    repowerd::LatestValueMailbox mailbox{
+        event_loop, [this] (double v) { values.push_back(v); }};
+
+    mailbox.post_in(100ms, 1.0);
+    mailbox.post(2.0);
+    wait_for_event_loop_processing();
+
+    EXPECT_THAT(values, IsEmpty());
+
+    std::this_thread::sleep_for(200ms);
+    wait_for_event_loop_processing();
+
+    EXPECT_THAT(values, ElementsAre(2.0));
+}
+
+TEST_F(ALatestValueMailbox, drops_queued_delivery_when_destroyed)
+{
+    auto mailbox = std::make_unique<repowerd::LatestValueMailbox>(
+        event_loop, [this] (double v) { values.push_back(v); });
+
+    block_event_loop();
+    mailbox->post(1.0);
+    mailbox.reset();
+    unblock.wake_up();
+    wait_for_event_loop_processing();
+
+    EXPECT_THAT(values, IsEmpty());
+}
+
+TEST_F(ALatestValueMailbox, delivers_delayed_value_immediately_when_flushed)
+{
+    repowerd::LatestValueMailbox mailbox{
+        event_loop, [this] (double v) { values.push_back(v); }};
+
+    mailbox.post_in(100ms, 1.0);
+    mailbox.post_in(100ms, 2.0);
+    mailbox.flush();
+    wait_for_event_loop_processing();
+
+    EXPECT_THAT(values, ElementsAre(2.0));
+
+    std::this_thread::sleep_for(200ms);
+    wait_for_event_loop_processing();
+
+    EXPECT_THAT(values, ElementsAre(2.0));
+
+    mailbox.post(3.0);
+    wait_for_event_loop_processing();
+
+    EXPECT_THAT(values, ElementsAre(2.0, 3.0));
+}
+
+TEST_F(ALatestValueMailbox, does_not_deliver_when_flushed_without_pending_value)
+{
+    repowerd::LatestValueMailbox mailbox{
+        event_loop, [this] (double v) { values.push_back(v); }};
+
+    mailbox.flush();
+    wait_for_event_loop_processing();
+
+    EXPECT_THAT(values, IsEmpty());
+}
@@ -67,7 +67,8 @@ struct ALogindSessionTracker : testing::Test
                 rt::fake_shared(fake_filesystem),
                 rt::fake_shared(fake_log),
                 fake_device_quirks,
-                bus.address());
+                std::make_shared<repowerd::DBusConnectionHandle>(bus.address()),
+                nullptr);
 
         registrations.push_back(
             logind_session_tracker->register_active_session_changed_handler(
@@ -122,6 +123,21 @@ struct ALogindSessionTracker : testing::Test
             "Uid:	" + uid_str + " " + uid_str + " " + uid_str + " " + uid_str);
 
     }
+
+    void set_pid_start_time(pid_t pid, unsigned long long start_time)
+    {
+        fake_filesystem.add_file_with_contents(
+            "/proc/" + std::to_string(pid) + "/stat",
+            std::to_string(pid) + " (a (b) c) S 1 1 1 0 -1 0 0 0 0 0 0 0 0 0 20 0 1 0 " +
+            std::to_string(start_time) + " 1000 100");
+    }
+
+    void expect_pid_session_cache_stats(size_t hits, size_t misses)
+    {
+        auto const stats = logind_session_tracker->pid_session_cache_stats();
+        EXPECT_THAT(stats.hits, Eq(hits));
+        EXPECT_THAT(stats.misses, Eq(misses));
+    }
     void wait_until_active_session_is(std::string const& session_id)
     {
         std::unique_lock<std::mutex> lock{session_mutex};
@@ -406,3 +422,93 @@ TEST_F(ALogindSessionTracker, logs_tracked_session_removal)
     EXPECT_TRUE(fake_log.contains_line({"remove_session", session_id(0)}));
     EXPECT_FALSE(fake_log.contains_line({"remove_session", session_id(1)}));
 }
+
+TEST_F(ALogindSessionTracker, caches_session_for_pid)
+{
+    set_pid_start_time(session_pid(0), 10);
+
+    EXPECT_THAT(logind_session_tracker->session_for_pid(session_pid(0)),
+                StrEq(session_id(0)));
+    EXPECT_THAT(logind_session_tracker->session_for_pid(session_pid(0)),
+                StrEq(session_id(0)));
+
+    expect_pid_session_cache_stats(1, 1);
+}
+
+TEST_F(ALogindSessionTracker, does_not_cache_session_for_pid_without_start_time)
+{
+    EXPECT_THAT(logind_session_tracker->session_for_pid(session_pid(0)),
+                StrEq(session_id(0)));
+    EXPECT_THAT(logind_session_tracker->session_for_pid(session_pid(0)),
+                StrEq(session_id(0)));
+
+    expect_pid_session_cache_stats(0, 2);
+}
+
+TEST_F(ALogindSessionTracker, does_not_cache_session_for_pid_with_truncated_stat)
+{
+    fake_filesystem.add_file_with_contents(
+        "/proc/" + std::to_string(session_pid(0)) + "/stat",
+        std::to_string(session_pid(0)) + " (a (b) c) S 1 1 1 0 -1 0 0 0");
+
+    EXPECT_THAT(logind_session_tracker->session_for_pid(session_pid(0)),
+                StrEq(session_id(0)));
+    EXPECT_THAT(logind_session_tracker->session_for_pid(session_pid(0)),
+                StrEq(session_id(0)));
+
+    expect_pid_session_cache_stats(0, 2);
+}
+
+TEST_F(ALogindSessionTracker, does_not_use_cached_session_for_reused_pid)
+{
+    pid_t const pid = 667;
+    uid_t const root_uid = 0;
+
+    set_pid_start_time(pid, 10);
+    associate_pid_with_uid(pid, root_uid);
+
+    EXPECT_THAT(logind_session_tracker->session_for_pid(pid),
+                StrEq(session_id(0)));
+
+    set_pid_start_time(pid, 20);
+    associate_pid_with_uid(pid, 9999);
+
+    EXPECT_THAT(logind_session_tracker->session_for_pid(pid),
+                StrEq(repowerd::invalid_session_id));
+
+    expect_pid_session_cache_stats(0, 2);
+}
+
+TEST_F(ALogindSessionTracker, invalidates_cached_sessions_when_active_session_changes)
+{
+    pid_t const pid = 667;
+
+    set_pid_start_time(pid, 10);
+    associate_pid_with_uid(pid, session_uid(1));
+
+    EXPECT_THAT(logind_session_tracker->session_for_pid(pid),
+                StrEq(repowerd::invalid_session_id));
+
+    fake_logind.activate_session(session_id(1));
+    wait_until_active_session_is(session_id(1));
+
+    EXPECT_THAT(logind_session_tracker->session_for_pid(pid),
+                StrEq(session_id(1)));
+
+    expect_pid_session_cache_stats(0, 2);
+}
+
+TEST_F(ALogindSessionTracker, invalidates_cached_sessions_when_session_is_removed)
+{
+    set_pid_start_time(session_pid(0), 10);
+
+    EXPECT_THAT(logind_session_tracker->session_for_pid(session_pid(0)),
+                StrEq(session_id(0)));
+
+    fake_logind.remove_session(session_id(0));
+    wait_until_removed_sessions_are({session_id(0)});
+
+    logind_session_tracker->session_for_pid(session_pid(0));
+
+    expect_pid_session_cache_stats(0, 2);
+}
@@ -23,6 +23,7 @@
 #include "spin_wait.h"
 
 #include "src/adapters/logind_system_power_control.h"
+#include "src/core/suspend_metrics.h"
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
@@ -42,6 +43,7 @@ struct ALogindSystemPowerControl : testing::Test
     rt::DBusBus bus;
     rt::FakeLog fake_log;
     rt::FakeLogind fake_logind{bus.address()};
+    repowerd::SuspendMetrics suspend_metrics;
     std::unique_ptr<repowerd::LogindSystemPowerControl> system_power_control;
 
     ALogindSystemPowerControl()
@@ -58,7 +60,10 @@ struct ALogindSystemPowerControl : testing::Test
 
         system_power_control =
             std::make_unique<repowerd::LogindSystemPowerControl>(
-                rt::fake_shared(fake_log), bus.address());
+                rt::fake_shared(fake_log),
+                rt::fake_shared(suspend_metrics),
+                std::make_shared<repowerd::DBusConnectionHandle>(bus.address()),
+                nullptr);
 
         registrations.push_back(
             system_power_control->register_system_allow_suspend_handler(
@@ -201,6 +206,29 @@ TEST_F(ALogindSystemPowerControl, notifies_of_system_resume)
     EXPECT_TRUE(fake_log.contains_line({"PrepareForSleep", "false"}));
 }
 
+TEST_F(ALogindSystemPowerControl, records_suspend_cycle_from_prepare_for_sleep)
+{
+    std::atomic<bool> system_resume{false};
+
+    auto const system_resume_registration =
+        system_power_control->register_system_resume_handler(
+            [&] { system_resume = true; });
+
+    system_power_control->suspend();
+    fake_logind.emit_prepare_for_sleep(true);
+    fake_logind.emit_prepare_for_sleep(false);
+
+    rt::spin_wait_for_condition_or_timeout(
+        [&] { return system_resume.load(); },
+        default_timeout);
+
+    auto const cycles = suspend_metrics.recent_cycles();
+    ASSERT_THAT(cycles.size(), Eq(1u));
+    EXPECT_THAT(cycles[0].decision_to_suspend_usec,
+                Ne(repowerd::SuspendMetrics::not_observed));
+    EXPECT_TRUE(fake_log.contains_line({"PrepareForSleep", "true"}));
+}
+
 TEST_F(ALogindSystemPowerControl, notifies_of_system_allow_suspend_at_startup)
 {
     auto const block_inhibited = "shutdown:handle-power-key";
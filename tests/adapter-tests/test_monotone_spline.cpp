@@ -104,3 +104,46 @@ TEST_F(AMonotoneSpline, with_fewer_than_two_point_cannot_be_created)
         repowerd::MonotoneSpline({{1,1}});
     }, std::logic_error);
 }
+
+TEST_F(AMonotoneSpline, interpolates_many_values_at_once)
+{
+    std::vector<double> xs;
+    for (auto x = 0.0; x < 1.0; x += 0.01)
+        xs.push_back(x);
+
+    auto const ys = spline.interpolate(xs);
+
+    ASSERT_THAT(ys.size(), Eq(xs.size()));
+    for (auto i = 0u; i < xs.size(); ++i)
+        EXPECT_THAT(ys[i], Eq(spline.interpolate(xs[i])));
+}
+
+TEST_F(AMonotoneSpline, returns_same_values_with_lookup_table)
+{
+    std::vector<repowerd::MonotoneSpline::Point> const integer_points{
+        {0, 10}, {5, 20}, {30, 60}, {100, 70}, {400, 255}};
+
+    repowerd::MonotoneSpline const spline{integer_points};
+    repowerd::MonotoneSpline spline_with_table{integer_points};
+    spline_with_table.build_lookup_table(1000);
+
+    EXPECT_THAT(spline_with_table.lookup_table_size(), Eq(401u));
+
+    for (auto x = -10.0; x < 410.0; x += 0.25)
+        EXPECT_THAT(spline_with_table.interpolate(x), Eq(spline.interpolate(x)));
+}
+
+TEST_F(AMonotoneSpline, limits_lookup_table_size)
+{
+    std::vector<repowerd::MonotoneSpline::Point> const integer_points{
+        {0, 10}, {5, 20}, {30, 60}, {100, 70}, {400, 255}};
+
+    repowerd::MonotoneSpline const spline{integer_points};
+    repowerd::MonotoneSpline spline_with_table{integer_points};
+    spline_with_table.build_lookup_table(50);
+
+    EXPECT_THAT(spline_with_table.lookup_table_size(), Eq(50u));
+
+    for (auto x = 0.0; x < 400.0; x += 1.0)
+        EXPECT_THAT(spline_with_table.interpolate(x), Eq(spline.interpolate(x)));
+}
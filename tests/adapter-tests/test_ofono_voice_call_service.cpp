@@ -98,7 +98,8 @@ struct AnOfonoVoiceCallService : testing::Test
     rt::FakeLog fake_log;
     repowerd::OfonoVoiceCallService ofono_voice_call_service{
         rt::fake_shared(fake_log),
-        bus.address()};
+        std::make_shared<repowerd::DBusConnectionHandle>(bus.address()),
+        nullptr};
     rt::FakeOfono ofono{bus.address()};
 
     std::vector<repowerd::HandlerRegistration> registrations;
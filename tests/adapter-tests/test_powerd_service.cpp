@@ -220,7 +220,8 @@ struct APowerdService : testing::Test
         rt::fake_shared(fake_log),
         rt::fake_shared(mock_temporary_suspend_inhibition),
         fake_device_config,
-        bus.address()};
+        std::make_shared<repowerd::DBusConnectionHandle>(bus.address()),
+        nullptr};
     PowerdDBusClient client{bus.address()};
     std::vector<repowerd::HandlerRegistration> registrations;
 };
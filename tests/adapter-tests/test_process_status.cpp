@@ -0,0 +1,63 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "src/adapters/process_status.h"
+
+#include "fake_filesystem.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace testing;
+namespace rt = repowerd::test;
+
+namespace
+{
+
+struct AProcessStatus : Test
+{
+    rt::FakeFilesystem fake_fs;
+};
+
+}
+
+TEST_F(AProcessStatus, reads_thread_count_and_rss)
+{
+    fake_fs.add_file_with_contents(
+        "/proc/self/status",
+        "Name:\trepowerd\n"
+        "VmPeak:\t  123456 kB\n"
+        "VmRSS:\t    4321 kB\n"
+        "Threads:\t3\n"
+        "SigQ:\t0/31335\n");
+
+    auto const status = repowerd::current_process_status(fake_fs);
+
+    EXPECT_THAT(status.num_threads, Eq(3u));
+    EXPECT_THAT(status.rss_kb, Eq(4321u));
+}
+
+TEST_F(AProcessStatus, reports_missing_fields_as_zero)
+{
+    fake_fs.add_file_with_contents("/proc/self/status", "Name:\trepowerd\n");
+
+    auto const status = repowerd::current_process_status(fake_fs);
+
+    EXPECT_THAT(status.num_threads, Eq(0u));
+    EXPECT_THAT(status.rss_kb, Eq(0u));
+}
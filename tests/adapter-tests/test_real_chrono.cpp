@@ -46,3 +46,13 @@ TEST_F(ARealChrono, sleeps_for_right_amount_of_time)
 {
     EXPECT_THAT(rt::duration_of([&]{real_chrono.sleep_for(50ms);}), IsAbout(50ms));
 }
+
+TEST_F(ARealChrono, steady_now_follows_steady_clock)
+{
+    auto const before = std::chrono::steady_clock::now();
+    auto const now = real_chrono.steady_now();
+    auto const after = std::chrono::steady_clock::now();
+
+    EXPECT_THAT(now, Ge(before));
+    EXPECT_THAT(now, Le(after));
+}
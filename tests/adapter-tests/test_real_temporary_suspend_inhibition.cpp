@@ -19,6 +19,7 @@
 #include "src/adapters/real_temporary_suspend_inhibition.h"
 
 #include "duration_of.h"
+#include "fake_log.h"
 #include "fake_shared.h"
 #include "fake_system_power_control.h"
 #include "spin_wait.h"
@@ -26,6 +27,8 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <thread>
+
 namespace rt = repowerd::test;
 
 using namespace testing;
@@ -37,8 +40,11 @@ namespace
 struct ARealTemporarySuspendInhibition : Test
 {
     rt::FakeSystemPowerControl fake_system_power_control;
+    rt::FakeLog fake_log;
     repowerd::RealTemporarySuspendInhibition real_temporary_suspend_inhbition{
-        rt::fake_shared(fake_system_power_control)};
+        rt::fake_shared(fake_system_power_control),
+        rt::fake_shared(fake_log),
+        nullptr};
 
     bool is_automatic_suspend_allowed()
     {
@@ -88,3 +94,58 @@ TEST_F(ARealTemporarySuspendInhibition, handles_concurrent_suspend_inhibitions)
         }),
         IsAbout(100ms));
 }
+
+TEST_F(ARealTemporarySuspendInhibition, extends_deadline_of_active_inhibition)
+{
+    EXPECT_THAT(rt::duration_of(
+        [this]
+        {
+            real_temporary_suspend_inhbition.inhibit_suspend_for(50ms, "bla");
+            std::this_thread::sleep_for(30ms);
+            real_temporary_suspend_inhbition.inhibit_suspend_for(50ms, "bla");
+
+            rt::spin_wait_for_condition_or_timeout(
+                [this] { return is_automatic_suspend_allowed(); },
+                3s);
+        }),
+        IsAbout(80ms));
+}
+
+TEST_F(ARealTemporarySuspendInhibition, aggregates_inhibitions_into_single_disallowance)
+{
+    EXPECT_CALL(fake_system_power_control.mock, disallow_automatic_suspend(_)).Times(1);
+    EXPECT_CALL(fake_system_power_control.mock, allow_automatic_suspend(_)).Times(1);
+
+    real_temporary_suspend_inhbition.inhibit_suspend_for(50ms, "bla");
+    real_temporary_suspend_inhbition.inhibit_suspend_for(30ms, "bla1");
+    real_temporary_suspend_inhbition.inhibit_suspend_for(50ms, "bla");
+
+    rt::spin_wait_for_condition_or_timeout(
+        [this] { return is_automatic_suspend_allowed(); },
+        3s);
+}
+
+TEST_F(ARealTemporarySuspendInhibition, inhibits_again_after_previous_inhibition_expires)
+{
+    real_temporary_suspend_inhbition.inhibit_suspend_for(10ms, "bla");
+    rt::spin_wait_for_condition_or_timeout(
+        [this] { return fake_log.contains_line({"releasing"}); },
+        3s);
+
+    real_temporary_suspend_inhbition.inhibit_suspend_for(100s, "bla");
+
+    EXPECT_FALSE(is_automatic_suspend_allowed());
+}
+
+TEST_F(ARealTemporarySuspendInhibition, logs_requests_per_reason_on_release)
+{
+    real_temporary_suspend_inhbition.inhibit_suspend_for(10ms, "bla");
+    real_temporary_suspend_inhbition.inhibit_suspend_for(10ms, "bla");
+    real_temporary_suspend_inhbition.inhibit_suspend_for(10ms, "bla1");
+
+    rt::spin_wait_for_condition_or_timeout(
+        [this] { return fake_log.contains_line({"releasing"}); },
+        3s);
+
+    EXPECT_TRUE(fake_log.contains_line({"releasing", "bla(2 requests", "bla1(1 requests"}));
+}
@@ -16,7 +16,10 @@
  * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
  */
 
+#include "src/adapters/dbus_message_handle.h"
 #include "src/adapters/repowerd_service.h"
+#include "src/core/dispatch_metrics.h"
+#include "src/core/suspend_metrics.h"
 #include "src/core/infinite_timeout.h"
 
 #include "dbus_bus.h"
@@ -99,9 +102,14 @@ struct ARepowerdService : testing::Test
 
     rt::DBusBus bus;
     rt::FakeLog fake_log;
+    repowerd::DispatchMetrics dispatch_metrics;
+    repowerd::SuspendMetrics suspend_metrics;
     repowerd::RepowerdService service{
+        rt::fake_shared(dispatch_metrics),
+        rt::fake_shared(suspend_metrics),
         rt::fake_shared(fake_log),
-        bus.address()};
+        std::make_shared<repowerd::DBusConnectionHandle>(bus.address()),
+        nullptr};
     rt::RepowerdDBusClient client{bus.address()};
     std::vector<repowerd::HandlerRegistration> registrations;
 
@@ -379,3 +387,95 @@ TEST_F(ARepowerdService, logs_set_critical_power_behavior_request)
             fake_log.contains_line({"SetCriticalPowerBehavior", action_arg.str}));
     }
 }
+
+TEST_F(ARepowerdService, replies_to_dispatch_metrics_request)
+{
+    using namespace std::chrono;
+
+    dispatch_metrics.record_dispatch(
+        repowerd::DispatchEventKind::lid, 1ms, 1ms, 3);
+    dispatch_metrics.record_queue_counters(2, 5);
+
+    auto reply = client.request_dispatch_metrics().get();
+    auto const body = g_dbus_message_get_body(reply);
+
+    GVariant* latency_limits;
+    GVariantIter* event_latencies;
+    GVariant* depth_limits;
+    GVariant* depth_histogram;
+    guint64 max_queue_depth;
+    guint64 queue_overflows;
+    guint64 coalesced_events;
+
+    g_variant_get(
+        body, "(@ata(statat)@at@atttt)",
+        &latency_limits, &event_latencies, &depth_limits, &depth_histogram,
+        &max_queue_depth, &queue_overflows, &coalesced_events);
+
+    char const* kind_name;
+    guint64 count;
+    GVariant* queue_wait;
+    GVariant* handling;
+    guint64 lid_count = 0;
+    size_t num_kinds = 0;
+
+    while (g_variant_iter_loop(event_latencies, "(&st@at@at)",
+                               &kind_name, &count, &queue_wait, &handling))
+    {
+        if (std::string{kind_name} == "lid")
+            lid_count = count;
+        ++num_kinds;
+    }
+
+    EXPECT_THAT(g_variant_n_children(latency_limits),
+                Eq(repowerd::DispatchMetrics::num_latency_buckets));
+    EXPECT_THAT(g_variant_n_children(depth_histogram),
+                Eq(repowerd::DispatchMetrics::num_depth_buckets));
+    EXPECT_THAT(num_kinds, Eq(repowerd::num_dispatch_event_kinds));
+    EXPECT_THAT(lid_count, Eq(1u));
+    EXPECT_THAT(max_queue_depth, Eq(3u));
+    EXPECT_THAT(queue_overflows, Eq(2u));
+    EXPECT_THAT(coalesced_events, Eq(5u));
+
+    g_variant_iter_free(event_latencies);
+    g_variant_unref(latency_limits);
+    g_variant_unref(depth_limits);
+    g_variant_unref(depth_histogram);
+}
+
+TEST_F(ARepowerdService, replies_to_suspend_metrics_request)
+{
+    using namespace std::chrono;
+
+    repowerd::SuspendMetrics::TimePoint const start{};
+
+    suspend_metrics.record_suspend_decision(start);
+    suspend_metrics.record_suspend_entry(start + 10ms);
+    suspend_metrics.record_resume(start + 20ms);
+    suspend_metrics.record_first_event_after_resume(start + 22ms);
+
+    auto reply = client.request_suspend_metrics().get();
+    auto const body = g_dbus_message_get_body(reply);
+
+    guint64 total_cycles;
+    GVariantIter* cycles;
+
+    g_variant_get(body, "(ta(ttt))", &total_cycles, &cycles);
+
+    ASSERT_THAT(g_variant_iter_n_children(cycles), Eq(1u));
+
+    guint64 decision_to_suspend;
+    guint64 resume_to_first_event;
+    guint64 resume_to_display_on;
+
+    g_variant_iter_next(
+        cycles, "(ttt)",
+        &decision_to_suspend, &resume_to_first_event, &resume_to_display_on);
+
+    EXPECT_THAT(total_cycles, Eq(1u));
+    EXPECT_THAT(decision_to_suspend, Eq(10000u));
+    EXPECT_THAT(resume_to_first_event, Eq(2000u));
+    EXPECT_THAT(resume_to_display_on, Eq(repowerd::SuspendMetrics::not_observed));
+
+    g_variant_iter_free(cycles);
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "src/adapters/simulated_clock.h"
+#include "src/adapters/event_loop.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <vector>
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+struct ASimulatedClock : Test
+{
+    std::shared_ptr<repowerd::SimulatedClock> const clock{
+        std::make_shared<repowerd::SimulatedClock>()};
+    std::chrono::steady_clock::time_point const start{clock->steady_now()};
+    repowerd::EventLoop event_loop{"SimulatedClock", nullptr, clock};
+};
+
+}
+
+TEST_F(ASimulatedClock, advances_only_when_told_to)
+{
+    EXPECT_THAT(clock->steady_now(), Eq(start));
+
+    clock->advance_to(start + 5s);
+    EXPECT_THAT(clock->steady_now(), Eq(start + 5s));
+
+    clock->sleep_for(10ms);
+    EXPECT_THAT(clock->steady_now(), Eq(start + 5s + 10ms));
+}
+
+TEST_F(ASimulatedClock, runs_event_loop_timeouts_at_their_due_time)
+{
+    std::vector<std::chrono::steady_clock::time_point> run_times;
+
+    event_loop.schedule_in(200ms, [&] { run_times.push_back(clock->steady_now()); });
+    event_loop.schedule_in(100ms, [&] { run_times.push_back(clock->steady_now()); });
+
+    clock->advance_to(start + 99ms);
+    EXPECT_THAT(run_times, IsEmpty());
+
+    clock->advance_to(start + 1s);
+    EXPECT_THAT(run_times, ElementsAre(start + 100ms, start + 200ms));
+    EXPECT_THAT(clock->steady_now(), Eq(start + 1s));
+}
+
+TEST_F(ASimulatedClock, runs_timeouts_scheduled_by_timeouts)
+{
+    int count = 0;
+    std::function<void()> tick =
+        [&]
+        {
+            if (++count < 10)
+                event_loop.schedule_in(1s, tick);
+        };
+
+    event_loop.schedule_in(1s, tick);
+
+    clock->advance_to(start + 1h);
+
+    EXPECT_THAT(count, Eq(10));
+}
+
+TEST_F(ASimulatedClock, does_not_run_cancelled_timeouts)
+{
+    bool called = false;
+    repowerd::EventLoopCancellation cancellation;
+
+    event_loop.schedule_with_cancellation_in(
+        100ms,
+        [&] { called = true; },
+        [&] (auto const& c) { cancellation = c; });
+
+    clock->run_pending();
+    ASSERT_TRUE(static_cast<bool>(cancellation));
+    cancellation();
+
+    clock->advance_to(start + 1s);
+
+    EXPECT_FALSE(called);
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "src/adapters/suspend_pipeline.h"
+
+#include "fake_chrono.h"
+#include "fake_log.h"
+#include "fake_shared.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace rt = repowerd::test;
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+struct ASuspendPipeline : Test
+{
+    std::chrono::milliseconds const stage_deadline{200};
+    rt::FakeChrono fake_chrono;
+    rt::FakeLog fake_log;
+    repowerd::SuspendPipeline suspend_pipeline{
+        rt::fake_shared(fake_chrono),
+        rt::fake_shared(fake_log),
+        stage_deadline};
+};
+
+}
+
+TEST_F(ASuspendPipeline, has_no_stages_in_progress_if_no_stages_have_started)
+{
+    EXPECT_FALSE(suspend_pipeline.has_stages_in_progress());
+}
+
+TEST_F(ASuspendPipeline, has_no_stages_in_progress_once_started_stages_complete)
+{
+    suspend_pipeline.start_stage(repowerd::SuspendStage::backlight_off);
+    suspend_pipeline.start_stage(repowerd::SuspendStage::panel_off);
+
+    suspend_pipeline.complete_stage(repowerd::SuspendStage::backlight_off);
+    EXPECT_TRUE(suspend_pipeline.has_stages_in_progress());
+
+    suspend_pipeline.complete_stage(repowerd::SuspendStage::panel_off);
+    EXPECT_FALSE(suspend_pipeline.has_stages_in_progress());
+}
+
+TEST_F(ASuspendPipeline, stops_counting_stage_as_in_progress_at_its_deadline)
+{
+    suspend_pipeline.start_stage(repowerd::SuspendStage::panel_off);
+
+    fake_chrono.sleep_for(stage_deadline - 1ms);
+    EXPECT_TRUE(suspend_pipeline.has_stages_in_progress());
+    EXPECT_FALSE(fake_log.contains_line({"panel_off", "missed", "deadline"}));
+
+    fake_chrono.sleep_for(1ms);
+    EXPECT_FALSE(suspend_pipeline.has_stages_in_progress());
+    EXPECT_TRUE(fake_log.contains_line({"panel_off", "missed", "deadline"}));
+}
+
+TEST_F(ASuspendPipeline, reports_time_until_earliest_deadline_of_stages_in_progress)
+{
+    suspend_pipeline.start_stage(repowerd::SuspendStage::backlight_off);
+    fake_chrono.sleep_for(50ms);
+    suspend_pipeline.start_stage(repowerd::SuspendStage::panel_off);
+
+    EXPECT_THAT(
+        suspend_pipeline.time_until_next_deadline(),
+        Eq(stage_deadline - 50ms));
+
+    suspend_pipeline.complete_stage(repowerd::SuspendStage::backlight_off);
+
+    EXPECT_THAT(
+        suspend_pipeline.time_until_next_deadline(),
+        Eq(stage_deadline));
+}
+
+TEST_F(ASuspendPipeline, rounds_time_until_deadline_up_to_whole_milliseconds)
+{
+    suspend_pipeline.start_stage(repowerd::SuspendStage::backlight_off);
+    fake_chrono.sleep_for(50500us);
+
+    EXPECT_THAT(
+        suspend_pipeline.time_until_next_deadline(),
+        Eq(stage_deadline - 50ms));
+    EXPECT_THAT(
+        suspend_pipeline.time_until_deadline(repowerd::SuspendStage::backlight_off),
+        Eq(stage_deadline - 50ms));
+}
+
+TEST_F(ASuspendPipeline, reports_stage_in_progress_until_it_completes_or_reaches_its_deadline)
+{
+    EXPECT_FALSE(suspend_pipeline.is_stage_in_progress(repowerd::SuspendStage::backlight_off));
+
+    suspend_pipeline.start_stage(repowerd::SuspendStage::backlight_off);
+    suspend_pipeline.start_stage(repowerd::SuspendStage::panel_off);
+    EXPECT_TRUE(suspend_pipeline.is_stage_in_progress(repowerd::SuspendStage::backlight_off));
+    EXPECT_THAT(
+        suspend_pipeline.time_until_deadline(repowerd::SuspendStage::backlight_off),
+        Eq(stage_deadline));
+
+    suspend_pipeline.complete_stage(repowerd::SuspendStage::backlight_off);
+    EXPECT_FALSE(suspend_pipeline.is_stage_in_progress(repowerd::SuspendStage::backlight_off));
+    EXPECT_THAT(
+        suspend_pipeline.time_until_deadline(repowerd::SuspendStage::backlight_off),
+        Eq(0ms));
+
+    fake_chrono.sleep_for(stage_deadline);
+    EXPECT_FALSE(suspend_pipeline.is_stage_in_progress(repowerd::SuspendStage::panel_off));
+}
+
+TEST_F(ASuspendPipeline, calls_stage_completed_handlers_when_started_stage_completes)
+{
+    int num_calls = 0;
+    auto const registration = suspend_pipeline.register_stage_completed_handler(
+        [&] { ++num_calls; });
+
+    suspend_pipeline.complete_stage(repowerd::SuspendStage::panel_off);
+    EXPECT_THAT(num_calls, Eq(0));
+
+    suspend_pipeline.start_stage(repowerd::SuspendStage::panel_off);
+    suspend_pipeline.complete_stage(repowerd::SuspendStage::panel_off);
+    suspend_pipeline.complete_stage(repowerd::SuspendStage::panel_off);
+    EXPECT_THAT(num_calls, Eq(1));
+}
+
+TEST_F(ASuspendPipeline, does_not_call_unregistered_stage_completed_handlers)
+{
+    int num_calls = 0;
+    {
+        auto const registration = suspend_pipeline.register_stage_completed_handler(
+            [&] { ++num_calls; });
+    }
+
+    suspend_pipeline.start_stage(repowerd::SuspendStage::panel_off);
+    suspend_pipeline.complete_stage(repowerd::SuspendStage::panel_off);
+
+    EXPECT_THAT(num_calls, Eq(0));
+}
+
+TEST_F(ASuspendPipeline, logs_stages_that_complete_late)
+{
+    suspend_pipeline.start_stage(repowerd::SuspendStage::interactive_mode_disabled);
+    fake_chrono.sleep_for(stage_deadline + 10ms);
+    suspend_pipeline.complete_stage(repowerd::SuspendStage::interactive_mode_disabled);
+
+    EXPECT_TRUE(fake_log.contains_line({"interactive_mode_disabled", "late"}));
+}
@@ -241,3 +241,48 @@ TEST_F(ASysfsBacklight, uses_raw_backlight_if_no_other_choice)
 
     EXPECT_THAT(raw->brightness_contents->size(), Gt(1));
 }
+
+TEST_F(ASysfsBacklight, elides_writes_of_unchanged_absolute_brightness)
+{
+    set_up_sysfs_backlight();
+
+    auto const backlight = create_sysfs_backlight();
+    auto const prev_contents_size = sysfs_backlight->brightness_contents->size();
+
+    backlight->set_brightness(0.5);
+    backlight->set_brightness(0.501);
+
+    EXPECT_THAT(sysfs_backlight->brightness_contents->size(), Eq(prev_contents_size + 1));
+    EXPECT_THAT(backlight->num_issued_writes(), Eq(1u));
+    EXPECT_THAT(backlight->num_elided_writes(), Eq(1u));
+}
+
+TEST_F(ASysfsBacklight, elides_most_transition_steps_with_small_max_brightness)
+{
+    auto const small_backlight =
+        std::make_unique<FakeSysfsBacklight>(fake_fs, "firmware", 10);
+
+    auto const backlight = create_sysfs_backlight();
+
+    for (int i = 0; i <= 100; ++i)
+        backlight->set_brightness(i * 0.01);
+
+    EXPECT_THAT(backlight->num_issued_writes(), Eq(11u));
+    EXPECT_THAT(backlight->num_elided_writes(), Eq(90u));
+    EXPECT_THAT(small_backlight->brightness_contents->back(), StrEq("10"));
+}
+
+TEST_F(ASysfsBacklight, does_not_elide_write_after_brightness_changed_externally)
+{
+    set_up_sysfs_backlight();
+
+    auto const backlight = create_sysfs_backlight();
+    backlight->set_brightness(0.7);
+
+    sysfs_backlight->brightness_contents->push_back("102");
+    backlight->get_brightness();
+    backlight->set_brightness(0.7);
+
+    expect_brightness_value(round(max_brightness * 0.7));
+    EXPECT_THAT(backlight->num_issued_writes(), Eq(2u));
+}
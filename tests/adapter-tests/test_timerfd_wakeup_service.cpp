@@ -97,7 +97,7 @@ struct ATimerfdWakeupService : Test
     }
 
     rt::FakeLog fake_log;
-    repowerd::TimerfdWakeupService wakeup_service{rt::fake_shared(fake_log),};
+    repowerd::TimerfdWakeupService wakeup_service{rt::fake_shared(fake_log), nullptr};
     std::mutex wakeup_mutex;
     std::condition_variable wakeup_cv;
     std::vector<std::string> wakeup_cookies;
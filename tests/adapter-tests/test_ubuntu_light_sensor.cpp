@@ -46,7 +46,7 @@ struct AUbuntuLightSensor : testing::Test
         rt::TemporaryEnvironmentValue test_file{"UBUNTU_PLATFORM_API_SENSOR_TEST", command_file.name().c_str()};
         command_file.write(script);
 
-        sensor = std::make_unique<repowerd::UbuntuLightSensor>();
+        sensor = std::make_unique<repowerd::UbuntuLightSensor>(nullptr);
         registration = sensor->register_light_handler(
             [this](double light) { mock_handlers.light_handler(light); });
     }
@@ -86,3 +86,52 @@ TEST_F(AUbuntuLightSensor, reports_light_events)
         EXPECT_TRUE(handler_called.woken());
     });
 }
+
+TEST_F(AUbuntuLightSensor, batches_light_events_at_low_rate)
+{
+    TEST_IN_SEPARATE_PROCESS({
+        rt::WaitCondition handler_called;
+
+        EXPECT_CALL(mock_handlers, light_handler(10)).Times(0);
+        EXPECT_CALL(mock_handlers, light_handler(30))
+            .WillOnce(WakeUp(&handler_called));
+
+        set_up_sensor(
+            "create light 0 100 1\n"
+            "500 light 10\n"
+            "50 light 30\n");
+
+        sensor->set_light_event_rate(repowerd::LightEventRate::low);
+        sensor->enable_light_events();
+
+        handler_called.wait_for(2 * default_timeout);
+        EXPECT_TRUE(handler_called.woken());
+    });
+}
+
+TEST_F(AUbuntuLightSensor, reports_light_events_directly_on_event_loop)
+{
+    TEST_IN_SEPARATE_PROCESS({
+        rt::WaitCondition handler_called;
+        repowerd::EventLoop direct_event_loop{"direct"};
+
+        EXPECT_CALL(mock_handlers, light_handler(_)).Times(0);
+
+        set_up_sensor(
+            "create light 0 100 1\n"
+            "500 light 10\n");
+
+        auto const direct_registration = sensor->register_direct_light_handler(
+            direct_event_loop,
+            [&] (double light)
+            {
+                if (light == 10)
+                    handler_called.wake_up();
+            });
+
+        sensor->enable_light_events();
+
+        handler_called.wait_for(default_timeout);
+        EXPECT_TRUE(handler_called.woken());
+    });
+}
@@ -48,7 +48,7 @@ struct AUbuntuProximitySensor : testing::Test
         command_file.write(script);
 
         sensor = std::make_unique<repowerd::UbuntuProximitySensor>(
-            rt::fake_shared(fake_log), fake_device_quirks);
+            rt::fake_shared(fake_log), fake_device_quirks, nullptr);
         registration = sensor->register_proximity_handler(
             [this](repowerd::ProximityState state) { mock_handlers.proximity_handler(state); });
     }
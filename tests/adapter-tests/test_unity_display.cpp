@@ -21,8 +21,12 @@
 #include "src/adapters/dbus_connection_handle.h"
 #include "src/adapters/dbus_event_loop.h"
 #include "src/adapters/unity_display.h"
+#include "src/adapters/suspend_pipeline.h"
+#include "src/adapters/wake_pipeline.h"
+#include "src/core/suspend_metrics.h"
 
 #include "duration_of.h"
+#include "fake_chrono.h"
 #include "fake_log.h"
 #include "fake_shared.h"
 #include "spin_wait.h"
@@ -31,6 +35,7 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <atomic>
 #include <chrono>
 
 namespace rt = repowerd::test;
@@ -167,10 +172,25 @@ struct AUnityDisplay : testing::Test
 
     rt::DBusBus bus;
     rt::FakeLog fake_log;
+    rt::FakeChrono fake_chrono;
+    std::chrono::milliseconds const stage_deadline{300};
+    repowerd::WakePipeline wake_pipeline{
+        rt::fake_shared(fake_chrono),
+        rt::fake_shared(fake_log),
+        stage_deadline};
+    repowerd::SuspendPipeline suspend_pipeline{
+        rt::fake_shared(fake_chrono),
+        rt::fake_shared(fake_log),
+        stage_deadline};
+    repowerd::SuspendMetrics suspend_metrics;
     FakeUnityDisplayDBusService service{bus.address()};
     repowerd::UnityDisplay unity_display{
         rt::fake_shared(fake_log),
-        bus.address()};
+        rt::fake_shared(wake_pipeline),
+        rt::fake_shared(suspend_pipeline),
+        rt::fake_shared(suspend_metrics),
+        std::make_shared<repowerd::DBusConnectionHandle>(bus.address()),
+        nullptr};
 
     std::chrono::seconds const default_timeout{3};
 };
@@ -230,7 +250,11 @@ TEST_F(AUnityDisplay, queries_initial_display_information)
 
     repowerd::UnityDisplay local_unity_display{
         rt::fake_shared(fake_log),
-        bus.address()};
+        rt::fake_shared(wake_pipeline),
+        rt::fake_shared(suspend_pipeline),
+        rt::fake_shared(suspend_metrics),
+        std::make_shared<repowerd::DBusConnectionHandle>(bus.address()),
+        nullptr};
 
     wait_for_have_external(local_unity_display, true);
 }
@@ -242,18 +266,188 @@ TEST_F(AUnityDisplay,
 
     repowerd::UnityDisplay local_unity_display{
         rt::fake_shared(fake_log),
-        empty_bus.address()};
+        rt::fake_shared(wake_pipeline),
+        rt::fake_shared(suspend_pipeline),
+        rt::fake_shared(suspend_metrics),
+        std::make_shared<repowerd::DBusConnectionHandle>(empty_bus.address()),
+        nullptr};
 }
 
-TEST_F(AUnityDisplay, waits_at_most_one_second_for_turn_on_response)
+TEST_F(AUnityDisplay, does_not_wait_for_turn_on_response)
 {
     EXPECT_CALL(service.mock_dbus_calls, turn_on("all"))
-        .WillOnce(InvokeWithoutArgs([]{ std::this_thread::sleep_for(1200ms); }));
+        .WillOnce(InvokeWithoutArgs([]{ std::this_thread::sleep_for(500ms); }));
 
     EXPECT_THAT(
         rt::duration_of(
             [this] { unity_display.turn_on(repowerd::DisplayPowerControlFilter::all); }),
-        AllOf(Ge(1000ms), Le(1100ms)));
+        Le(100ms));
+}
+
+TEST_F(AUnityDisplay, times_out_turn_on_request_after_one_second)
+{
+    EXPECT_CALL(service.mock_dbus_calls, turn_on("all"))
+        .WillOnce(InvokeWithoutArgs([]{ std::this_thread::sleep_for(1200ms); }));
+
+    auto const start = std::chrono::steady_clock::now();
+
+    unity_display.turn_on(repowerd::DisplayPowerControlFilter::all);
+
+    auto const result = rt::spin_wait_for_condition_or_timeout(
+        [this] { return fake_log.contains_line({"turn_on", "all", "failed"}); },
+        default_timeout);
+    auto const duration = std::chrono::steady_clock::now() - start;
+
+    EXPECT_TRUE(result);
+    EXPECT_THAT(duration, AllOf(Ge(1000ms), Le(1150ms)));
+}
+
+TEST_F(AUnityDisplay, sends_requests_made_while_call_is_in_flight_in_order)
+{
+    rt::WaitCondition called;
+
+    InSequence s;
+    EXPECT_CALL(service.mock_dbus_calls, turn_on("all"))
+        .WillOnce(InvokeWithoutArgs([]{ std::this_thread::sleep_for(200ms); }));
+    EXPECT_CALL(service.mock_dbus_calls, turn_off("internal"));
+    EXPECT_CALL(service.mock_dbus_calls, turn_on("external"))
+        .WillOnce(WakeUp(&called));
+
+    unity_display.turn_on(repowerd::DisplayPowerControlFilter::all);
+    unity_display.turn_off(repowerd::DisplayPowerControlFilter::internal);
+    unity_display.turn_on(repowerd::DisplayPowerControlFilter::external);
+
+    called.wait_for(default_timeout);
+    EXPECT_TRUE(called.woken());
+}
+
+TEST_F(AUnityDisplay, collapses_requests_made_while_call_is_in_flight)
+{
+    rt::WaitCondition called;
+
+    InSequence s;
+    EXPECT_CALL(service.mock_dbus_calls, turn_on("all"))
+        .WillOnce(InvokeWithoutArgs([]{ std::this_thread::sleep_for(200ms); }));
+    EXPECT_CALL(service.mock_dbus_calls, turn_off("internal"))
+        .WillOnce(WakeUp(&called));
+
+    unity_display.turn_on(repowerd::DisplayPowerControlFilter::all);
+    unity_display.turn_off(repowerd::DisplayPowerControlFilter::all);
+    unity_display.turn_on(repowerd::DisplayPowerControlFilter::all);
+    unity_display.turn_off(repowerd::DisplayPowerControlFilter::internal);
+
+    called.wait_for(default_timeout);
+    EXPECT_TRUE(called.woken());
+}
+
+TEST_F(AUnityDisplay, completes_panel_on_wake_stage_when_turn_on_call_completes)
+{
+    rt::WaitCondition panel_on;
+    auto const registration = wake_pipeline.register_stage_handler(
+        repowerd::WakeStage::panel_on, [&] { panel_on.wake_up(); });
+
+    unity_display.turn_on(repowerd::DisplayPowerControlFilter::all);
+
+    EXPECT_TRUE(wake_pipeline.is_stage_pending(repowerd::WakeStage::panel_on));
+
+    panel_on.wait_for(default_timeout);
+    EXPECT_TRUE(panel_on.woken());
+}
+
+TEST_F(AUnityDisplay, keeps_panel_on_wake_stage_pending_until_turn_on_call_completes)
+{
+    rt::WaitCondition turn_on_called;
+    rt::WaitCondition turn_on_released;
+
+    EXPECT_CALL(service.mock_dbus_calls, turn_on("all"))
+        .WillOnce(InvokeWithoutArgs(
+            [&]
+            {
+                turn_on_called.wake_up();
+                turn_on_released.wait_for(default_timeout);
+            }));
+
+    unity_display.turn_on(repowerd::DisplayPowerControlFilter::all);
+
+    turn_on_called.wait_for(default_timeout);
+    EXPECT_TRUE(turn_on_called.woken());
+    EXPECT_TRUE(wake_pipeline.is_stage_pending(repowerd::WakeStage::panel_on));
+
+    turn_on_released.wake_up();
+
+    EXPECT_TRUE(
+        rt::spin_wait_for_condition_or_timeout(
+            [this] { return !wake_pipeline.is_stage_pending(repowerd::WakeStage::panel_on); },
+            default_timeout));
+}
+
+TEST_F(AUnityDisplay, does_not_start_a_new_wake_if_display_is_already_on)
+{
+    rt::WaitCondition panel_on;
+    auto const registration = wake_pipeline.register_stage_handler(
+        repowerd::WakeStage::panel_on, [&] { panel_on.wake_up(); });
+
+    unity_display.turn_on(repowerd::DisplayPowerControlFilter::all);
+    panel_on.wait_for(default_timeout);
+
+    unity_display.turn_on(repowerd::DisplayPowerControlFilter::all);
+
+    EXPECT_FALSE(wake_pipeline.is_stage_pending(repowerd::WakeStage::panel_on));
+}
+
+TEST_F(AUnityDisplay, completes_panel_off_suspend_stage_when_turn_off_call_completes)
+{
+    unity_display.turn_on(repowerd::DisplayPowerControlFilter::all);
+    unity_display.turn_off(repowerd::DisplayPowerControlFilter::all);
+
+    EXPECT_TRUE(
+        rt::spin_wait_for_condition_or_timeout(
+            [this] { return !suspend_pipeline.has_stages_in_progress(); },
+            stage_deadline));
+    EXPECT_FALSE(fake_log.contains_line({"panel_off", "missed"}));
+}
+
+TEST_F(AUnityDisplay, turns_panel_off_only_after_backlight_fades_out)
+{
+    rt::WaitCondition called;
+    std::atomic<bool> backlight_off{false};
+
+    EXPECT_CALL(service.mock_dbus_calls, turn_off("all"))
+        .WillOnce(InvokeWithoutArgs(
+            [&]
+            {
+                EXPECT_TRUE(backlight_off);
+                called.wake_up();
+            }));
+
+    suspend_pipeline.start_stage(repowerd::SuspendStage::backlight_off);
+    unity_display.turn_off(repowerd::DisplayPowerControlFilter::all);
+
+    std::this_thread::sleep_for(100ms);
+    backlight_off = true;
+    suspend_pipeline.complete_stage(repowerd::SuspendStage::backlight_off);
+
+    called.wait_for(default_timeout);
+    EXPECT_TRUE(called.woken());
+}
+
+TEST_F(AUnityDisplay, turns_panel_off_anyway_if_backlight_does_not_fade_out_by_deadline)
+{
+    rt::WaitCondition called;
+
+    EXPECT_CALL(service.mock_dbus_calls, turn_off("all"))
+        .WillOnce(WakeUp(&called));
+
+    suspend_pipeline.start_stage(repowerd::SuspendStage::backlight_off);
+    unity_display.turn_off(repowerd::DisplayPowerControlFilter::all);
+
+    called.wait_for(100ms);
+    EXPECT_FALSE(called.woken());
+
+    fake_chrono.sleep_for(stage_deadline);
+
+    called.wait_for(default_timeout);
+    EXPECT_TRUE(called.woken());
 }
 
 TEST_F(AUnityDisplay, logs_turn_on_request)
@@ -269,3 +463,22 @@ TEST_F(AUnityDisplay, logs_turn_off_request)
 
     EXPECT_TRUE(fake_log.contains_line({"turn_off"}));
 }
+
+TEST_F(AUnityDisplay, records_display_on_after_resume_when_turn_on_call_completes)
+{
+    rt::WaitCondition panel_on;
+    auto const registration = wake_pipeline.register_stage_handler(
+        repowerd::WakeStage::panel_on, [&] { panel_on.wake_up(); });
+
+    suspend_metrics.record_resume(std::chrono::steady_clock::now());
+
+    unity_display.turn_on(repowerd::DisplayPowerControlFilter::all);
+
+    panel_on.wait_for(default_timeout);
+    ASSERT_TRUE(panel_on.woken());
+
+    auto const cycles = suspend_metrics.recent_cycles();
+    ASSERT_THAT(cycles.size(), Eq(1u));
+    EXPECT_THAT(cycles[0].resume_to_display_on_usec,
+                Ne(repowerd::SuspendMetrics::not_observed));
+}
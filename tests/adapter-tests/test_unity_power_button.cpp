@@ -96,7 +96,9 @@ struct AUnityPowerButton : testing::Test
     testing::NiceMock<MockHandlers> mock_handlers;
 
     rt::DBusBus bus;
-    repowerd::UnityPowerButton unity_power_button{bus.address()};
+    repowerd::UnityPowerButton unity_power_button{
+        std::make_shared<repowerd::DBusConnectionHandle>(bus.address()),
+        nullptr};
     UnityPowerButtonDBusClient client{bus.address()};
     std::vector<repowerd::HandlerRegistration> registrations;
 
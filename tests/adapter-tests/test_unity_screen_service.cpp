@@ -19,11 +19,16 @@
 #include "dbus_bus.h"
 #include "fake_brightness_notification.h"
 #include "fake_device_config.h"
+#include "fake_device_quirks.h"
+#include "fake_filesystem.h"
 #include "fake_log.h"
+#include "fake_logind.h"
 #include "fake_wakeup_service.h"
 #include "unity_screen_dbus_client.h"
 #include "src/adapters/dbus_connection_handle.h"
 #include "src/adapters/dbus_message_handle.h"
+#include "src/adapters/event_loop_executor.h"
+#include "src/adapters/logind_session_tracker.h"
 #include "src/adapters/temporary_suspend_inhibition.h"
 #include "src/adapters/unity_screen_power_state_change_reason.h"
 #include "src/adapters/unity_screen_service.h"
@@ -37,6 +42,8 @@
 
 #include <chrono>
 
+#include <unistd.h>
+
 using namespace testing;
 
 namespace rt = repowerd::test;
@@ -120,8 +127,63 @@ struct AUnityScreenService : testing::Test
         rt::fake_shared(fake_log),
         rt::fake_shared(null_temporary_suspend_inhibition),
         fake_device_config,
-        bus.address()};
+        std::make_shared<repowerd::DBusConnectionHandle>(bus.address()),
+        nullptr};
+    rt::UnityScreenDBusClient client{bus.address()};
+    std::vector<repowerd::HandlerRegistration> registrations;
+};
+
+// Runs the service on a single shared executor thread, with the session
+// tracker on its own thread, as DefaultDaemonConfig does
+struct AUnityScreenServiceOnSharedExecutor : testing::Test
+{
+    AUnityScreenServiceOnSharedExecutor()
+    {
+        fake_logind.add_session("session0", "mir", getpid(), getuid());
+        fake_logind.activate_session("session0");
+
+        registrations.push_back(
+            service.register_disable_inactivity_timeout_handler(
+                [this] (auto, auto pid)
+                {
+                    session_of_request = session_tracker.session_for_pid(pid);
+                    request_handled.wake_up();
+                }));
+
+        service.start_processing();
+        session_tracker.start_processing();
+    }
+
+    std::chrono::seconds const default_timeout{3};
+
+    rt::DBusBus bus;
+    rt::FakeBrightnessNotification fake_brightness_notification;
+    rt::FakeDeviceConfig fake_device_config;
+    rt::FakeDeviceQuirks fake_device_quirks;
+    rt::FakeFilesystem fake_filesystem;
+    rt::FakeLog fake_log;
+    rt::FakeLogind fake_logind{bus.address()};
+    rt::FakeWakeupService fake_wakeup_service;
+    NullTemporarySuspendInhibition null_temporary_suspend_inhibition;
+    std::shared_ptr<repowerd::EventLoopExecutor> const executor{
+        std::make_shared<repowerd::EventLoopExecutor>("Shared", 1)};
+    repowerd::LogindSessionTracker session_tracker{
+        rt::fake_shared(fake_filesystem),
+        rt::fake_shared(fake_log),
+        fake_device_quirks,
+        std::make_shared<repowerd::DBusConnectionHandle>(bus.address()),
+        nullptr};
+    repowerd::UnityScreenService service{
+        rt::fake_shared(fake_wakeup_service),
+        rt::fake_shared(fake_brightness_notification),
+        rt::fake_shared(fake_log),
+        rt::fake_shared(null_temporary_suspend_inhibition),
+        fake_device_config,
+        std::make_shared<repowerd::DBusConnectionHandle>(bus.address()),
+        executor};
     rt::UnityScreenDBusClient client{bus.address()};
+    rt::WaitCondition request_handled;
+    std::string session_of_request;
     std::vector<repowerd::HandlerRegistration> registrations;
 };
 
@@ -717,3 +779,41 @@ TEST_F(AUnityScreenService, logs_name_owner_changed_for_tracked_notification_cli
 
     EXPECT_TRUE(fake_log.contains_line({"NameOwnerChanged", client.unique_name()}));
 }
+
+TEST_F(AUnityScreenService, forwards_sender_pid_with_requests)
+{
+    bool const disable = false;
+
+    EXPECT_CALL(mock_handlers, disable_autobrightness(getpid())).Times(2);
+
+    client.request_user_auto_brightness_enable(disable);
+    client.request_user_auto_brightness_enable(disable);
+}
+
+TEST_F(AUnityScreenService, handles_pipelined_requests_from_client_in_order)
+{
+    std::vector<std::string> id_disable;
+
+    EXPECT_CALL(mock_handlers, disable_inactivity_timeout(_, getpid()))
+        .Times(3).WillRepeatedly(AppendArg0To(&id_disable));
+
+    auto reply1 = client.request_keep_display_on();
+    auto reply2 = client.request_keep_display_on();
+    auto reply3 = client.request_keep_display_on();
+
+    std::vector<std::string> const ids{
+        std::to_string(reply1.get()),
+        std::to_string(reply2.get()),
+        std::to_string(reply3.get())};
+
+    EXPECT_THAT(id_disable, ContainerEq(ids));
+}
+
+TEST_F(AUnityScreenServiceOnSharedExecutor, looks_up_session_of_client_request)
+{
+    client.request_keep_display_on().get();
+
+    request_handled.wait_for(default_timeout);
+    EXPECT_TRUE(request_handled.woken());
+    EXPECT_THAT(session_of_request, StrEq("session0"));
+}
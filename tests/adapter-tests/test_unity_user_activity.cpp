@@ -76,7 +76,9 @@ struct AUnityUserActivity : testing::Test
     testing::NiceMock<MockHandlers> mock_handlers;
 
     rt::DBusBus bus;
-    repowerd::UnityUserActivity unity_user_activity{bus.address()};
+    repowerd::UnityUserActivity unity_user_activity{
+        std::make_shared<repowerd::DBusConnectionHandle>(bus.address()),
+        nullptr};
     UnityUserActivityDBusClient client{bus.address()};
     std::vector<repowerd::HandlerRegistration> registrations;
 
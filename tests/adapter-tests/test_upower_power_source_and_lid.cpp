@@ -101,7 +101,8 @@ struct AUPowerPowerSourceAndLidBase : testing::Test
         rt::fake_shared(fake_log),
         rt::fake_shared(mock_temporary_suspend_inhibition),
         fake_device_config,
-        bus.address()};
+        std::make_shared<repowerd::DBusConnectionHandle>(bus.address()),
+        nullptr};
     rt::FakeUPower fake_upower{bus.address()};
     std::vector<repowerd::HandlerRegistration> registrations;
 
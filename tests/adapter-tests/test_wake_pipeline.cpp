@@ -0,0 +1,160 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "src/adapters/wake_pipeline.h"
+
+#include "fake_chrono.h"
+#include "fake_log.h"
+#include "fake_shared.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace rt = repowerd::test;
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+struct AWakePipeline : Test
+{
+    std::chrono::milliseconds const stage_deadline{300};
+    rt::FakeChrono fake_chrono;
+    rt::FakeLog fake_log;
+    repowerd::WakePipeline wake_pipeline{
+        rt::fake_shared(fake_chrono),
+        rt::fake_shared(fake_log),
+        stage_deadline};
+};
+
+}
+
+TEST_F(AWakePipeline, has_no_pending_stages_before_a_wake_starts)
+{
+    EXPECT_FALSE(wake_pipeline.is_stage_pending(repowerd::WakeStage::panel_on));
+}
+
+TEST_F(AWakePipeline, has_pending_stages_until_they_complete)
+{
+    wake_pipeline.start_wake();
+
+    EXPECT_FALSE(wake_pipeline.is_stage_pending(repowerd::WakeStage::panel_on_requested));
+    EXPECT_TRUE(wake_pipeline.is_stage_pending(repowerd::WakeStage::panel_on));
+
+    wake_pipeline.complete_stage(repowerd::WakeStage::panel_on);
+
+    EXPECT_FALSE(wake_pipeline.is_stage_pending(repowerd::WakeStage::panel_on));
+}
+
+TEST_F(AWakePipeline, records_stage_times_relative_to_wake_start)
+{
+    wake_pipeline.start_wake();
+    fake_chrono.sleep_for(30ms);
+    wake_pipeline.complete_stage(repowerd::WakeStage::panel_on);
+    fake_chrono.sleep_for(5ms);
+    wake_pipeline.complete_stage(repowerd::WakeStage::backlight_ramp_started);
+
+    auto const times = wake_pipeline.last_wake_stage_times();
+
+    auto const time_of =
+        [&] (repowerd::WakeStage stage) { return times[static_cast<size_t>(stage)]; };
+
+    EXPECT_THAT(time_of(repowerd::WakeStage::panel_on_requested), Eq(0ms));
+    EXPECT_THAT(time_of(repowerd::WakeStage::panel_on), Eq(30ms));
+    EXPECT_THAT(time_of(repowerd::WakeStage::backlight_ramp_started), Eq(35ms));
+    EXPECT_THAT(time_of(repowerd::WakeStage::interactive_mode_enabled), Lt(0ms));
+}
+
+TEST_F(AWakePipeline, keeps_first_completion_time_of_stage)
+{
+    wake_pipeline.start_wake();
+    fake_chrono.sleep_for(10ms);
+    wake_pipeline.complete_stage(repowerd::WakeStage::panel_on);
+    fake_chrono.sleep_for(10ms);
+    wake_pipeline.complete_stage(repowerd::WakeStage::panel_on);
+
+    auto const times = wake_pipeline.last_wake_stage_times();
+
+    EXPECT_THAT(times[static_cast<size_t>(repowerd::WakeStage::panel_on)], Eq(10ms));
+}
+
+TEST_F(AWakePipeline, counts_time_until_stage_deadline_from_wake_start)
+{
+    wake_pipeline.start_wake();
+    EXPECT_THAT(wake_pipeline.time_until_stage_deadline(), Eq(stage_deadline));
+
+    fake_chrono.sleep_for(100ms);
+    EXPECT_THAT(wake_pipeline.time_until_stage_deadline(), Eq(stage_deadline - 100ms));
+
+    fake_chrono.sleep_for(stage_deadline);
+    EXPECT_THAT(wake_pipeline.time_until_stage_deadline(), Eq(0ms));
+}
+
+TEST_F(AWakePipeline, calls_stage_handlers_once_when_stage_completes)
+{
+    int num_panel_on_calls = 0;
+    int num_backlight_calls = 0;
+
+    auto const panel_registration = wake_pipeline.register_stage_handler(
+        repowerd::WakeStage::panel_on, [&] { ++num_panel_on_calls; });
+    auto const backlight_registration = wake_pipeline.register_stage_handler(
+        repowerd::WakeStage::backlight_ramp_started, [&] { ++num_backlight_calls; });
+
+    wake_pipeline.start_wake();
+    wake_pipeline.complete_stage(repowerd::WakeStage::panel_on);
+    wake_pipeline.complete_stage(repowerd::WakeStage::panel_on);
+
+    EXPECT_THAT(num_panel_on_calls, Eq(1));
+    EXPECT_THAT(num_backlight_calls, Eq(0));
+}
+
+TEST_F(AWakePipeline, ignores_stage_completions_outside_of_wake)
+{
+    int num_calls = 0;
+
+    auto const registration = wake_pipeline.register_stage_handler(
+        repowerd::WakeStage::panel_on, [&] { ++num_calls; });
+
+    wake_pipeline.complete_stage(repowerd::WakeStage::panel_on);
+
+    EXPECT_THAT(num_calls, Eq(0));
+}
+
+TEST_F(AWakePipeline, does_not_call_unregistered_stage_handlers)
+{
+    int num_calls = 0;
+
+    {
+        auto const registration = wake_pipeline.register_stage_handler(
+            repowerd::WakeStage::panel_on, [&] { ++num_calls; });
+    }
+
+    wake_pipeline.start_wake();
+    wake_pipeline.complete_stage(repowerd::WakeStage::panel_on);
+
+    EXPECT_THAT(num_calls, Eq(0));
+}
+
+TEST_F(AWakePipeline, logs_stage_completion)
+{
+    wake_pipeline.start_wake();
+    wake_pipeline.complete_stage(repowerd::WakeStage::panel_on);
+
+    EXPECT_TRUE(fake_log.contains_line({"panel_on", "after"}));
+}
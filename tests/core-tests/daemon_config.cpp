@@ -18,6 +18,8 @@
 
 #include "daemon_config.h"
 #include "src/core/default_state_machine_factory.h"
+#include "src/core/dispatch_metrics.h"
+#include "src/core/suspend_metrics.h"
 
 #include "fake_display_information.h"
 #include "mock_brightness_control.h"
@@ -65,6 +67,13 @@ std::shared_ptr<repowerd::ClientSettings> rt::DaemonConfig::the_client_settings(
     return the_fake_client_settings();
 }
 
+std::shared_ptr<repowerd::DispatchMetrics> rt::DaemonConfig::the_dispatch_metrics()
+{
+    if (!dispatch_metrics)
+        dispatch_metrics = std::make_shared<DispatchMetrics>();
+    return dispatch_metrics;
+}
+
 std::shared_ptr<repowerd::DisplayPowerControl> rt::DaemonConfig::the_display_power_control()
 {
     return the_mock_display_power_control();
@@ -139,6 +148,13 @@ std::shared_ptr<repowerd::StateMachineOptions> rt::DaemonConfig::the_state_machi
     return state_machine_options;
 }
 
+std::shared_ptr<repowerd::SuspendMetrics> rt::DaemonConfig::the_suspend_metrics()
+{
+    if (!suspend_metrics)
+        suspend_metrics = std::make_shared<SuspendMetrics>();
+    return suspend_metrics;
+}
+
 std::shared_ptr<repowerd::SystemPowerControl> rt::DaemonConfig::the_system_power_control()
 {
     return the_fake_system_power_control();
@@ -159,6 +175,11 @@ std::shared_ptr<repowerd::VoiceCallService> rt::DaemonConfig::the_voice_call_ser
     return the_fake_voice_call_service();
 }
 
+void rt::DaemonConfig::run_startup(std::function<void()> const& startup)
+{
+    startup();
+}
+
 std::shared_ptr<rt::FakeDisplayInformation> rt::DaemonConfig::the_fake_display_information()
 {
     if (!fake_display_information)
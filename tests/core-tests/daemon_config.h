@@ -55,6 +55,7 @@ public:
     std::shared_ptr<BrightnessControl> the_brightness_control() override;
     std::shared_ptr<ClientRequests> the_client_requests() override;
     std::shared_ptr<ClientSettings> the_client_settings() override;
+    std::shared_ptr<DispatchMetrics> the_dispatch_metrics() override;
     std::shared_ptr<DisplayPowerControl> the_display_power_control() override;
     std::shared_ptr<DisplayPowerEventSink> the_display_power_event_sink() override;
     std::shared_ptr<Lid> the_lid() override;
@@ -69,11 +70,14 @@ public:
     std::shared_ptr<SessionTracker> the_session_tracker() override;
     std::shared_ptr<StateMachineFactory> the_state_machine_factory() override;
     std::shared_ptr<StateMachineOptions> the_state_machine_options() override;
+    std::shared_ptr<SuspendMetrics> the_suspend_metrics() override;
     std::shared_ptr<SystemPowerControl> the_system_power_control() override;
     std::shared_ptr<Timer> the_timer() override;
     std::shared_ptr<UserActivity> the_user_activity() override;
     std::shared_ptr<VoiceCallService> the_voice_call_service() override;
 
+    void run_startup(std::function<void()> const& startup) override;
+
     std::shared_ptr<FakeDisplayInformation> the_fake_display_information();
     std::shared_ptr<testing::NiceMock<MockBrightnessControl>> the_mock_brightness_control();
     std::shared_ptr<FakeClientRequests> the_fake_client_requests();
@@ -96,8 +100,10 @@ public:
     std::shared_ptr<FakeVoiceCallService> the_fake_voice_call_service();
 
 private:
+    std::shared_ptr<DispatchMetrics> dispatch_metrics;
     std::shared_ptr<StateMachineFactory> state_machine_factory;
     std::shared_ptr<StateMachineOptions> state_machine_options;
+    std::shared_ptr<SuspendMetrics> suspend_metrics;
 
     std::shared_ptr<FakeDisplayInformation> fake_display_information;
     std::shared_ptr<testing::NiceMock<MockBrightnessControl>> mock_brightness_control;
@@ -25,7 +25,8 @@ namespace rt = repowerd::test;
 rt::FakeTimer::FakeTimer()
     : handler{[](AlarmId){}},
       next_alarm_id{1},
-      now_ms{0}
+      now_ms{0},
+      num_scheduled_alarms_{0}
 {
 }
 
@@ -51,6 +52,7 @@ repowerd::AlarmId rt::FakeTimer::schedule_alarm_in(std::chrono::milliseconds t)
     std::lock_guard<std::mutex> lock{mutex};
 
     alarms.push_back({next_alarm_id, now_ms + t});
+    ++num_scheduled_alarms_;
 
     return next_alarm_id++;
 }
@@ -67,6 +69,12 @@ void rt::FakeTimer::cancel_alarm(AlarmId id)
         alarms.end());
 }
 
+size_t rt::FakeTimer::num_scheduled_alarms()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return num_scheduled_alarms_;
+}
+
 std::chrono::steady_clock::time_point rt::FakeTimer::now()
 {
     std::lock_guard<std::mutex> lock{mutex};
@@ -41,6 +41,7 @@ public:
     std::chrono::steady_clock::time_point now() override;
 
     void advance_by(std::chrono::milliseconds advance);
+    size_t num_scheduled_alarms();
 
     struct Mock
     {
@@ -61,6 +62,7 @@ private:
     AlarmHandler handler;
     AlarmId next_alarm_id;
     std::chrono::milliseconds now_ms;
+    size_t num_scheduled_alarms_;
     std::vector<Alarm> alarms;
 };
 
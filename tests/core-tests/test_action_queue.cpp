@@ -0,0 +1,218 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "src/core/action_queue.h"
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+using namespace testing;
+
+namespace
+{
+
+struct AnActionQueue : Test
+{
+    std::vector<int> dequeue_all(size_t n)
+    {
+        std::vector<int> ret;
+        for (size_t i = 0; i < n; ++i)
+            queue.dequeue()();
+        ret.swap(dequeued);
+        return ret;
+    }
+
+    repowerd::Action record(int i)
+    {
+        return [this, i] { dequeued.push_back(i); };
+    }
+
+    size_t const capacity{4};
+    repowerd::ActionQueue queue{capacity};
+    std::vector<int> dequeued;
+};
+
+}
+
+TEST(AnAction, invokes_target)
+{
+    int calls = 0;
+    repowerd::Action action{[&calls] { ++calls; }};
+
+    action();
+
+    EXPECT_THAT(calls, Eq(1));
+}
+
+TEST(AnAction, supports_move_only_targets)
+{
+    auto value = std::make_unique<int>(5);
+    int result = 0;
+
+    repowerd::Action action{[&result, value = std::move(value)] { result = *value; }};
+    repowerd::Action moved{std::move(action)};
+
+    EXPECT_FALSE(action);
+    EXPECT_TRUE(moved);
+
+    moved();
+
+    EXPECT_THAT(result, Eq(5));
+}
+
+TEST(AnAction, destroys_target_exactly_once)
+{
+    auto const token = std::make_shared<int>(0);
+
+    {
+        repowerd::Action action{[token] {}};
+        repowerd::Action moved;
+        moved = std::move(action);
+        EXPECT_THAT(token.use_count(), Eq(2));
+    }
+
+    EXPECT_THAT(token.use_count(), Eq(1));
+}
+
+TEST_F(AnActionQueue, dequeues_actions_in_fifo_order)
+{
+    for (int i = 0; i < 3; ++i)
+        queue.enqueue(record(i));
+
+    EXPECT_THAT(dequeue_all(3), ElementsAre(0, 1, 2));
+}
+
+TEST_F(AnActionQueue, dequeues_priority_actions_first)
+{
+    queue.enqueue(record(0));
+    queue.enqueue(record(1));
+    queue.enqueue_priority(record(2));
+
+    EXPECT_THAT(dequeue_all(3), ElementsAre(2, 0, 1));
+}
+
+TEST_F(AnActionQueue, keeps_fifo_order_and_counts_overflows_when_full)
+{
+    int const num_actions = capacity + 3;
+
+    for (int i = 0; i < num_actions; ++i)
+        queue.enqueue(record(i));
+
+    EXPECT_THAT(queue.overflows(), Eq(3u));
+    EXPECT_THAT(dequeue_all(num_actions), ElementsAre(0, 1, 2, 3, 4, 5, 6));
+}
+
+TEST_F(AnActionQueue, does_not_count_overflows_when_consumer_keeps_up)
+{
+    for (int i = 0; i < 100; ++i)
+    {
+        queue.enqueue(record(i));
+        queue.dequeue()();
+    }
+
+    EXPECT_THAT(queue.overflows(), Eq(0u));
+}
+
+TEST_F(AnActionQueue, preserves_per_producer_order_with_concurrent_producers)
+{
+    int const num_producers = 4;
+    int const actions_per_producer = 1000;
+    std::vector<std::vector<int>> per_producer(num_producers);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < num_producers; ++p)
+    {
+        producers.emplace_back(
+            [&, p]
+            {
+                for (int i = 0; i < actions_per_producer; ++i)
+                    queue.enqueue([&, p, i] { per_producer[p].push_back(i); });
+            });
+    }
+
+    for (int i = 0; i < num_producers * actions_per_producer; ++i)
+        queue.dequeue()();
+
+    for (auto& t : producers)
+        t.join();
+
+    for (auto const& v : per_producer)
+    {
+        ASSERT_THAT(v.size(), Eq(static_cast<size_t>(actions_per_producer)));
+        EXPECT_TRUE(std::is_sorted(v.begin(), v.end()));
+    }
+}
+
+TEST_F(AnActionQueue, drops_coalesced_actions_with_same_value_while_pending)
+{
+    repowerd::ActionQueue::CoalescingSlot slot;
+    auto const handler = [this] (int value) { dequeued.push_back(value); };
+
+    queue.enqueue_coalesced(slot, 1, handler);
+    queue.enqueue_coalesced(slot, 1, handler);
+    queue.enqueue_coalesced(slot, 2, handler);
+    queue.enqueue_coalesced(slot, 2, handler);
+
+    EXPECT_THAT(queue.coalesced(), Eq(2u));
+    EXPECT_THAT(dequeue_all(2), ElementsAre(1, 2));
+}
+
+TEST_F(AnActionQueue, does_not_coalesce_actions_separated_by_other_actions)
+{
+    repowerd::ActionQueue::CoalescingSlot slot;
+    auto const handler = [this] (int value) { dequeued.push_back(value); };
+
+    queue.enqueue_coalesced(slot, 1, handler);
+    queue.enqueue(record(0));
+    queue.enqueue_coalesced(slot, 1, handler);
+
+    EXPECT_THAT(queue.coalesced(), Eq(0u));
+    EXPECT_THAT(dequeue_all(3), ElementsAre(1, 0, 1));
+}
+
+TEST_F(AnActionQueue, does_not_coalesce_into_actions_already_dequeued)
+{
+    repowerd::ActionQueue::CoalescingSlot slot;
+    auto const handler = [this] (int value) { dequeued.push_back(value); };
+
+    queue.enqueue_coalesced(slot, 1, handler);
+    queue.dequeue()();
+    queue.enqueue_coalesced(slot, 1, handler);
+    queue.dequeue()();
+
+    EXPECT_THAT(queue.coalesced(), Eq(0u));
+    EXPECT_THAT(dequeued, ElementsAre(1, 1));
+}
+
+TEST_F(AnActionQueue, reports_number_of_pending_actions)
+{
+    queue.enqueue(record(0));
+    queue.enqueue_priority(record(1));
+    for (int i = 2; i < 7; ++i)
+        queue.enqueue(record(i));
+
+    EXPECT_THAT(queue.size(), Eq(7u));
+
+    dequeue_all(3);
+
+    EXPECT_THAT(queue.size(), Eq(4u));
+}
@@ -33,9 +33,11 @@
 #include "mock_brightness_control.h"
 
 #include "src/core/daemon.h"
+#include "src/core/dispatch_metrics.h"
 #include "src/core/state_machine.h"
 #include "src/core/state_machine_factory.h"
 
+#include <future>
 #include <thread>
 
 #include <gmock/gmock.h>
@@ -253,6 +255,23 @@ struct ADaemon : testing::Test
     {
         return *config.the_mock_state_machine_factory()->sessions_activity_log;
     }
+
+    // Keep the daemon busy handling a power button press until
+    // unblock_daemon() is called, so that subsequent events stay queued
+    void block_daemon()
+    {
+        EXPECT_CALL(*config.the_mock_state_machine(), handle_power_button_press())
+            .WillOnce(InvokeWithoutArgs([this] { unblock_promise.get_future().wait(); }));
+        config.the_fake_power_button()->press();
+    }
+
+    void unblock_daemon()
+    {
+        unblock_promise.set_value();
+        daemon->flush();
+    }
+
+    std::promise<void> unblock_promise;
 };
 
 }
@@ -1146,3 +1165,150 @@ TEST_F(ADaemon, notifies_all_state_machines_of_system_disallow_suspend)
 
     config.the_fake_system_power_control()->emit_system_disallow_suspend();
 }
+
+TEST_F(ADaemon, coalesces_pending_user_activity_extending_power_state_events)
+{
+    start_daemon();
+
+    block_daemon();
+
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_user_activity_extending_power_state());
+
+    for (int i = 0; i < 100; ++i)
+        config.the_fake_user_activity()->perform(repowerd::UserActivityType::extend_power_state);
+
+    unblock_daemon();
+}
+
+TEST_F(ADaemon, coalesces_pending_user_activity_changing_power_state_events)
+{
+    start_daemon();
+
+    block_daemon();
+
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_user_activity_changing_power_state());
+
+    for (int i = 0; i < 10; ++i)
+        config.the_fake_user_activity()->perform(repowerd::UserActivityType::change_power_state);
+
+    unblock_daemon();
+}
+
+TEST_F(ADaemon, coalesces_pending_proximity_events_with_the_same_state)
+{
+    start_daemon();
+
+    block_daemon();
+
+    InSequence s;
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_proximity_near());
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_proximity_far());
+
+    config.the_fake_proximity_sensor()->emit_proximity_state(repowerd::ProximityState::near);
+    config.the_fake_proximity_sensor()->emit_proximity_state(repowerd::ProximityState::near);
+    config.the_fake_proximity_sensor()->emit_proximity_state(repowerd::ProximityState::far);
+    config.the_fake_proximity_sensor()->emit_proximity_state(repowerd::ProximityState::far);
+
+    unblock_daemon();
+}
+
+TEST_F(ADaemon, coalesces_pending_power_source_change_events)
+{
+    start_daemon();
+
+    block_daemon();
+
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_power_source_change());
+
+    for (int i = 0; i < 10; ++i)
+        config.the_fake_power_source()->emit_power_source_change();
+
+    unblock_daemon();
+}
+
+TEST_F(ADaemon, does_not_coalesce_events_that_are_no_longer_pending)
+{
+    start_daemon();
+
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_user_activity_extending_power_state())
+        .Times(3);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        config.the_fake_user_activity()->perform(repowerd::UserActivityType::extend_power_state);
+        flush_daemon();
+    }
+}
+
+TEST_F(ADaemon, does_not_coalesce_events_that_are_not_coalescable)
+{
+    start_daemon();
+
+    block_daemon();
+
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_power_button_release()).Times(3);
+
+    for (int i = 0; i < 3; ++i)
+        config.the_fake_power_button()->release();
+
+    unblock_daemon();
+}
+
+TEST_F(ADaemon, does_not_coalesce_events_separated_by_other_events)
+{
+    start_daemon();
+
+    block_daemon();
+
+    InSequence s;
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_user_activity_extending_power_state());
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_power_button_release());
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_user_activity_extending_power_state());
+
+    config.the_fake_user_activity()->perform(repowerd::UserActivityType::extend_power_state);
+    config.the_fake_user_activity()->perform(repowerd::UserActivityType::extend_power_state);
+    config.the_fake_power_button()->release();
+    config.the_fake_user_activity()->perform(repowerd::UserActivityType::extend_power_state);
+
+    unblock_daemon();
+}
+
+TEST_F(ADaemon, records_dispatch_metrics_per_event_kind)
+{
+    start_daemon();
+
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_power_button_press()).Times(2);
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_lid_closed());
+
+    config.the_fake_power_button()->press();
+    config.the_fake_power_button()->press();
+    config.the_fake_lid()->close();
+    flush_daemon();
+
+    auto const metrics = config.the_dispatch_metrics();
+    EXPECT_THAT(metrics->event_latencies(repowerd::DispatchEventKind::power_button).count, Eq(2u));
+    EXPECT_THAT(metrics->event_latencies(repowerd::DispatchEventKind::lid).count, Eq(1u));
+    EXPECT_THAT(metrics->event_latencies(repowerd::DispatchEventKind::proximity).count, Eq(0u));
+}
+
+TEST_F(ADaemon, records_queue_depth_and_coalesced_events)
+{
+    start_daemon();
+
+    block_daemon();
+
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_lid_closed()).Times(3);
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_power_source_change());
+
+    for (int i = 0; i < 3; ++i)
+        config.the_fake_lid()->close();
+    config.the_fake_power_source()->emit_power_source_change();
+    config.the_fake_power_source()->emit_power_source_change();
+
+    unblock_daemon();
+    flush_daemon();
+
+    auto const metrics = config.the_dispatch_metrics();
+    EXPECT_THAT(metrics->max_queue_depth(), Ge(3u));
+    EXPECT_THAT(metrics->coalesced_events(), Eq(1u));
+}
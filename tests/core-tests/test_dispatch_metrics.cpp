@@ -0,0 +1,114 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "src/core/dispatch_metrics.h"
+
+#include <gmock/gmock.h>
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+struct ADispatchMetrics : Test
+{
+    template<size_t N>
+    size_t bucket_of_single_entry(std::array<uint64_t,N> const& histogram)
+    {
+        for (size_t i = 0; i < N; ++i)
+            if (histogram[i] != 0) return i;
+        return N;
+    }
+
+    repowerd::DispatchMetrics metrics;
+};
+
+}
+
+TEST_F(ADispatchMetrics, starts_empty)
+{
+    for (size_t i = 0; i < repowerd::num_dispatch_event_kinds; ++i)
+    {
+        auto const kind = static_cast<repowerd::DispatchEventKind>(i);
+        EXPECT_THAT(metrics.event_latencies(kind).count, Eq(0u));
+    }
+
+    EXPECT_THAT(metrics.queue_depth_histogram(), Each(Eq(0u)));
+    EXPECT_THAT(metrics.max_queue_depth(), Eq(0u));
+    EXPECT_THAT(metrics.queue_overflows(), Eq(0u));
+    EXPECT_THAT(metrics.coalesced_events(), Eq(0u));
+}
+
+TEST_F(ADispatchMetrics, records_latencies_per_event_kind)
+{
+    metrics.record_dispatch(repowerd::DispatchEventKind::alarm, 1ms, 10us, 0);
+    metrics.record_dispatch(repowerd::DispatchEventKind::alarm, 1ms, 10us, 0);
+    metrics.record_dispatch(repowerd::DispatchEventKind::lid, 1ms, 10us, 0);
+
+    EXPECT_THAT(metrics.event_latencies(repowerd::DispatchEventKind::alarm).count, Eq(2u));
+    EXPECT_THAT(metrics.event_latencies(repowerd::DispatchEventKind::lid).count, Eq(1u));
+    EXPECT_THAT(metrics.event_latencies(repowerd::DispatchEventKind::proximity).count, Eq(0u));
+}
+
+TEST_F(ADispatchMetrics, places_latencies_in_bucket_with_inclusive_upper_limit)
+{
+    metrics.record_dispatch(repowerd::DispatchEventKind::alarm, 1ms, 1001us, 0);
+
+    auto const& limits = repowerd::DispatchMetrics::latency_bucket_limits_usec();
+    auto const latencies = metrics.event_latencies(repowerd::DispatchEventKind::alarm);
+
+    auto const wait_bucket = bucket_of_single_entry(latencies.queue_wait);
+    auto const handling_bucket = bucket_of_single_entry(latencies.handling);
+
+    EXPECT_THAT(limits[wait_bucket], Eq(1000u));
+    EXPECT_THAT(limits[handling_bucket], Eq(2000u));
+}
+
+TEST_F(ADispatchMetrics, places_very_long_latencies_in_last_bucket)
+{
+    metrics.record_dispatch(repowerd::DispatchEventKind::alarm, 1h, 1h, 0);
+
+    auto const latencies = metrics.event_latencies(repowerd::DispatchEventKind::alarm);
+
+    EXPECT_THAT(latencies.queue_wait.back(), Eq(1u));
+    EXPECT_THAT(latencies.handling.back(), Eq(1u));
+}
+
+TEST_F(ADispatchMetrics, records_queue_depth_histogram_and_maximum)
+{
+    metrics.record_dispatch(repowerd::DispatchEventKind::alarm, 0ms, 0ms, 0);
+    metrics.record_dispatch(repowerd::DispatchEventKind::alarm, 0ms, 0ms, 3);
+    metrics.record_dispatch(repowerd::DispatchEventKind::alarm, 0ms, 0ms, 1);
+
+    auto const histogram = metrics.queue_depth_histogram();
+
+    EXPECT_THAT(histogram[0], Eq(1u));
+    EXPECT_THAT(histogram[1], Eq(1u));
+    EXPECT_THAT(histogram[3], Eq(1u));
+    EXPECT_THAT(metrics.max_queue_depth(), Eq(3u));
+}
+
+TEST_F(ADispatchMetrics, reports_latest_queue_counters)
+{
+    metrics.record_queue_counters(1, 2);
+    metrics.record_queue_counters(3, 5);
+
+    EXPECT_THAT(metrics.queue_overflows(), Eq(3u));
+    EXPECT_THAT(metrics.coalesced_events(), Eq(5u));
+}
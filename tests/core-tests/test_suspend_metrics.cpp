@@ -0,0 +1,144 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "src/core/suspend_metrics.h"
+
+#include <gmock/gmock.h>
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+struct ASuspendMetrics : Test
+{
+    repowerd::SuspendMetrics::TimePoint at(std::chrono::milliseconds ms)
+    {
+        return repowerd::SuspendMetrics::TimePoint{ms};
+    }
+
+    void run_cycle(std::chrono::milliseconds start)
+    {
+        metrics.record_suspend_decision(at(start));
+        metrics.record_suspend_entry(at(start + 10ms));
+        metrics.record_resume(at(start + 100ms));
+        metrics.record_first_event_after_resume(at(start + 101ms));
+        metrics.record_display_on(at(start + 150ms));
+    }
+
+    repowerd::SuspendMetrics metrics;
+    uint64_t const not_observed = repowerd::SuspendMetrics::not_observed;
+};
+
+}
+
+TEST_F(ASuspendMetrics, starts_empty)
+{
+    EXPECT_THAT(metrics.recent_cycles(), IsEmpty());
+    EXPECT_THAT(metrics.total_cycles(), Eq(0u));
+}
+
+TEST_F(ASuspendMetrics, records_durations_of_cycle)
+{
+    run_cycle(1000ms);
+
+    auto const cycles = metrics.recent_cycles();
+    ASSERT_THAT(cycles.size(), Eq(1u));
+    EXPECT_THAT(cycles[0].decision_to_suspend_usec, Eq(10000u));
+    EXPECT_THAT(cycles[0].resume_to_first_event_usec, Eq(1000u));
+    EXPECT_THAT(cycles[0].resume_to_display_on_usec, Eq(50000u));
+}
+
+TEST_F(ASuspendMetrics, measures_decision_to_suspend_from_latest_decision)
+{
+    metrics.record_suspend_decision(at(0ms));
+    metrics.record_suspend_decision(at(30ms));
+    metrics.record_suspend_entry(at(50ms));
+
+    auto const cycles = metrics.recent_cycles();
+    ASSERT_THAT(cycles.size(), Eq(1u));
+    EXPECT_THAT(cycles[0].decision_to_suspend_usec, Eq(20000u));
+}
+
+TEST_F(ASuspendMetrics, marks_durations_not_yet_observed)
+{
+    metrics.record_suspend_entry(at(0ms));
+    metrics.record_resume(at(100ms));
+
+    auto const cycles = metrics.recent_cycles();
+    ASSERT_THAT(cycles.size(), Eq(1u));
+    EXPECT_THAT(cycles[0].decision_to_suspend_usec, Eq(not_observed));
+    EXPECT_THAT(cycles[0].resume_to_first_event_usec, Eq(not_observed));
+    EXPECT_THAT(cycles[0].resume_to_display_on_usec, Eq(not_observed));
+}
+
+TEST_F(ASuspendMetrics, starts_cycle_on_resume_without_suspend_entry)
+{
+    run_cycle(0ms);
+
+    metrics.record_resume(at(1000ms));
+    metrics.record_display_on(at(1020ms));
+
+    auto const cycles = metrics.recent_cycles();
+    ASSERT_THAT(cycles.size(), Eq(2u));
+    EXPECT_THAT(cycles[1].decision_to_suspend_usec, Eq(not_observed));
+    EXPECT_THAT(cycles[1].resume_to_display_on_usec, Eq(20000u));
+}
+
+TEST_F(ASuspendMetrics, records_only_first_event_and_display_on_after_resume)
+{
+    run_cycle(0ms);
+
+    metrics.record_first_event_after_resume(at(500ms));
+    metrics.record_display_on(at(500ms));
+
+    auto const cycles = metrics.recent_cycles();
+    ASSERT_THAT(cycles.size(), Eq(1u));
+    EXPECT_THAT(cycles[0].resume_to_first_event_usec, Eq(1000u));
+    EXPECT_THAT(cycles[0].resume_to_display_on_usec, Eq(50000u));
+}
+
+TEST_F(ASuspendMetrics, ignores_events_and_display_on_before_resume)
+{
+    metrics.record_suspend_entry(at(0ms));
+    metrics.record_first_event_after_resume(at(10ms));
+    metrics.record_display_on(at(10ms));
+
+    auto const cycles = metrics.recent_cycles();
+    ASSERT_THAT(cycles.size(), Eq(1u));
+    EXPECT_THAT(cycles[0].resume_to_first_event_usec, Eq(not_observed));
+    EXPECT_THAT(cycles[0].resume_to_display_on_usec, Eq(not_observed));
+}
+
+TEST_F(ASuspendMetrics, keeps_only_most_recent_cycles_oldest_first)
+{
+    auto const num_cycles = repowerd::SuspendMetrics::max_cycles + 3;
+
+    for (size_t i = 0; i < num_cycles; ++i)
+    {
+        metrics.record_suspend_decision(at(0ms));
+        metrics.record_suspend_entry(at(std::chrono::milliseconds{i}));
+    }
+
+    auto const cycles = metrics.recent_cycles();
+    ASSERT_THAT(cycles.size(), Eq(repowerd::SuspendMetrics::max_cycles));
+    EXPECT_THAT(cycles.front().decision_to_suspend_usec, Eq(3000u));
+    EXPECT_THAT(cycles.back().decision_to_suspend_usec, Eq((num_cycles - 1) * 1000));
+    EXPECT_THAT(metrics.total_cycles(), Eq(num_cycles));
+}
@@ -18,6 +18,9 @@
 
 #include "acceptance_test.h"
 #include "fake_system_power_control.h"
+#include "fake_timer.h"
+
+#include "src/core/suspend_metrics.h"
 
 #include <gtest/gtest.h>
 
@@ -195,3 +198,17 @@ TEST_F(ASystemPowerControl, resume_is_logged)
 
     EXPECT_TRUE(log_contains_line({"system_resume"}));
 }
+
+TEST_F(ASystemPowerControl, records_time_from_resume_to_handling_resume)
+{
+    auto const suspend_metrics = config.the_suspend_metrics();
+
+    suspend_metrics->record_resume(config.the_fake_timer()->now());
+    advance_time_by(50ms);
+
+    emit_system_resume();
+
+    auto const cycles = suspend_metrics->recent_cycles();
+    ASSERT_THAT(cycles.size(), Eq(1u));
+    EXPECT_THAT(cycles[0].resume_to_first_event_usec, Eq(50000u));
+}
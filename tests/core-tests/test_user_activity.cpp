@@ -17,14 +17,17 @@
  */
 
 #include "acceptance_test.h"
+#include "fake_timer.h"
 
 #include <gtest/gtest.h>
+#include <gmock/gmock.h>
 
 #include <chrono>
 
 namespace rt = repowerd::test;
 
 using namespace std::chrono_literals;
+using namespace testing;
 
 namespace
 {
@@ -225,3 +228,26 @@ TEST_F(AUserActivity, not_performed_turning_off_display_is_logged)
 
     EXPECT_TRUE(log_contains_line({"display_off"}));
 }
+
+TEST_F(AUserActivity, extending_power_state_repeatedly_does_not_reschedule_alarms)
+{
+    turn_on_display();
+
+    auto const num_scheduled_alarms = config.the_fake_timer()->num_scheduled_alarms();
+
+    for (int i = 0; i < 10; ++i)
+    {
+        advance_time_by(1s);
+        perform_user_activity_extending_power_state();
+    }
+
+    EXPECT_THAT(config.the_fake_timer()->num_scheduled_alarms(),
+                Eq(num_scheduled_alarms));
+
+    expect_no_display_power_change();
+    advance_time_by(user_inactivity_normal_display_off_timeout - 1ms);
+    verify_expectations();
+
+    expect_display_turns_off();
+    advance_time_by(1ms);
+}